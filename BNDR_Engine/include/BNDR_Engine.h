@@ -23,4 +23,11 @@ SOFTWARE.*/
 #pragma once
 
 #include "window_render/timers.h"
+#include "window_render/frame_stats.h"
+#include "scheduling/tasks.h"
+#include "profiling/gpu_profiler.h"
+#include "profiling/flight_recorder.h"
+#include "window_render/resolution_scaler.h"
 #include "graphics_surfaces/frame_rects.h";
+#include "graphics_surfaces/update_thread.h"
+#include "graphics_surfaces/sprite_batch.h"
@@ -0,0 +1,74 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	// the 64 bit FNV-1a offset basis (the hash of no data)
+	const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ULL;
+	// the 64 bit FNV-1a prime
+	const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+	// hash a block of memory with 64 bit FNV-1a
+	// pass the result of a previous call as the seed to hash several blocks as if they were one
+	inline unsigned long long hashBytes(const void* data, size_t size, unsigned long long seed = FNV_OFFSET_BASIS) {
+
+		const uchar* bytes = static_cast<const uchar*>(data);
+		unsigned long long hash = seed;
+		for (size_t i = 0; i < size; i++) {
+
+			hash ^= (unsigned long long)bytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	// hash a string including its length so that ("ab", "c") and ("a", "bc") hash differently when chained
+	inline unsigned long long hashString(const std::string& text, unsigned long long seed = FNV_OFFSET_BASIS) {
+
+		unsigned long long length = (unsigned long long)text.size();
+		seed = hashBytes(&length, sizeof(length), seed);
+		return hashBytes(text.data(), text.size(), seed);
+	}
+
+	// hash a plain value (ints, floats, etc.) by its bytes
+	template <class T>
+	inline unsigned long long hashValue(const T& value, unsigned long long seed = FNV_OFFSET_BASIS) {
+
+		return hashBytes(&value, sizeof(T), seed);
+	}
+
+	// format a 64 bit hash as 16 lowercase hex digits (i.e. for file names)
+	inline std::string hashToHex(unsigned long long hash) {
+
+		static const char digits[] = "0123456789abcdef";
+		std::string hex(16, '0');
+		for (int i = 15; i >= 0; i--) {
+
+			hex[i] = digits[hash & 0xF];
+			hash >>= 4;
+		}
+		return hex;
+	}
+}
@@ -39,6 +39,9 @@ namespace bndr {
 		// rasterizes the frame to the screen
 		// its only purpose is to draw the frame and return
 		virtual void render() = 0;
+		// records the frame into a render list instead of drawing it (used when updating on a bndr::UpdateThread)
+		// frames that should be drawn from a separate update thread must override this
+		virtual void record(RenderList& list) {}
 		// redefines the translation of the frame
 		virtual void translate(float x, float y) = 0;
 		// adds to the current translation
@@ -102,6 +105,7 @@ namespace bndr {
 		FrameRect(FrameRect&&) = delete;
 		FrameRect& operator=(const FrameRect&) = delete;
 		inline void render() { texRect->render(); }
+		inline void record(RenderList& list) { texRect->record(list); }
 		virtual void update(float deltaTime);
 		// redefines the translation of the frame
 		virtual void translate(float x, float y);
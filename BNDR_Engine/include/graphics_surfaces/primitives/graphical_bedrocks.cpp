@@ -22,6 +22,7 @@ SOFTWARE.*/
 
 #include <pch.h>
 #include "graphical_bedrocks.h"
+#include "../../profiling/gpu_profiler.h"
 
 namespace bndr {
 
@@ -33,11 +34,13 @@ namespace bndr {
 	Vec2<float> PixelSurface::windowInitialSize;
 	// the window's aspect ratio
 	float PixelSurface::windowAspect;
+	// whether the GPU updates are deferred to the render thread
+	bool PixelSurface::deferGPUUpdates = false;
 
 	PixelSurface::~PixelSurface() {
 
-		// delete vertex array, color buffer, and matrices
-		delete program;
+		// give back the shared program and delete vertex array, color buffer, and matrices
+		Program::release(program);
 		delete va;
 		delete colorBuffer;
 		delete translation;
@@ -50,17 +53,14 @@ namespace bndr {
 		// update the translation matrix in RAM
 		(*translation)[0] = xTrans;
 		(*translation)[1] = yTrans;
-		updateTranslationUniform();
-
+		modelDirty = true;
 	}
 
 	void PolySurface::setRotation(float theta) {
 
 		// convert theta to radians
 		rotation = theta * (BNDR_PI / 180.0f);
-		// update the rotation
-		updateRotationUniform();
-
+		modelDirty = true;
 	}
 
 	void PolySurface::setScale(float xScale, float yScale) {
@@ -68,8 +68,7 @@ namespace bndr {
 		// update the scale matrix in RAM
 		(*scale)[0] = std::max<float>(xScale, 0.0f);
 		(*scale)[1] = std::max<float>(yScale, 0.0f);
-		updateScaleUniform();
-
+		modelDirty = true;
 	}
 
 	void PolySurface::changeTranslationBy(float xTrans, float yTrans) {
@@ -77,8 +76,7 @@ namespace bndr {
 		// update the translation matrix in RAM
 		(*translation)[0] += xTrans;
 		(*translation)[1] += yTrans;
-		updateTranslationUniform();
-
+		modelDirty = true;
 	}
 
 	void PolySurface::changeRotationBy(float theta) {
@@ -87,8 +85,7 @@ namespace bndr {
 		float rad = theta * (BNDR_PI / 180.0f);
 		// update the rotation
 		rotation += rad;
-		updateRotationUniform();
-
+		modelDirty = true;
 	}
 
 	void PolySurface::changeScaleBy(float xScale, float yScale) {
@@ -98,8 +95,7 @@ namespace bndr {
 		(*scale)[1] += yScale;
 		(*scale)[0] = std::max<float>((*scale)[0], 0.0f);
 		(*scale)[1] = std::max<float>((*scale)[1], 0.0f);
-		updateScaleUniform();
-
+		modelDirty = true;
 	}
 
 	void PolySurface::setFillColor(const RGBAData& data) {
@@ -113,12 +109,103 @@ namespace bndr {
 
 	void PolySurface::render() {
 
-		program->use();
+		BNDR_PROFILE_SCOPE("PolySurface::render");
+		BNDR_PROFILE_GPU_SCOPE("PolySurface::render");
+		// the program is shared, so the state of this surface is applied right before drawing it
+		RenderCommand command;
+		fillCommand(command);
+		// (something left over from a time GPU updates were deferred)
+		if (pendingVertexFloats > 0) {
+
+			va->updateVertexBufferData(pendingVertexData);
+			pendingVertexFloats = 0;
+		}
+		command.variant = pendingVariant;
+		pendingVariant = 0;
+		RenderList::drawCommand(command, nullptr);
+	}
+
+	void PolySurface::writeVertexData(float* data, int numFloats) {
+
+		if (deferGPUUpdates) {
 
-		// render the PolySurface
-		va->render();
+			// keep the newest data until the surface is recorded into a render list
+			std::memcpy(pendingVertexData, data, sizeof(float) * numFloats);
+			pendingVertexFloats = numFloats;
+			return;
+		}
+		va->updateVertexBufferData(data);
+	}
+
+	void PolySurface::switchVariant(uint features) {
+
+		if (deferGPUUpdates) {
+
+			// acquiring and releasing programs makes OpenGL calls, so the render thread switches with the next RenderCommand
+			pendingVariant = features;
+			return;
+		}
+		pendingVariant = 0;
+		Program* variant = ShaderVariants::acquire(features);
+		Program::release(program);
+		program = variant;
+		// the handles of the new program are resolved when it is first drawn
+		uniforms.generation = 0;
+	}
+
+	void PolySurface::fillCommand(RenderCommand& command) const {
+
+		command.flags = 0;
+		command.vertexFloats = 0;
+		command.variant = 0;
+		// only the address, the render thread reads the program when it draws the command
+		command.program = &program;
+		command.uniforms = &uniforms;
+		command.va = va;
+		// the rotation point lives in GraphicsEntity, so a change of it is noticed by comparing
+		const float* point = getRotationPoint();
+		float centerX = (point != nullptr) ? point[0] : 0.0f;
+		float centerY = (point != nullptr) ? point[1] : 0.0f;
+		if (modelDirty || centerX != modelCenter[0] || centerY != modelCenter[1]) {
+
+			composeModelMatrix(centerX, centerY);
+		}
+		std::memcpy(command.model, modelMatrix, sizeof(modelMatrix));
+		// only the single color surfaces store their color in a uniform, the others store it per vertex
+		if (usesColorUniform()) {
 
-		program->unuse();
+			std::memcpy(command.color, colorBuffer, sizeof(float) * 4);
+			command.flags |= RENDER_COLOR_UNIFORM;
+		}
+	}
+
+	void PolySurface::composeModelMatrix(float centerX, float centerY) const {
+
+		// p' = R(S p - c) + c + t, so the linear part is R S and the offset is c - R c + t
+		float c = cosf(rotation);
+		float s = sinf(rotation);
+		float matrix[9] = {
+			c * (*scale)[0], -s * (*scale)[1], centerX - (c * centerX - s * centerY) + (*translation)[0],
+			s * (*scale)[0], c * (*scale)[1], centerY - (s * centerX + c * centerY) + (*translation)[1],
+			0.0f, 0.0f, 1.0f
+		};
+		std::memcpy(modelMatrix, matrix, sizeof(matrix));
+		modelCenter[0] = centerX;
+		modelCenter[1] = centerY;
+		modelDirty = false;
+	}
+
+	void PolySurface::record(RenderList& list) {
+
+		RenderCommand& command = list.add();
+		fillCommand(command);
+		if (pendingVertexFloats > 0) {
+
+			list.attachVertexData(command, pendingVertexData, pendingVertexFloats);
+			pendingVertexFloats = 0;
+		}
+		command.variant = pendingVariant;
+		pendingVariant = 0;
 	}
 
 	BasicRect::BasicRect(float x, float y, float width, float height, const RGBAData& color, int colorBufferSize, bool super)
@@ -225,7 +312,7 @@ namespace bndr {
 			(*pos)[0] + (*size)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[8], colorBuffer[9], colorBuffer[10], colorBuffer[11],
 			(*pos)[0] + (*size)[0], (*pos)[1], 0.0f, colorBuffer[12], colorBuffer[13], colorBuffer[14], colorBuffer[15]
 		};
-		va->updateVertexBufferData(updatedData);
+		writeVertexData(updatedData, sizeof(updatedData) / sizeof(float));
 	}
 
 	void ColorfulRect::setFillColor(const RGBAData& data) {
@@ -300,7 +387,7 @@ namespace bndr {
 			(*vertex2)[0], (*vertex2)[1], 0.0f, colorBuffer[4], colorBuffer[5], colorBuffer[6], colorBuffer[7],
 			(*vertex3)[0], (*vertex3)[1], 0.0f, colorBuffer[8], colorBuffer[9], colorBuffer[10], colorBuffer[11]
 		};
-		va->updateVertexBufferData(updatedData);
+		writeVertexData(updatedData, sizeof(updatedData) / sizeof(float));
 	}
 
 	void ColorfulTriangle::setFillColor(const RGBAData& data) {
@@ -323,10 +410,10 @@ namespace bndr {
 		return new VertexArray(TRIANGLES,
 			{
 
-			(*pos)[0], (*pos)[1], 0.0f, colorBuffer[0], colorBuffer[1], colorBuffer[2], colorBuffer[3], 0.0f, 0.0f,
-			(*pos)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[4], colorBuffer[5], colorBuffer[6], colorBuffer[7], 0.0f, 1.0f,
-			(*pos)[0] + (*size)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[8], colorBuffer[9], colorBuffer[10], colorBuffer[11], 1.0f, 1.0f,
-			(*pos)[0] + (*size)[0], (*pos)[1], 0.0f, colorBuffer[12], colorBuffer[13], colorBuffer[14], colorBuffer[15], 1.0f, 0.0f
+			(*pos)[0], (*pos)[1], 0.0f, colorBuffer[0], colorBuffer[1], colorBuffer[2], colorBuffer[3], texRegion[0], texRegion[1],
+			(*pos)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[4], colorBuffer[5], colorBuffer[6], colorBuffer[7], texRegion[0], texRegion[3],
+			(*pos)[0] + (*size)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[8], colorBuffer[9], colorBuffer[10], colorBuffer[11], texRegion[2], texRegion[3],
+			(*pos)[0] + (*size)[0], (*pos)[1], 0.0f, colorBuffer[12], colorBuffer[13], colorBuffer[14], colorBuffer[15], texRegion[2], texRegion[1]
 			}, 9 * sizeof(float), bndr::RGBA_COLOR_ATTRIB | bndr::TEXTURE_COORDS_ATTRIB, { 0, 1, 2, 2, 3, 0 });
 	}
 
@@ -348,6 +435,10 @@ namespace bndr {
 			convertSizeFrom0And2ToScreenSpace((*texRect.size)[1], false),
 			{}, 16, true) {
 
+		// the texture region is part of the vertex data and the white key picks the program, so both are copied before
+		// init generates them
+		std::memcpy(texRegion, texRect.texRegion, sizeof(texRegion));
+		whiteKey = texRect.whiteKey;
 		// transformations
 		(*translation) = (*texRect.translation);
 		(rotation) = (texRect.rotation);
@@ -367,31 +458,67 @@ namespace bndr {
 			tex = new Texture();
 			*tex = *texRect.tex;
 		}
+		streamedTex = texRect.streamedTex;
 		
 	}
 
 	void TexturedRect::updateColorData() {
 
 		float updatedData[36] = {
-			(*pos)[0], (*pos)[1], 0.0f, colorBuffer[0], colorBuffer[1], colorBuffer[2], colorBuffer[3], 0.0f, 0.0f,
-			(*pos)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[4], colorBuffer[5], colorBuffer[6], colorBuffer[7], 0.0f, 1.0f,
-			(*pos)[0] + (*size)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[8], colorBuffer[9], colorBuffer[10], colorBuffer[11], 1.0f, 1.0f,
-			(*pos)[0] + (*size)[0], (*pos)[1], 0.0f, colorBuffer[12], colorBuffer[13], colorBuffer[14], colorBuffer[15], 1.0f, 0.0f
+			(*pos)[0], (*pos)[1], 0.0f, colorBuffer[0], colorBuffer[1], colorBuffer[2], colorBuffer[3], texRegion[0], texRegion[1],
+			(*pos)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[4], colorBuffer[5], colorBuffer[6], colorBuffer[7], texRegion[0], texRegion[3],
+			(*pos)[0] + (*size)[0], (*pos)[1] + (*size)[1], 0.0f, colorBuffer[8], colorBuffer[9], colorBuffer[10], colorBuffer[11], texRegion[2], texRegion[3],
+			(*pos)[0] + (*size)[0], (*pos)[1], 0.0f, colorBuffer[12], colorBuffer[13], colorBuffer[14], colorBuffer[15], texRegion[2], texRegion[1]
 		};
-		va->updateVertexBufferData(updatedData);
+		writeVertexData(updatedData, sizeof(updatedData) / sizeof(float));
 	}
 
-	void TexturedRect::render() {
+	void TexturedRect::setTextureRegion(float u0, float v0, float u1, float v1) {
 
-		if (tex != nullptr) { tex->bind(); }
-		
-		program->use();
+		texRegion[0] = u0;
+		texRegion[1] = v0;
+		texRegion[2] = u1;
+		texRegion[3] = v1;
+		updateColorData();
+	}
+
+	void TexturedRect::setAtlasSprite(const TextureAtlas& atlas, const std::string& name) {
 
-		va->render();
+		const AtlasRegion& region = atlas.getRegion(name);
+		Texture* page = new Texture();
+		*page = atlas.getPage(region.page);
+		Texture* oldTex = tex;
+		changeTexture(page);
+		if (oldTex != nullptr) {
 
-		program->unuse();
+			delete oldTex;
+		}
+		setTextureRegion(region.uv[0], region.uv[1], region.uv[2], region.uv[3]);
+	}
+
+	void TexturedRect::changeTexture(const TextureHandle& handle) {
+
+		Texture* oldTex = tex;
+		changeTexture(new Texture(handle.getTexture()));
+		streamedTex = handle;
+		if (oldTex != nullptr) {
+
+			delete oldTex;
+		}
+	}
+
+	void TexturedRect::fillCommand(RenderCommand& command) const {
+
+		PolySurface::fillCommand(command);
+		if (tex != nullptr) {
+
+			command.textureID = streamedTex.isValid() ? streamedTex.getTextureID() : (uint)tex->getID();
+			command.flags |= RENDER_TEXTURED;
+		}
+	}
 
-		if (tex != nullptr) { tex->unbind(); }
+	void TexturedRect::selectVariant() {
 
+		switchVariant(getVariantFeatures((tex != nullptr) ? 1 : 0));
 	}
 }
@@ -24,7 +24,10 @@ SOFTWARE.*/
 #include <pch.h>
 #include "../window_render/window.h"
 #include "../window_render/gpu_objects/textures.h"
+#include "../window_render/gpu_objects/texture_atlas.h"
+#include "../window_render/gpu_objects/texture_streamer.h"
 #include "../window_render/gpu_objects/shaders.h"
+#include "../render_list.h"
 
 namespace bndr {
 
@@ -73,7 +76,9 @@ namespace bndr {
 	class BNDR_API PixelSurface {
 
 	protected:
-		Program* program;
+		// the shared program of the surface (while GPU updates are deferred only the render thread reads it or switches it
+		// to another variant, RenderCommands carry its address)
+		mutable Program* program;
 		// stores the vertices for the pixel surface
 		VertexArray* va;
 		// color buffer that stores colors for object
@@ -82,6 +87,9 @@ namespace bndr {
 		static Window* windowInstance;
 		static Vec2<float> windowInitialSize;
 		static float windowAspect;
+		// when true the setters only update RAM and the GPU state is applied when a RenderCommand is drawn
+		// (set while a bndr::UpdateThread is running because OpenGL may only be used on the render thread)
+		static bool deferGPUUpdates;
 		// matrices for transformations of the surface
 		Vec2<float>* translation;
 		//Vec3<float>* rotation;
@@ -99,13 +107,7 @@ namespace bndr {
 				BNDR_EXCEPTION("You have not defined the window instance for PixelSurfaces. You can do this by calling PixelSurface::setWindowInstance(&window) where window is of type bndr::Window.");
 			}
 		}
-		// update the translation uniform in the program
-		virtual void updateTranslationUniform() = 0;
-		// update the rotation uniform in the program
-		virtual void updateRotationUniform() = 0;
-		// update the scale uniform in the program
-		virtual void updateScaleUniform() = 0;
-		// update the color data in the shader program
+		// update the color data of the surface after the color buffer changed
 		virtual void updateColorData() = 0;
 		// load the color buffer into memory
 		inline void loadColorBuffer(int length) { colorBuffer = new float[length]; }
@@ -133,6 +135,10 @@ namespace bndr {
 		static Vec2<float> getWindowInitialSize() { return windowInitialSize; }
 		// get the window aspect ratio
 		static float getWindowAspect() { return PixelSurface::windowAspect; }
+		// check if GPU updates are deferred to the render thread
+		static bool isDeferringUpdates() { return PixelSurface::deferGPUUpdates; }
+		// defer GPU updates to the render thread (this is done automatically by bndr::UpdateThread)
+		static void setDeferredUpdates(bool defer) { PixelSurface::deferGPUUpdates = defer; }
 		// define the window instance for all pixel surfaces (if you don't do this nothing will draw and you will get an exception)
 		static void setWindowInstance(Window* window) {
 
@@ -155,14 +161,36 @@ namespace bndr {
 
 	protected:
 
-		// update the translation uniform in the program
-		inline virtual void updateTranslationUniform() override { program->setFloatUniformValue("translation", translation->getData(), VEC2); }
-		// update the rotation uniform in the program
-		inline virtual void updateRotationUniform() override { program->setFloatUniformValue("theta", &rotation, FLOAT); }
-		// update the scale uniform in the program
-		inline virtual void updateScaleUniform() override { program->setFloatUniformValue("scale", scale->getData(), VEC2); }
-		// update the color uniform in the program
-		inline virtual void updateColorData() override { program->setFloatUniformValue("color", colorBuffer, VEC4); }
+		// vertex data written while GPU updates were deferred (uploaded by the render thread with the next RenderCommand)
+		float pendingVertexData[36];
+		int pendingVertexFloats = 0;
+		// the features of a shader variant requested while GPU updates were deferred (0 if none, the render thread switches
+		// the program with the next RenderCommand)
+		uint pendingVariant = 0;
+		// the uniform handles of the program (resolved by the render thread once the program is ready and after every relink)
+		mutable SurfaceUniforms uniforms;
+		// the model matrix (row major mat3) and the rotation point it was composed with
+		mutable float modelMatrix[9];
+		mutable float modelCenter[2] = { 0.0f, 0.0f };
+		// set by the transform setters so the matrix is only composed again after something changed
+		mutable bool modelDirty = true;
+
+		// compose scale, rotation about the point and translation into the model matrix
+		void composeModelMatrix(float centerX, float centerY) const;
+
+		// the single fill color stays in the color buffer and is applied with the other uniforms every time the surface is drawn
+		// (the program is shared by every surface of the same kind, so nothing per surface is kept in it)
+		inline virtual void updateColorData() override {}
+		// fill in a snapshot of the surface state for drawing (shared by render() and record())
+		virtual void fillCommand(RenderCommand& command) const;
+		// write the vertex data of the surface (immediately, or with the next RenderCommand if GPU updates are deferred)
+		void writeVertexData(float* data, int numFloats);
+		// switch the program to another shader variant (immediately, or with the next RenderCommand if GPU updates are deferred)
+		void switchVariant(uint features);
+		// the point the surface rotates about in GL coordinates (nullptr means the origin)
+		inline virtual const float* getRotationPoint() const { return nullptr; }
+		// whether the fill color is stored in the "color" uniform (as opposed to per vertex)
+		inline virtual bool usesColorUniform() const { return true; }
 		// default constructor
 		PolySurface() : PixelSurface() {}
 		// colorBufferSize and numTexes are used by children of PolySurface
@@ -170,19 +198,13 @@ namespace bndr {
 
 			// generate the program for the polysurface
 			program = generateShaderProgram(hasTex ? 1 : 0);
-			// define the aspect ratio in the program
-			program->setFloatUniformValue("aspect", &windowAspect, FLOAT);
 			// load the color buffer with the correct number of colors
 			loadColorBuffer(colorBufferSize);
 			// load the vertex array data
 			va = generateVertexArray();
-			// update the transformation matrices
-			updateTranslationUniform();
-			updateRotationUniform();
-			updateScaleUniform();
 		}
 		// virtual function that will be overridden by children so that the appropriate program is created
-		inline virtual Program* generateShaderProgram(int numTexes = 0) { return Program::defaultPolygonProgram(); }
+		inline virtual Program* generateShaderProgram(int numTexes = 0) { return ShaderVariants::acquire(SHADER_COLOR_UNIFORM); }
 		// virtual function that specifies the vertex array data for the surface
 		virtual VertexArray* generateVertexArray() {
 
@@ -271,6 +293,8 @@ namespace bndr {
 		virtual void setFillColor(const RGBAData& data);
 		// render the surface to the screen
 		virtual void render() override;
+		// record a snapshot of the surface into a render list (to be drawn on the render thread)
+		virtual void record(RenderList& list);
 		// get the program id
 		inline uint getProgramID() { return program->getID(); }
 
@@ -284,12 +308,18 @@ namespace bndr {
 		Vec2<float>* center;
 		// whether the rotation is about the center
 		mutable bool aboutCenter = false;
+		// the point the entity currently rotates about
+		mutable float rotationPoint[2] = { 0.0f, 0.0f };
 		GraphicsEntity() : center(new Vec2<float>()) {}
 	public:
-		// update the center of rotation of the entity
-		inline void updateCenterUniform(Program* program) const { program->setFloatUniformValue("center", center->getData(), VEC2); aboutCenter = true; }
-		// update the center of rotation of the entity with a custom point
-		inline void updateCenterUniform(Program* program, const Vec2<float>& point) const { program->setFloatUniformValue("center", point.getData(), VEC2); aboutCenter = false; }
+		// rotate the entity about its center
+		inline void updateRotationPoint() const { updateRotationPoint(*center); aboutCenter = true; }
+		// rotate the entity about a custom point (applied when the entity is drawn)
+		inline void updateRotationPoint(const Vec2<float>& point) const {
+			rotationPoint[0] = point.getData()[0];
+			rotationPoint[1] = point.getData()[1];
+			aboutCenter = false;
+		}
 		~GraphicsEntity() { delete center; }
 	};
 
@@ -352,6 +382,7 @@ namespace bndr {
 	protected:
 
 		virtual VertexArray* generateVertexArray() override;
+		inline virtual const float* getRotationPoint() const override { return rotationPoint; }
 	public:
 
 		BasicRect() : GraphicsRect(Vec2<float>(), Vec2<float>()) {}
@@ -361,8 +392,8 @@ namespace bndr {
 		// the rotation is about the PolySurface's center by default
 		// you only need to call this if you changed the center of rotation to a different point
 		// using setRotationAboutPoint(float x, float y)
-		inline void setRotationAboutCenter() { updateCenterUniform(program); }
-		inline void setRotationAboutPoint(const Vec2<float>& point) { updateCenterUniform(program, point); }
+		inline void setRotationAboutCenter() { updateRotationPoint(); }
+		inline void setRotationAboutPoint(const Vec2<float>& point) { updateRotationPoint(point); }
 		// get the rendered size of the rect taking into account scale
 		inline Vec2<float> getSize() override { return Vec2<float>((*size)[0] * (*scale)[0], (*size)[1] * (*scale)[1]); }
 		// update the rendered center of the rect taking into account the rendered position and size
@@ -400,14 +431,15 @@ namespace bndr {
 	protected:
 
 		virtual VertexArray* generateVertexArray() override;
+		inline virtual const float* getRotationPoint() const override { return rotationPoint; }
 	public:
 
 		BasicTriangle(Vec2<float>&& coord1, Vec2<float>&& coord2, Vec2<float>&& coord3, const RGBAData& color = bndr::WHITE, int colorBufferSize = 4, bool super = false);
 		// the rotation is about the PolySurface's center by default
 		// you only need to call this if you changed the center of rotation to a different point
 		// using setRotationAboutPoint(float x, float y)
-		inline void setRotationAboutCenter() { updateCenterUniform(program); }
-		inline void setRotationAboutPoint(const Vec2<float>& point) { updateCenterUniform(program, point); }
+		inline void setRotationAboutCenter() { updateRotationPoint(); }
+		inline void setRotationAboutPoint(const Vec2<float>& point) { updateRotationPoint(point); }
 
 	};
 
@@ -421,8 +453,10 @@ namespace bndr {
 		virtual VertexArray* generateVertexArray() override;
 		// update the color data in the vertex buffer of va
 		virtual void updateColorData() override;
+		// the colors are stored per vertex
+		inline virtual bool usesColorUniform() const override { return false; }
 		// generate a program that allows for multiple colors to be used
-		inline virtual Program* generateShaderProgram(int numTexes = 0) override { return Program::multiColorPolygonProgram(); }
+		inline virtual Program* generateShaderProgram(int numTexes = 0) override { return ShaderVariants::acquire(SHADER_VERTEX_COLORS); }
 		// define the colors of the rectangle
 		void defineColors(std::vector<RGBAData>& colors);
 	public:
@@ -445,8 +479,10 @@ namespace bndr {
 		virtual VertexArray* generateVertexArray() override;
 		// update the color data in the vertex buffer of va
 		virtual void updateColorData() override;
+		// the colors are stored per vertex
+		inline virtual bool usesColorUniform() const override { return false; }
 		// generate a program that allows for multiple colors to be used
-		inline virtual Program* generateShaderProgram(int numTexes = 0) override { return Program::multiColorPolygonProgram(); }
+		inline virtual Program* generateShaderProgram(int numTexes = 0) override { return ShaderVariants::acquire(SHADER_VERTEX_COLORS); }
 		// define the colors of the triangle
 		void defineColors(std::vector<RGBAData>& colors);
 	public:
@@ -468,12 +504,27 @@ namespace bndr {
 
 		// texture to store the texture of the rect
 		Texture* tex = nullptr;
+		// set when the texture is streamed (the id is read from the handle so the rect switches from the placeholder by itself)
+		TextureHandle streamedTex;
+		// whether white texels are drawn transparent (only then does the program carry the white test)
+		bool whiteKey = true;
+		// the part of the texture drawn on the rect in texture coordinates (u0, v0, u1, v1)
+		float texRegion[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+		// switch to the shader variant matching the texture and white key (deferred to the render thread like vertex data)
+		void selectVariant();
+		// get the features of the shader variant the rect needs
+		inline uint getVariantFeatures(int numTexes) const {
+
+			return (numTexes == 1) ? (SHADER_VERTEX_COLORS | SHADER_TEXTURE | (whiteKey ? SHADER_WHITE_KEY : 0)) : SHADER_VERTEX_COLORS;
+		}
 		// textured rect will specify additional values as opposed to colorful rect
 		virtual VertexArray* generateVertexArray() override;
 		// update the color data in the vertex buffer of va
 		virtual void updateColorData() override;
 		// generate a program that allows for multiple colors to be used with multiple textures
-		inline virtual Program* generateShaderProgram(int numTexes = 0) override { return (numTexes == 1) ? Program::texPolygonProgram(1) : Program::multiColorPolygonProgram(); }
+		inline virtual Program* generateShaderProgram(int numTexes = 0) override { return ShaderVariants::acquire(getVariantFeatures(numTexes)); }
+		// adds the texture to the snapshot of the surface
+		virtual void fillCommand(RenderCommand& command) const override;
 	public:
 
 		TexturedRect(float x, float y, float width, float height, std::vector<RGBAData>&& colors = { bndr::WHITE }, Texture* newTex = nullptr, int colorBuffer = 16);
@@ -482,9 +533,16 @@ namespace bndr {
 		// move constructor is not allowed
 		// assignment operator is not allowed
 		TexturedRect& operator=(const TexturedRect&) = delete;
-		void render() override;
-		// change the texture that the textured rect will render
-		inline void changeTexture(Texture* newTex) { tex = newTex; }
+		// change the texture that the textured rect will render (switches the shader variant when the rect gains or loses its texture)
+		inline void changeTexture(Texture* newTex) { streamedTex = TextureHandle(); bool hadTex = (tex != nullptr); tex = newTex; if (hadTex != (tex != nullptr)) { selectVariant(); } }
+		// draw a streamed texture (the placeholder until it is ready)
+		void changeTexture(const TextureHandle& handle);
+		// draw white texels transparent (the default) or as they are
+		inline void setWhiteKeyTransparency(bool enable) { if (whiteKey != enable) { whiteKey = enable; selectVariant(); } }
+		// draw only part of the texture (texture coordinates, the whole texture is 0, 0, 1, 1)
+		void setTextureRegion(float u0, float v0, float u1, float v1);
+		// draw an image packed into an atlas (the rect uses the page the image is on, the atlas must be uploaded)
+		void setAtlasSprite(const TextureAtlas& atlas, const std::string& name);
 		// get the texture of the TexturedRect
 		// WARNING: Do not use this method! This is meant to be used by classes only!
 		inline Texture* getTexture() { return tex; }
@@ -0,0 +1,166 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "render_list.h"
+#include "../profiling/gpu_profiler.h"
+
+namespace bndr {
+
+	void RenderList::attachVertexData(RenderCommand& command, const float* data, int numFloats) {
+
+		command.vertexOffset = (int)vertexArena.size();
+		command.vertexFloats = numFloats;
+		vertexArena.insert(vertexArena.end(), data, data + numFloats);
+	}
+
+	void RenderList::execute() const {
+
+		BNDR_FLIGHT_SCOPE("RenderList::execute");
+		BNDR_PROFILE_GPU_SCOPE("RenderList::execute");
+		const float* arena = vertexArena.empty() ? nullptr : &vertexArena[0];
+		for (const RenderCommand& command : commands) {
+
+			RenderList::drawCommand(command, arena);
+		}
+	}
+
+	void RenderList::drawCommand(const RenderCommand& command, const float* vertexArena) {
+
+		// switch variants requested while GPU updates were deferred (acquire and release make OpenGL calls)
+		if (command.variant != 0) {
+
+			Program* variant = ShaderVariants::acquire(command.variant);
+			Program::release(*command.program);
+			*command.program = variant;
+			command.uniforms->generation = 0;
+		}
+		Program* program = *command.program;
+		// upload vertex data that changed since the last frame (even if the surface is skipped, the data is not sent again)
+		if (command.vertexFloats > 0) {
+
+			command.va->updateVertexBufferData(const_cast<float*>(vertexArena + command.vertexOffset));
+		}
+		// surfaces whose program is still compiling are not drawn until it is ready
+		if (!program->isReady()) {
+
+			return;
+		}
+		SurfaceUniforms& uniforms = *command.uniforms;
+		if (uniforms.generation != program->getGeneration()) {
+
+			uniforms.resolve(program);
+		}
+		// apply the snapshot of the surface state to its program
+		program->setUniform(uniforms.model, command.model);
+		if (command.flags & RENDER_COLOR_UNIFORM) {
+
+			program->setUniform(uniforms.color, command.color);
+		}
+
+		// nothing is unbound after the draw, GLState skips the binds the next command shares with this one
+		if (command.flags & RENDER_TEXTURED) {
+
+			// the texture stays resident on its unit while it is among the most recently drawn ones, so commands that
+			// alternate between a few textures only point the sampler at another unit
+			int unit = (command.flags & RENDER_TEXTURE_ARRAY) ? GLState::acquireTextureArrayUnit(command.textureID) :
+				GLState::acquireTextureUnit(command.textureID);
+			program->setTextureUnit(uniforms.texture, unit);
+		}
+		program->use();
+		command.va->render();
+	}
+
+	RenderList* RenderListBuffer::beginWrite() {
+
+		std::unique_lock<std::mutex> lock(mutex);
+		// the list at writeIndex is still being drawn while the other one waits to be picked up
+		condition.wait(lock, [this]() { return !ready || stopping; });
+		if (stopping) {
+
+			return nullptr;
+		}
+		lists[writeIndex].clear();
+		generations[writeIndex] = ++latestGeneration;
+		return &lists[writeIndex];
+	}
+
+	void RenderListBuffer::publish() {
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ready = true;
+		}
+		condition.notify_all();
+	}
+
+	const RenderList* RenderListBuffer::acquire() {
+
+		bool switched = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (ready) {
+
+				// the render thread is done with the old list, so the update thread may write into it next
+				readIndex = writeIndex;
+				writeIndex ^= 1;
+				ready = false;
+				switched = true;
+			}
+		}
+		if (switched) {
+
+			condition.notify_all();
+		}
+		return (readIndex == -1) ? nullptr : &lists[readIndex];
+	}
+
+	unsigned long long RenderListBuffer::getLatestGeneration() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+		return latestGeneration;
+	}
+
+	unsigned long long RenderListBuffer::getReadGeneration() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+		return (readIndex == -1) ? 0 : generations[readIndex];
+	}
+
+	void RenderListBuffer::stop() {
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+	}
+
+	void RenderListBuffer::reset() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = false;
+		ready = false;
+		readIndex = -1;
+		writeIndex = 0;
+	}
+}
@@ -0,0 +1,140 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "../window_render/gpu_objects/shaders.h"
+#include "../window_render/gpu_objects/textures.h"
+
+namespace bndr {
+
+	// flags describing what a RenderCommand has to set up before drawing
+	enum renderCommandFlags {
+
+		// the surface stores its fill color in the "color" uniform (BasicRect and BasicTriangle)
+		RENDER_COLOR_UNIFORM = 0x01,
+		// the surface samples a texture
+		RENDER_TEXTURED = 0x02,
+		// the texture is a 2D array texture (only together with RENDER_TEXTURED)
+		RENDER_TEXTURE_ARRAY = 0x04
+	};
+
+	// bndr::RenderCommand
+	// Description: Everything the render thread needs to draw one surface. A command is a snapshot of the surface
+	// state taken on the update thread, so the render thread never reads the surface itself while the update thread
+	// mutates it
+	struct RenderCommand {
+
+		// the program slot and vertex array of the surface (only ever used on the render thread)
+		Program** program;
+		// the features of a shader variant the surface switches to before drawing (0 keeps the program)
+		uint variant;
+		// the uniform handles of the surface (resolved by the render thread whenever the program was linked again)
+		SurfaceUniforms* uniforms;
+		VertexArray* va;
+		// the texture to sample (only if RENDER_TEXTURED is set, the unit is picked when the command is drawn)
+		uint textureID;
+		// the model matrix of the surface (row major mat3, see PolySurface::composeModelMatrix)
+		float model[9];
+		// the fill color (only if RENDER_COLOR_UNIFORM is set)
+		float color[4];
+		// vertex data that has to be written to the vertex buffer before drawing (i.e. changed per vertex colors)
+		// the data is stored in the vertex arena of the RenderList, vertexFloats is 0 if nothing changed
+		int vertexOffset;
+		int vertexFloats;
+		uint flags;
+	};
+
+	// bndr::RenderList
+	// Description: An immutable (once submitted) list of render commands for one frame
+	class BNDR_API RenderList {
+
+		std::vector<RenderCommand> commands;
+		// storage for the vertex data of all commands so that commands stay small and the list never reallocates per frame
+		std::vector<float> vertexArena;
+
+	public:
+
+		RenderList() {}
+		RenderList(const RenderList&) = delete;
+		RenderList& operator=(const RenderList&) = delete;
+		// add a new command to the back of the list and return it for filling in
+		inline RenderCommand& add() { commands.emplace_back(); RenderCommand& command = commands.back(); command.vertexFloats = 0; command.variant = 0; command.flags = 0; return command; }
+		// get the most recently added command
+		inline RenderCommand& back() { return commands.back(); }
+		// copy vertex data into the arena and attach it to a command
+		void attachVertexData(RenderCommand& command, const float* data, int numFloats);
+		// remove all the commands (keeps the allocated memory for the next frame)
+		inline void clear() { commands.clear(); vertexArena.clear(); }
+		// get the number of commands
+		inline int getSize() const { return (int)commands.size(); }
+		// draw every command in order (must be called on the thread that owns the OpenGL context)
+		void execute() const;
+		// draw a single command (must be called on the thread that owns the OpenGL context)
+		static void drawCommand(const RenderCommand& command, const float* vertexArena);
+	};
+
+	// bndr::RenderListBuffer
+	// Description: Double buffer of render lists shared by the update thread and the render thread. The update thread
+	// fills one list while the render thread draws the other, and the lists are handed over in lockstep so that no
+	// frame (and therefore no vertex data change) is ever dropped
+	class BNDR_API RenderListBuffer {
+
+		RenderList lists[2];
+		// the generation of every list (counts up with every beginWrite, 0 for a list that was never written)
+		unsigned long long generations[2] = { 0, 0 };
+		// the generation of the list most recently handed out by beginWrite (never reset, so it stays ordered across restarts)
+		unsigned long long latestGeneration = 0;
+		// the list the update thread writes to
+		int writeIndex = 0;
+		// the list the render thread draws (-1 until the first list is published)
+		int readIndex = -1;
+		// true while a published list has not been picked up by the render thread yet
+		bool ready = false;
+		// set when the buffer is shutting down so that nothing waits forever
+		bool stopping = false;
+		std::mutex mutex;
+		std::condition_variable condition;
+
+	public:
+
+		RenderListBuffer() {}
+		RenderListBuffer(const RenderListBuffer&) = delete;
+		RenderListBuffer& operator=(const RenderListBuffer&) = delete;
+		// (update thread) wait until the next list is no longer being drawn, then clear and return it
+		// returns nullptr if the buffer is stopping
+		RenderList* beginWrite();
+		// (update thread) hand the written list over to the render thread
+		void publish();
+		// (render thread) switch to the newest published list if there is one and return the list to draw
+		// (the previous list is returned again if the update thread has not published a new one yet, nullptr before the first)
+		const RenderList* acquire();
+		// get the generation of the list most recently handed out for writing (0 if none was)
+		unsigned long long getLatestGeneration();
+		// get the generation of the list acquire() returns (0 before the first list)
+		unsigned long long getReadGeneration();
+		// wake up and release anything waiting on the buffer
+		void stop();
+		// allow the buffer to be used again after stop()
+		void reset();
+	};
+}
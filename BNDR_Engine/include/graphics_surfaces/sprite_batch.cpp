@@ -0,0 +1,216 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "sprite_batch.h"
+#include "../profiling/gpu_profiler.h"
+
+namespace bndr {
+
+	SpriteBatch::SpriteBatch(const TextureArray* textureArray, int spriteCapacity) : PolySurface(), textures(textureArray),
+		capacity(spriteCapacity) {
+
+		if (textures == nullptr) {
+
+			BNDR_EXCEPTION("A sprite batch needs a texture array to draw its sprites from");
+		}
+		if (capacity < 1) {
+
+			BNDR_EXCEPTION("A sprite batch needs room for at least one sprite");
+		}
+		sprites.reserve(capacity);
+		// the vertex buffer is created at full size, so adding a sprite never reallocates it
+		vertices.assign((size_t)capacity * FLOATS_PER_SPRITE, 0.0f);
+		init(4, true);
+	}
+
+	VertexArray* SpriteBatch::generateVertexArray() {
+
+		std::vector<uint> indices;
+		indices.reserve((size_t)capacity * 6);
+		for (uint quad = 0; quad < (uint)capacity; quad++) {
+
+			uint first = quad * 4;
+			indices.insert(indices.end(), { first, first + 1, first + 2, first + 2, first + 3, first });
+		}
+		return new VertexArray(TRIANGLES, std::vector<float>(vertices), FLOATS_PER_VERTEX * sizeof(float),
+			bndr::RGBA_COLOR_ATTRIB | bndr::TEXTURE_COORDS_ATTRIB | bndr::TEXTURE_INDEX_ATTRIB, std::move(indices));
+	}
+
+	void SpriteBatch::checkIndex(int index) const {
+
+		if (index < 0 || index >= (int)sprites.size()) {
+
+			std::string message = "The sprite batch has no sprite " + std::to_string(index);
+			BNDR_EXCEPTION(message.c_str());
+		}
+	}
+
+	void SpriteBatch::checkLayer(int layer) const {
+
+		if (layer < 0 || layer >= textures->getLayerCount()) {
+
+			std::string message = "The texture array of the sprite batch has no layer " + std::to_string(layer);
+			BNDR_EXCEPTION(message.c_str());
+		}
+	}
+
+	void SpriteBatch::writeSprite(int index) {
+
+		const Sprite& sprite = sprites[index];
+		float* vertex = &vertices[(size_t)index * FLOATS_PER_SPRITE];
+		// the same corners and texture coordinates as TexturedRect
+		const float corners[4][4] = {
+			{ sprite.x, sprite.y, 0.0f, 0.0f },
+			{ sprite.x, sprite.y + sprite.height, 0.0f, 1.0f },
+			{ sprite.x + sprite.width, sprite.y + sprite.height, 1.0f, 1.0f },
+			{ sprite.x + sprite.width, sprite.y, 1.0f, 0.0f }
+		};
+		for (const float* corner : corners) {
+
+			vertex[0] = corner[0];
+			vertex[1] = corner[1];
+			vertex[2] = 0.0f;
+			std::memcpy(vertex + 3, sprite.color, sizeof(sprite.color));
+			vertex[7] = corner[2];
+			vertex[8] = corner[3];
+			vertex[9] = sprite.layer;
+			vertex += FLOATS_PER_VERTEX;
+		}
+		verticesDirty = true;
+	}
+
+	int SpriteBatch::add(float x, float y, float width, float height, int layer, const RGBAData& color) {
+
+		if ((int)sprites.size() == capacity) {
+
+			std::string message = "The sprite batch is full (" + std::to_string(capacity) + " sprites)";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		checkLayer(layer);
+		sprites.emplace_back();
+		int index = (int)sprites.size() - 1;
+		Sprite& sprite = sprites[index];
+		sprite.layer = (float)layer;
+		sprite.color[0] = (float)color.red / 255.0f;
+		sprite.color[1] = (float)color.green / 255.0f;
+		sprite.color[2] = (float)color.blue / 255.0f;
+		sprite.color[3] = (float)color.alpha / 255.0f;
+		Vec2<float> glPos = convertScreenSpaceToGLSpace(Vec2<float>(x, y));
+		Vec2<float> glSize = convertScreenSpaceBetween0And2(Vec2<float>(width, height));
+		sprite.x = glPos[0];
+		sprite.y = glPos[1];
+		sprite.width = glSize[0];
+		sprite.height = glSize[1];
+		writeSprite(index);
+		return index;
+	}
+
+	void SpriteBatch::setPosition(int index, float x, float y) {
+
+		checkIndex(index);
+		Vec2<float> glPos = convertScreenSpaceToGLSpace(Vec2<float>(x, y));
+		sprites[index].x = glPos[0];
+		sprites[index].y = glPos[1];
+		writeSprite(index);
+	}
+
+	void SpriteBatch::setSize(int index, float width, float height) {
+
+		checkIndex(index);
+		Vec2<float> glSize = convertScreenSpaceBetween0And2(Vec2<float>(width, height));
+		sprites[index].width = glSize[0];
+		sprites[index].height = glSize[1];
+		writeSprite(index);
+	}
+
+	void SpriteBatch::setLayer(int index, int layer) {
+
+		checkIndex(index);
+		checkLayer(layer);
+		if (sprites[index].layer == (float)layer) {
+
+			return;
+		}
+		sprites[index].layer = (float)layer;
+		writeSprite(index);
+	}
+
+	void SpriteBatch::setColor(int index, const RGBAData& color) {
+
+		checkIndex(index);
+		Sprite& sprite = sprites[index];
+		sprite.color[0] = (float)color.red / 255.0f;
+		sprite.color[1] = (float)color.green / 255.0f;
+		sprite.color[2] = (float)color.blue / 255.0f;
+		sprite.color[3] = (float)color.alpha / 255.0f;
+		writeSprite(index);
+	}
+
+	void SpriteBatch::setFillColor(const RGBAData& data) {
+
+		for (int i = 0; i < (int)sprites.size(); i++) {
+
+			setColor(i, data);
+		}
+	}
+
+	void SpriteBatch::clear() {
+
+		// zeroed quads have no area, so the removed sprites draw nothing
+		std::fill(vertices.begin(), vertices.begin() + sprites.size() * FLOATS_PER_SPRITE, 0.0f);
+		verticesDirty = verticesDirty || !sprites.empty();
+		sprites.clear();
+	}
+
+	void SpriteBatch::fillCommand(RenderCommand& command) const {
+
+		PolySurface::fillCommand(command);
+		command.textureID = (uint)textures->getID();
+		command.flags |= RENDER_TEXTURED | RENDER_TEXTURE_ARRAY;
+	}
+
+	void SpriteBatch::render() {
+
+		BNDR_PROFILE_SCOPE("SpriteBatch::render");
+		BNDR_PROFILE_GPU_SCOPE("SpriteBatch::render");
+		if (verticesDirty) {
+
+			va->updateVertexBufferData(&vertices[0]);
+			verticesDirty = false;
+		}
+		RenderCommand command;
+		fillCommand(command);
+		RenderList::drawCommand(command, nullptr);
+	}
+
+	void SpriteBatch::record(RenderList& list) {
+
+		RenderCommand& command = list.add();
+		fillCommand(command);
+		if (verticesDirty) {
+
+			list.attachVertexData(command, &vertices[0], (int)vertices.size());
+			verticesDirty = false;
+		}
+	}
+}
@@ -0,0 +1,106 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "primitives/graphical_bedrocks.h"
+
+namespace bndr {
+
+	// bndr::SpriteBatch
+	// Description: Many textured quads that sample the layers of one bndr::TextureArray. Every quad lives in the same vertex
+	// buffer and every vertex carries the layer it samples, so the whole batch costs one texture bind and one draw call no
+	// matter how many of its sprites are animating. Stepping the animation of a sprite only rewrites its four vertices,
+	// the changed vertex data is uploaded once per frame. Positions and sizes are in pixels like the other surfaces, the
+	// transforms of the batch move all of its sprites
+	class BNDR_API SpriteBatch : public PolySurface {
+
+		// a sprite in GL coordinates
+		struct Sprite {
+
+			float x;
+			float y;
+			float width;
+			float height;
+			float layer;
+			float color[4];
+		};
+
+		// position (3), color (4), texture coordinates (2) and layer (1)
+		static const int FLOATS_PER_VERTEX = 10;
+		static const int FLOATS_PER_SPRITE = 4 * FLOATS_PER_VERTEX;
+
+		// the layers of the sprites (not owned, it has to outlive the batch)
+		const TextureArray* textures;
+		int capacity;
+		std::vector<Sprite> sprites;
+		// the vertices of every quad (the quads past the last sprite are all 0 and draw nothing)
+		std::vector<float> vertices;
+		// set when the vertices changed since they were last uploaded or recorded
+		bool verticesDirty = false;
+
+		// write the vertices of a sprite
+		void writeSprite(int index);
+		// throws if the index is not a sprite or the layer is not in the array
+		void checkIndex(int index) const;
+		void checkLayer(int layer) const;
+
+	protected:
+
+		virtual VertexArray* generateVertexArray() override;
+		// the colors are stored per vertex
+		inline virtual bool usesColorUniform() const override { return false; }
+		// generate a program that samples an array texture with the layer of every vertex
+		inline virtual Program* generateShaderProgram(int numTexes = 0) override { return ShaderVariants::acquire(SHADER_VERTEX_COLORS | SHADER_TEXTURE_ARRAY); }
+		// adds the array texture to the snapshot of the surface
+		virtual void fillCommand(RenderCommand& command) const override;
+
+	public:
+
+		// create an empty batch with room for a number of sprites
+		SpriteBatch(const TextureArray* textureArray, int spriteCapacity);
+		// add a sprite that draws a layer of the array, returns its index (throws if the batch is full)
+		int add(float x, float y, float width, float height, int layer = 0, const RGBAData& color = bndr::WHITE);
+		// move a sprite (in pixels)
+		void setPosition(int index, float x, float y);
+		// resize a sprite (in pixels)
+		void setSize(int index, float width, float height);
+		// switch the layer a sprite draws (i.e. the next frame of its animation)
+		void setLayer(int index, int layer);
+		// get the layer a sprite draws
+		inline int getLayer(int index) const { checkIndex(index); return (int)sprites[index].layer; }
+		// tint a sprite
+		void setColor(int index, const RGBAData& color);
+		// tint every sprite
+		virtual void setFillColor(const RGBAData& data) override;
+		// remove every sprite
+		void clear();
+		inline int getCount() const { return (int)sprites.size(); }
+		inline int getCapacity() const { return capacity; }
+		// get the array the sprites sample
+		inline const TextureArray* getTextureArray() const { return textures; }
+		// render every sprite with one draw call
+		virtual void render() override;
+		// record a snapshot of the batch into a render list (the vertex data is only attached if it changed)
+		virtual void record(RenderList& list) override;
+	};
+}
@@ -0,0 +1,136 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "update_thread.h"
+#include "primitives/graphical_bedrocks.h"
+#include "../profiling/profiler.h"
+
+namespace bndr {
+
+	// a generation newer than every list, passing it runs every posted task
+	static const unsigned long long ALL_TASKS = ~0ULL;
+
+	UpdateThread::UpdateThread(std::function<void(float, RenderList&)>&& function)
+		: updateFunction(std::move(function)), running(false) {}
+
+	void UpdateThread::start() {
+
+		if (running.load()) {
+
+			return;
+		}
+		// from now on the surface setters only record state and the render thread uploads it
+		PixelSurface::setDeferredUpdates(true);
+		buffer.reset();
+		running.store(true);
+		thread = std::thread(&UpdateThread::loop, this);
+	}
+
+	void UpdateThread::loop() {
+
+		// (named in every build so flight recorder dumps show which timeline is the update thread)
+		Profiler::setThreadName("update");
+		Clock clock;
+		while (running.load()) {
+
+			// wait until the render thread is done with the list we are about to overwrite
+			RenderList* list = buffer.beginWrite();
+			if (list == nullptr) {
+
+				break;
+			}
+			BNDR_FLIGHT_SCOPE("UpdateThread::update");
+			updateFunction(clock.deltaTime(), *list);
+			buffer.publish();
+		}
+	}
+
+	void UpdateThread::stop() {
+
+		if (!running.load()) {
+
+			return;
+		}
+		running.store(false);
+		buffer.stop();
+		thread.join();
+		// the surfaces go back to updating the GPU immediately (call render() once more to draw the last recorded list)
+		PixelSurface::setDeferredUpdates(false);
+	}
+
+	bool UpdateThread::render() {
+
+		// switch lists first, the tasks may only run once every list that could reference their surfaces is replaced
+		const RenderList* list = buffer.acquire();
+		if (!running.load()) {
+
+			// the last list of a stopped update thread is drawn once, after that nothing can reference the surfaces
+			if (list != nullptr) {
+
+				list->execute();
+			}
+			runTasks(ALL_TASKS);
+			buffer.reset();
+			return list != nullptr;
+		}
+		if (list == nullptr) {
+
+			// nothing was drawn yet
+			runTasks(ALL_TASKS);
+			return false;
+		}
+		runTasks(buffer.getReadGeneration());
+		list->execute();
+		return true;
+	}
+
+	void UpdateThread::runTasks(unsigned long long readGeneration) {
+
+		{
+			std::lock_guard<std::mutex> lock(taskMutex);
+			while (!tasks.empty() && tasks.front().first < readGeneration) {
+
+				runningTasks.push_back(std::move(tasks.front().second));
+				tasks.pop_front();
+			}
+		}
+		for (std::function<void()>& task : runningTasks) {
+
+			task();
+		}
+		runningTasks.clear();
+	}
+
+	void UpdateThread::postToRenderThread(std::function<void()>&& task) {
+
+		// the newest list may already hold the surfaces the task touches, the task waits for a list started after it
+		unsigned long long generation = buffer.getLatestGeneration();
+		std::lock_guard<std::mutex> lock(taskMutex);
+		tasks.emplace_back(generation, std::move(task));
+	}
+
+	UpdateThread::~UpdateThread() {
+
+		stop();
+	}
+}
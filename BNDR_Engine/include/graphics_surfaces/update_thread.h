@@ -0,0 +1,87 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "render_list.h"
+#include "../window_render/timers.h"
+
+namespace bndr {
+
+	// bndr::UpdateThread
+	// Description: Runs the game logic on its own thread. Every iteration the update function receives the delta time and
+	// an empty RenderList that it fills by calling record(list) on the frames/surfaces it wants drawn. Meanwhile the thread
+	// that owns the OpenGL context calls render() every frame, which draws the previous frame's list, so update and render
+	// costs overlap instead of adding up.
+	// Rules while the thread is running:
+	//        - surface setters (translation, rotation, scale, colors) only change RAM, the GPU is updated when the command is drawn
+	//        - surfaces must be created and destroyed on the render thread (use postToRenderThread from the update function)
+	//        - window events are polled on the render thread, so forward the ones the game logic needs through your own queue
+	class BNDR_API UpdateThread {
+
+		// the function that updates the game state and records the frame
+		std::function<void(float, RenderList&)> updateFunction;
+		std::thread thread;
+		std::atomic<bool> running;
+		// the lists handed from the update thread to the render thread
+		RenderListBuffer buffer;
+		// work that has to happen on the render thread (i.e. creating or deleting surfaces), tagged with the newest list
+		// generation at the time it was posted (in posting order, so the generations never go down)
+		std::mutex taskMutex;
+		std::deque<std::pair<unsigned long long, std::function<void()>>> tasks;
+		// reused so that running the tasks does not allocate every frame
+		std::vector<std::function<void()>> runningTasks;
+
+		// the body of the update thread
+		void loop();
+		// run the posted tasks whose list generation is older than the list being drawn
+		void runTasks(unsigned long long readGeneration);
+
+	public:
+
+		// bndr::UpdateThread::UpdateThread
+		// Arguments:
+		//        function = Called once per update with the delta time in seconds and the list to record the frame into
+		// Description: Creates the update thread object (the thread itself starts with start())
+		UpdateThread(std::function<void(float, RenderList&)>&& function);
+		UpdateThread(const UpdateThread&) = delete;
+		UpdateThread(UpdateThread&&) = delete;
+		UpdateThread& operator=(const UpdateThread&) = delete;
+		// start updating on the separate thread (surface setters stop touching the GPU until stop() is called)
+		void start();
+		// stop the update thread and wait for it to finish
+		// (the next render() draws the last recorded list once and then runs every remaining task)
+		void stop();
+		// check if the update thread is running
+		inline bool isRunning() const { return running.load(); }
+		// (render thread) run the posted tasks that are due and draw the most recent list
+		// returns false if no list has been recorded yet
+		bool render();
+		// queue work for the render thread. While the update thread runs, the task waits until the list being recorded
+		// when it was posted is no longer drawn (a list started after the post replaced it), so a surface deleted by
+		// the task is never referenced by a list that is still drawn. Otherwise it runs at the start of the next render()
+		void postToRenderThread(std::function<void()>&& task);
+		// bndr::UpdateThread::~UpdateThread
+		// Description: Stops the thread if it is still running
+		~UpdateThread();
+	};
+}
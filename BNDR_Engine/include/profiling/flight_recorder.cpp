@@ -0,0 +1,253 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "flight_recorder.h"
+
+namespace bndr {
+
+	FlightRecorder* FlightRecorder::inputRecorder = nullptr;
+
+	// the data a dump writes (copied on the recording thread so the rings can keep going)
+	struct FlightDump {
+
+		std::string filePath;
+		std::string reason;
+		float hitchThreshold;
+		long long epoch;
+		std::vector<std::pair<long long, float>> frameTimes;
+		std::vector<unsigned long long> frameIndices;
+		std::vector<RenderCounters> counters;
+		// input events with their time relative to the epoch in microseconds
+		struct Input {
+
+			double time;
+			int type;
+			int code;
+			int action;
+			float x;
+			float y;
+			float delta;
+		};
+		std::vector<Input> inputs;
+		std::vector<ThreadZones> threads;
+	};
+
+	// write a dump as Chrome trace event JSON (runs on the dump thread)
+	static void writeFlightDump(const FlightDump& dump) {
+
+		std::ofstream file(dump.filePath);
+		if (!file.is_open()) {
+
+			std::string message = "Failed to write the flight recorder dump '" + dump.filePath + "'";
+			BNDR_MESSAGE(message.c_str());
+			return;
+		}
+		// reserved thread ids for the frame and input timelines (profiler threads are numbered from 0)
+		const uint FRAME_TID = 100000;
+		const uint INPUT_TID = 100001;
+
+		file << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"reason\":";
+		Profiler::writeJSONString(file, dump.reason);
+		file << ",\"hitchThresholdMs\":" << dump.hitchThreshold * 1000.0f << "},\"traceEvents\":[\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << FRAME_TID << ",\"args\":{\"name\":\"frames\"}},\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << INPUT_TID << ",\"args\":{\"name\":\"input\"}}";
+
+		// one complete event per frame with its counters, plus counter tracks for graphs
+		for (size_t i = 0; i < dump.frameTimes.size(); i++) {
+
+			double end = (double)(dump.frameTimes[i].first - dump.epoch) * 0.001;
+			double duration = (double)dump.frameTimes[i].second * 1000000.0;
+			const RenderCounters& counters = dump.counters[i];
+			file << ",\n{\"name\":\"frame " << dump.frameIndices[i] << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":" << FRAME_TID
+				<< ",\"ts\":" << end - duration << ",\"dur\":" << duration << ",\"args\":{\"frameTimeMs\":" << dump.frameTimes[i].second * 1000.0f
+				<< ",\"drawCalls\":" << counters.drawCalls << ",\"stateChanges\":" << counters.stateChanges << ",\"elidedCalls\":" << counters.elidedCalls << ",\"bytesUploaded\":" << counters.bytesUploaded << "}}";
+			file << ",\n{\"name\":\"frame time\",\"ph\":\"C\",\"pid\":0,\"ts\":" << end - duration << ",\"args\":{\"ms\":" << dump.frameTimes[i].second * 1000.0f << "}}";
+			file << ",\n{\"name\":\"render counters\",\"ph\":\"C\",\"pid\":0,\"ts\":" << end - duration << ",\"args\":{\"drawCalls\":" << counters.drawCalls
+				<< ",\"stateChanges\":" << counters.stateChanges << ",\"elidedCalls\":" << counters.elidedCalls << "}}";
+		}
+		static const char* inputNames[] = { "key", "mouse button", "scroll" };
+		for (const FlightDump::Input& input : dump.inputs) {
+
+			file << ",\n{\"name\":\"" << inputNames[input.type] << "\",\"cat\":\"input\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":" << INPUT_TID
+				<< ",\"ts\":" << input.time << ",\"args\":{";
+			if (input.type == FLIGHT_INPUT_SCROLL) {
+
+				file << "\"delta\":" << input.delta;
+			}
+			else {
+
+				file << "\"code\":" << input.code << ",\"action\":" << input.action;
+			}
+			file << ",\"x\":" << input.x << ",\"y\":" << input.y << "}}";
+		}
+		for (const ThreadZones& thread : dump.threads) {
+
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread.threadID << ",\"args\":{\"name\":";
+			Profiler::writeJSONString(file, thread.threadName);
+			file << "}}";
+			for (const ProfileZone& zone : thread.zones) {
+
+				file << ",\n{\"name\":";
+				Profiler::writeJSONString(file, zone.name);
+				file << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.threadID << ",\"ts\":" << (double)(zone.start - dump.epoch) * 0.001
+					<< ",\"dur\":" << (double)(zone.end - zone.start) * 0.001 << "}";
+			}
+		}
+		file << "\n]}\n";
+	}
+
+	FlightRecorder::FlightRecorder(int frameCapacity, float hitchThresholdSeconds, const char* directory)
+		: hitchThreshold(hitchThresholdSeconds), dumpDirectory(directory), dumping(false) {
+
+		if (frameCapacity <= 0) {
+
+			BNDR_EXCEPTION("The flight recorder needs room for at least one frame");
+		}
+		frames.resize(frameCapacity);
+		// let the ring fill up halfway again so back to back hitches do not dump the same frames over and over
+		cooldownFrames = (unsigned long long)frameCapacity / 2;
+		FlightRecorder::inputRecorder = this;
+	}
+
+	bool FlightRecorder::frame() {
+
+		long long end = Profiler::now();
+		FrameRecord& record = frames[frameCount % frames.size()];
+		record.frameIndex = frameCount;
+		record.end = end;
+		record.frameTime = clock.deltaTime();
+		record.counters = RenderStats::takeFrame();
+		frameCount++;
+
+		// the first frame measures from construction, which usually includes loading
+		if (frameCount == 1 || record.frameTime <= hitchThreshold) {
+
+			return false;
+		}
+		if (hasDumped && frameCount - lastDumpFrame < cooldownFrames) {
+
+			return false;
+		}
+		if (dumping.load()) {
+
+			return false;
+		}
+		std::string reason = "frame " + std::to_string(record.frameIndex) + " took " + std::to_string(record.frameTime * 1000.0f) + "ms";
+		startDump(reason.c_str());
+		return true;
+	}
+
+	bool FlightRecorder::dumpNow() {
+
+		if (dumping.load() || frameCount == 0) {
+
+			return false;
+		}
+		startDump("requested");
+		return true;
+	}
+
+	void FlightRecorder::startDump(const char* reason) {
+
+		// the previous dump thread has finished (dumping is false) but still has to be joined
+		if (dumpThread.joinable()) {
+
+			dumpThread.join();
+		}
+		dumping.store(true);
+		hasDumped = true;
+		lastDumpFrame = frameCount;
+		dumpCount++;
+
+		// copy the rings in order from the oldest frame
+		FlightDump* dump = new FlightDump();
+		dump->filePath = dumpDirectory + "/bndr_flight_" + std::to_string(dumpCount) + "_frame_" + std::to_string(frameCount - 1) + ".json";
+		dump->reason = reason;
+		dump->hitchThreshold = hitchThreshold;
+		dump->epoch = Profiler::getEpoch();
+		unsigned long long storedFrames = std::min<unsigned long long>(frameCount, frames.size());
+		long long windowStart = 0;
+		for (unsigned long long i = frameCount - storedFrames; i < frameCount; i++) {
+
+			const FrameRecord& record = frames[i % frames.size()];
+			if (i == frameCount - storedFrames) {
+
+				windowStart = record.end - (long long)((double)record.frameTime * 1000000000.0);
+			}
+			dump->frameTimes.push_back(std::make_pair(record.end, record.frameTime));
+			dump->frameIndices.push_back(record.frameIndex);
+			dump->counters.push_back(record.counters);
+		}
+		unsigned long long storedInputs = std::min<unsigned long long>(inputCount, INPUT_CAPACITY);
+		for (unsigned long long i = inputCount - storedInputs; i < inputCount; i++) {
+
+			const InputRecord& input = inputs[i % INPUT_CAPACITY];
+			if (input.time < windowStart) {
+
+				continue;
+			}
+			FlightDump::Input dumped = { (double)(input.time - dump->epoch) * 0.001, input.type, input.code, input.action, input.x, input.y, input.delta };
+			dump->inputs.push_back(dumped);
+		}
+		// the BNDR_FLIGHT_SCOPE zones are always there, the others only when BNDR_PROFILE is defined (the profiler rings may
+		// cover fewer frames than the recorder)
+		dump->threads = Profiler::snapshot(windowStart, Profiler::now());
+
+		dumpThread = std::thread([this, dump]() {
+
+			writeFlightDump(*dump);
+			delete dump;
+			dumping.store(false);
+		});
+	}
+
+	void FlightRecorder::recordInput(int type, int code, int action, float x, float y, float delta) {
+
+		FlightRecorder* recorder = FlightRecorder::inputRecorder;
+		if (recorder == nullptr) {
+
+			return;
+		}
+		InputRecord& input = recorder->inputs[recorder->inputCount % INPUT_CAPACITY];
+		input.time = Profiler::now();
+		input.type = type;
+		input.code = code;
+		input.action = action;
+		input.x = x;
+		input.y = y;
+		input.delta = delta;
+		recorder->inputCount++;
+	}
+
+	FlightRecorder::~FlightRecorder() {
+
+		if (dumpThread.joinable()) {
+
+			dumpThread.join();
+		}
+		if (FlightRecorder::inputRecorder == this) {
+
+			FlightRecorder::inputRecorder = nullptr;
+		}
+	}
+}
@@ -0,0 +1,131 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "profiler.h"
+#include "render_stats.h"
+#include "../window_render/timers.h"
+
+namespace bndr {
+
+	// the kinds of input the flight recorder keeps
+	enum flightInputTypes {
+
+		FLIGHT_INPUT_KEY,
+		FLIGHT_INPUT_MOUSE_BUTTON,
+		FLIGHT_INPUT_SCROLL
+	};
+
+	// bndr::FlightRecorder
+	// Description: Always on recorder of the last few hundred frames (frame time, render counters from bndr::RenderStats,
+	// input events from the window callbacks and the CPU zones of bndr::Profiler). The coarse BNDR_FLIGHT_SCOPE zones are
+	// recorded in every build, the detailed BNDR_PROFILE_SCOPE zones and the GPU zones only if BNDR_PROFILE is defined.
+	// When a frame takes longer than the hitch threshold the recorded window is copied and written to disk as Chrome trace
+	// event JSON by a background thread, so the evidence of rare hitches is kept without attaching a profiler.
+	// Recording a frame copies a few numbers into a ring, nothing is allocated or formatted until a hitch happens.
+	// Only one recorder can receive the window's input at a time (the most recently constructed one), and frame() has to
+	// be called on the thread that owns the OpenGL context (the same thread that polls the window events)
+	class BNDR_API FlightRecorder {
+
+		// one recorded frame
+		struct FrameRecord {
+
+			unsigned long long frameIndex;
+			// the time the frame ended (nanoseconds of the steady clock) and how long it took in seconds
+			long long end;
+			float frameTime;
+			RenderCounters counters;
+		};
+
+		// one recorded input event
+		struct InputRecord {
+
+			long long time;
+			int type;
+			int code;
+			int action;
+			float x;
+			float y;
+			// the scroll offset
+			float delta;
+		};
+
+		// the number of input events kept
+		static const int INPUT_CAPACITY = 1024;
+
+		// the recorder that receives the window's input
+		static FlightRecorder* inputRecorder;
+
+		std::vector<FrameRecord> frames;
+		unsigned long long frameCount = 0;
+		InputRecord inputs[INPUT_CAPACITY];
+		unsigned long long inputCount = 0;
+		// measures the frame times
+		Clock clock;
+		// frames longer than this (in seconds) trigger a dump
+		float hitchThreshold;
+		// where dumps are written
+		std::string dumpDirectory;
+		// no new dump is started until this many frames have been recorded since the last one
+		unsigned long long cooldownFrames;
+		unsigned long long lastDumpFrame = 0;
+		bool hasDumped = false;
+		// the background thread writing the current dump
+		std::thread dumpThread;
+		std::atomic<bool> dumping;
+		ulong dumpCount = 0;
+
+		// copy the recorded window and start writing it on the background thread
+		void startDump(const char* reason);
+
+	public:
+
+		// bndr::FlightRecorder::FlightRecorder
+		// Arguments:
+		//        frameCapacity = The number of recent frames kept
+		//        hitchThresholdSeconds = Frames longer than this are dumped (with the frames leading up to them)
+		//        directory = The directory the dumps are written to
+		// Description: Allocates the frame ring and starts receiving the window's input events
+		FlightRecorder(int frameCapacity = 300, float hitchThresholdSeconds = 0.05f, const char* directory = ".");
+		FlightRecorder(const FlightRecorder&) = delete;
+		FlightRecorder& operator=(const FlightRecorder&) = delete;
+		// end the current frame (call once per frame, i.e. right after Window::update)
+		// returns true if the frame was a hitch and a dump was started
+		bool frame();
+		// dump the recorded window now (i.e. from a debug key), returns false if a dump is still being written
+		bool dumpNow();
+		// set the frame time in seconds that counts as a hitch
+		inline void setHitchThreshold(float seconds) { hitchThreshold = seconds; }
+		// get the frame time in seconds that counts as a hitch
+		inline float getHitchThreshold() const { return hitchThreshold; }
+		// get the number of dumps started
+		inline ulong getDumpCount() const { return dumpCount; }
+		// check if a dump is being written
+		inline bool isDumping() const { return dumping.load(); }
+		// record an input event (called by the window callbacks, does nothing without a recorder)
+		static void recordInput(int type, int code, int action, float x, float y, float delta = 0.0f);
+		// bndr::FlightRecorder::~FlightRecorder
+		// Description: Waits for a dump that is still being written and stops receiving input
+		~FlightRecorder();
+	};
+}
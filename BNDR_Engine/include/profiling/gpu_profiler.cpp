@@ -0,0 +1,190 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "gpu_profiler.h"
+
+namespace bndr {
+
+	GPUProfiler::FrameQueries GPUProfiler::frames[GPUProfiler::FRAME_LATENCY];
+	int GPUProfiler::currentFrame = -1;
+	int GPUProfiler::nextFrame = 0;
+	int GPUProfiler::oldestFrame = 0;
+	int GPUProfiler::frameZone = -1;
+	int GPUProfiler::depth = 0;
+	Profiler::ThreadBuffer* GPUProfiler::timeline = nullptr;
+	ulong GPUProfiler::skippedFrames = 0;
+	bool GPUProfiler::supported = false;
+	bool GPUProfiler::initialized = false;
+
+	bool GPUProfiler::isSupported() {
+
+		if (!initialized) {
+
+			// timer queries are core since OpenGL 3.3 (llvmpipe included), the extension check covers older contexts
+			int major = 0;
+			int minor = 0;
+			glGetIntegerv(GL_MAJOR_VERSION, &major);
+			glGetIntegerv(GL_MINOR_VERSION, &minor);
+			supported = (major > 3 || (major == 3 && minor >= 3) || GLEW_ARB_timer_query);
+			initialized = true;
+			if (supported) {
+
+				timeline = Profiler::registerTimeline("GPU");
+			}
+		}
+		return supported;
+	}
+
+	int GPUProfiler::writeTimestamp() {
+
+		FrameQueries& frame = frames[currentFrame];
+		if (frame.usedQueries == (int)frame.queries.size()) {
+
+			uint query = 0;
+			GL_DEBUG_FUNC(glGenQueries(1, &query));
+			frame.queries.push_back(query);
+		}
+		int index = frame.usedQueries++;
+		glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+		return index;
+	}
+
+	void GPUProfiler::collectResults() {
+
+		// frames finish in order, so stop at the first one the GPU is still working on
+		for (int i = 0; i < FRAME_LATENCY; i++) {
+
+			FrameQueries& frame = frames[oldestFrame];
+			if (!frame.pending || oldestFrame == currentFrame) {
+
+				break;
+			}
+			if (frame.usedQueries > 0) {
+
+				// the last timestamp of the frame is written last, so once it is available every other one is as well
+				int available = 0;
+				glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+				if (!available) {
+
+					break;
+				}
+				for (const PendingZone& zone : frame.zones) {
+
+					// zones that were never closed (i.e. an exception skipped the end) are dropped
+					if (zone.endQuery == -1) {
+
+						continue;
+					}
+					GLuint64 begin = 0;
+					GLuint64 end = 0;
+					glGetQueryObjectui64v(frame.queries[zone.beginQuery], GL_QUERY_RESULT, &begin);
+					glGetQueryObjectui64v(frame.queries[zone.endQuery], GL_QUERY_RESULT, &end);
+					Profiler::recordZone(timeline, zone.name, (long long)begin + frame.clockOffset, (long long)end + frame.clockOffset, zone.depth);
+				}
+			}
+			frame.pending = false;
+			oldestFrame = (oldestFrame + 1) % FRAME_LATENCY;
+		}
+	}
+
+	void GPUProfiler::newFrame() {
+
+		if (!isSupported()) {
+
+			return;
+		}
+		// close the frame that was recording
+		if (currentFrame != -1) {
+
+			endZone(frameZone);
+			frames[currentFrame].pending = true;
+			currentFrame = -1;
+		}
+		collectResults();
+
+		// the slot is still waiting on the GPU, skip profiling this frame rather than waiting
+		if (frames[nextFrame].pending) {
+
+			skippedFrames++;
+			return;
+		}
+		currentFrame = nextFrame;
+		nextFrame = (nextFrame + 1) % FRAME_LATENCY;
+		FrameQueries& frame = frames[currentFrame];
+		frame.usedQueries = 0;
+		frame.zones.clear();
+		depth = 0;
+
+		// measure how far the GPU clock is from the CPU clock (this does not wait for the GPU to finish)
+		GLint64 gpuTime = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+		frame.clockOffset = Profiler::now() - (long long)gpuTime;
+
+		frameZone = beginZone("GPU frame");
+	}
+
+	int GPUProfiler::beginZone(const char* name) {
+
+		if (currentFrame == -1) {
+
+			return -1;
+		}
+		FrameQueries& frame = frames[currentFrame];
+		PendingZone zone;
+		zone.name = name;
+		zone.beginQuery = writeTimestamp();
+		zone.endQuery = -1;
+		zone.depth = depth++;
+		frame.zones.push_back(zone);
+		return (int)frame.zones.size() - 1;
+	}
+
+	void GPUProfiler::endZone(int zone) {
+
+		// the zone may belong to a frame that was skipped
+		if (zone == -1 || currentFrame == -1 || zone >= (int)frames[currentFrame].zones.size()) {
+
+			return;
+		}
+		frames[currentFrame].zones[zone].endQuery = writeTimestamp();
+		depth--;
+	}
+
+	void GPUProfiler::shutdown() {
+
+		for (FrameQueries& frame : frames) {
+
+			if (!frame.queries.empty()) {
+
+				glDeleteQueries((int)frame.queries.size(), &frame.queries[0]);
+			}
+			frame.queries.clear();
+			frame.zones.clear();
+			frame.usedQueries = 0;
+			frame.pending = false;
+		}
+		currentFrame = -1;
+		nextFrame = 0;
+		oldestFrame = 0;
+	}
+}
@@ -0,0 +1,132 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "profiler.h"
+#include "../window_render/gpu_objects/GLDebug.h"
+
+namespace bndr {
+
+	// bndr::GPUProfiler
+	// Description: Static GPU zone profiler that shows how long draw work takes on the GPU next to the CPU zones of
+	// bndr::Profiler (as a timeline named "GPU"). Zones are bracketed with GL_TIMESTAMP queries (unlike GL_TIME_ELAPSED
+	// they can nest, and they do not collide with the GL_TIME_ELAPSED query of bndr::ResolutionScaler). The queries of a
+	// frame are only read FRAME_LATENCY frames later once the GPU reports them available, so the CPU never waits on the GPU
+	// (if the GPU falls that far behind, frames are skipped instead). GPU timestamps are converted to the CPU clock with an
+	// offset measured every frame with glGetInteger64v(GL_TIMESTAMP).
+	// Every function must be called on the thread that owns the OpenGL context. Zones are recorded with
+	// BNDR_PROFILE_GPU_SCOPE which compiles to nothing unless BNDR_PROFILE is defined
+	class BNDR_API GPUProfiler {
+
+	public:
+
+		// the number of frames whose queries can be in flight at once
+		static const int FRAME_LATENCY = 4;
+
+	private:
+
+		// a zone waiting for its query results
+		struct PendingZone {
+
+			const char* name;
+			int beginQuery;
+			int endQuery;
+			int depth;
+		};
+
+		// the queries of one frame
+		struct FrameQueries {
+
+			// query objects (grows to the most zones a frame has needed and is reused after that)
+			std::vector<uint> queries;
+			int usedQueries = 0;
+			std::vector<PendingZone> zones;
+			// the CPU time minus the GPU time when the frame started (in nanoseconds)
+			long long clockOffset = 0;
+			// true while the results have not been read
+			bool pending = false;
+		};
+
+		static FrameQueries frames[FRAME_LATENCY];
+		// the frame currently recording (-1 if this frame is skipped or the profiler is not initialized)
+		static int currentFrame;
+		// the frame the next frame will record into
+		static int nextFrame;
+		// the frame recorded before the current one (the oldest pending frame comes after it)
+		static int oldestFrame;
+		// the zone covering the whole frame
+		static int frameZone;
+		// nesting depth of the open zones
+		static int depth;
+		// the timeline in the profiler that the GPU zones are added to
+		static Profiler::ThreadBuffer* timeline;
+		// frames that were not profiled because the GPU was FRAME_LATENCY frames behind
+		static ulong skippedFrames;
+		static bool supported;
+		static bool initialized;
+
+		// get the next free query of the current frame and write a timestamp into it
+		static int writeTimestamp();
+		// read the results of every frame whose queries have finished (oldest first)
+		static void collectResults();
+
+	public:
+
+		// start recording the next frame (called by Window::update) and collect the results of the finished frames
+		static void newFrame();
+		// open a zone (returns the index of the zone or -1 if the frame is not recording)
+		static int beginZone(const char* name);
+		// close a zone opened with beginZone
+		static void endZone(int zone);
+		// check if the driver supports timestamp queries
+		static bool isSupported();
+		// get the number of frames that were not profiled because the GPU was too far behind
+		static inline ulong getSkippedFrames() { return skippedFrames; }
+		// delete every query object (call before the context is destroyed)
+		static void shutdown();
+	};
+
+	// bndr::GPUProfileScope
+	// Description: Records a GPU zone from its construction until the end of the scope (use BNDR_PROFILE_GPU_SCOPE)
+	class BNDR_API GPUProfileScope {
+
+		int zone;
+
+	public:
+
+		GPUProfileScope(const char* zoneName) : zone(GPUProfiler::beginZone(zoneName)) {}
+		GPUProfileScope(const GPUProfileScope&) = delete;
+		GPUProfileScope& operator=(const GPUProfileScope&) = delete;
+		~GPUProfileScope() { GPUProfiler::endZone(zone); }
+	};
+}
+
+#ifdef BNDR_PROFILE
+// profile the GPU work issued in the rest of the enclosing scope
+#define BNDR_PROFILE_GPU_SCOPE(name) ::bndr::GPUProfileScope BNDR_PROFILE_CONCAT(bndrGPUProfileScope, __LINE__)(name)
+// start a new GPU frame
+#define BNDR_PROFILE_GPU_FRAME() ::bndr::GPUProfiler::newFrame()
+#else
+#define BNDR_PROFILE_GPU_SCOPE(name)
+#define BNDR_PROFILE_GPU_FRAME()
+#endif
@@ -0,0 +1,312 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "profiler.h"
+
+namespace bndr {
+
+	std::mutex Profiler::registryMutex;
+	std::vector<Profiler::ThreadBuffer*> Profiler::threadBuffers;
+	long long Profiler::frameStarts[Profiler::FRAME_CAPACITY];
+	std::atomic<unsigned long long> Profiler::frameCount(0);
+	long long Profiler::epoch = Profiler::now();
+
+	Profiler::ThreadBuffer* Profiler::getThreadBuffer() {
+
+		// each thread looks its buffer up once, the buffers are never freed so late readers stay valid
+		static thread_local ThreadBuffer* localBuffer = nullptr;
+		if (localBuffer == nullptr) {
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			localBuffer = new ThreadBuffer((uint)threadBuffers.size());
+			threadBuffers.push_back(localBuffer);
+		}
+		return localBuffer;
+	}
+
+	Profiler::ThreadBuffer* Profiler::registerTimeline(const char* name) {
+
+		std::lock_guard<std::mutex> lock(registryMutex);
+		ThreadBuffer* buffer = new ThreadBuffer((uint)threadBuffers.size(), name);
+		threadBuffers.push_back(buffer);
+		return buffer;
+	}
+
+	void Profiler::setThreadName(const char* name) {
+
+		ThreadBuffer* buffer = getThreadBuffer();
+		std::lock_guard<std::mutex> lock(registryMutex);
+		buffer->threadName = name;
+	}
+
+	void Profiler::markFrame() {
+
+		unsigned long long count = frameCount.load(std::memory_order_relaxed);
+		frameStarts[count % FRAME_CAPACITY] = now();
+		frameCount.store(count + 1, std::memory_order_release);
+	}
+
+	void Profiler::copyZones(ThreadBuffer* buffer, std::vector<ProfileZone>& zones) {
+
+		unsigned long long count = buffer->writeCount.load(std::memory_order_acquire);
+		unsigned long long first = (count > ZONE_CAPACITY) ? count - ZONE_CAPACITY : 0;
+		zones.clear();
+		for (unsigned long long i = first; i < count; i++) {
+
+			zones.push_back(buffer->zones[i & (ZONE_CAPACITY - 1)]);
+		}
+		// the owning thread keeps writing while we copy, so drop the zones whose slots may have been reused meanwhile
+		unsigned long long newCount = buffer->writeCount.load(std::memory_order_acquire);
+		if (newCount + 1 > first + ZONE_CAPACITY) {
+
+			unsigned long long overwritten = newCount + 1 - ZONE_CAPACITY - first;
+			zones.erase(zones.begin(), zones.begin() + (size_t)std::min<unsigned long long>(overwritten, zones.size()));
+		}
+	}
+
+	std::vector<ProfileTreeNode> Profiler::buildFrameTree(int framesAgo) {
+
+		std::vector<ProfileTreeNode> tree;
+		unsigned long long count = getFrameCount();
+		// a frame is finished once the next frame has been marked, and only FRAME_CAPACITY markers are kept
+		if (framesAgo < 1 || (unsigned long long)framesAgo + 1 > count || framesAgo + 1 > FRAME_CAPACITY) {
+
+			return tree;
+		}
+		unsigned long long frame = count - 1 - (unsigned long long)framesAgo;
+		long long frameStart = frameStarts[frame % FRAME_CAPACITY];
+		long long frameEnd = frameStarts[(frame + 1) % FRAME_CAPACITY];
+
+		std::vector<ThreadBuffer*> buffers;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffers = threadBuffers;
+		}
+
+		// aggregation node (children are merged by name so a zone called 1000 times in a loop is a single line)
+		struct AggregateNode {
+
+			const char* name;
+			std::vector<int> children;
+			int calls;
+			long long total;
+		};
+		std::vector<ProfileZone> zones;
+		for (ThreadBuffer* buffer : buffers) {
+
+			copyZones(buffer, zones);
+			zones.erase(std::remove_if(zones.begin(), zones.end(), [=](const ProfileZone& zone) { return zone.start < frameStart || zone.start >= frameEnd; }), zones.end());
+			if (zones.empty()) {
+
+				continue;
+			}
+			// zones are stored when they end, sort them by start so that parents come before their children
+			std::sort(zones.begin(), zones.end(), [](const ProfileZone& a, const ProfileZone& b) { return (a.start != b.start) ? a.start < b.start : a.depth < b.depth; });
+
+			std::vector<AggregateNode> nodes;
+			nodes.push_back({ "", std::vector<int>(), 0, 0 });
+			// stack of (end time, node) of the zones that enclose the current one
+			std::vector<std::pair<long long, int>> stack;
+			for (const ProfileZone& zone : zones) {
+
+				while (!stack.empty() && zone.start >= stack.back().first) {
+
+					stack.pop_back();
+				}
+				int parent = stack.empty() ? 0 : stack.back().second;
+				int node = -1;
+				for (int child : nodes[parent].children) {
+
+					if (strcmp(nodes[child].name, zone.name) == 0) {
+
+						node = child;
+						break;
+					}
+				}
+				if (node == -1) {
+
+					node = (int)nodes.size();
+					nodes.push_back({ zone.name, std::vector<int>(), 0, 0 });
+					nodes[parent].children.push_back(node);
+				}
+				nodes[node].calls++;
+				nodes[node].total += zone.end - zone.start;
+				stack.push_back(std::make_pair(zone.end, node));
+			}
+
+			// flatten the tree depth first
+			std::vector<std::pair<int, int>> pending;
+			for (int i = (int)nodes[0].children.size() - 1; i >= 0; i--) {
+
+				pending.push_back(std::make_pair(nodes[0].children[i], 0));
+			}
+			while (!pending.empty()) {
+
+				std::pair<int, int> current = pending.back();
+				pending.pop_back();
+				const AggregateNode& node = nodes[current.first];
+				long long childTime = 0;
+				for (int child : node.children) {
+
+					childTime += nodes[child].total;
+				}
+				ProfileTreeNode treeNode;
+				treeNode.name = node.name;
+				treeNode.threadName = buffer->threadName;
+				treeNode.depth = current.second;
+				treeNode.calls = node.calls;
+				treeNode.totalTime = (float)node.total * 0.000001f;
+				treeNode.selfTime = (float)(node.total - childTime) * 0.000001f;
+				tree.push_back(treeNode);
+				for (int i = (int)node.children.size() - 1; i >= 0; i--) {
+
+					pending.push_back(std::make_pair(node.children[i], current.second + 1));
+				}
+			}
+		}
+		return tree;
+	}
+
+	void Profiler::printFrameTree(int framesAgo) {
+
+		std::vector<ProfileTreeNode> tree = buildFrameTree(framesAgo);
+		std::string threadName;
+		for (const ProfileTreeNode& node : tree) {
+
+			if (node.threadName != threadName) {
+
+				threadName = node.threadName;
+				std::cout << "[" << threadName << "]\n";
+			}
+			std::cout << std::string((node.depth + 1) * 2, ' ') << node.name << " x" << node.calls << " total: " << node.totalTime
+				<< "ms self: " << node.selfTime << "ms\n";
+		}
+	}
+
+	void Profiler::writeJSONString(std::ostream& stream, const std::string& text) {
+
+		stream << '"';
+		for (char c : text) {
+
+			if (c == '"' || c == '\\') {
+
+				stream << '\\' << c;
+			}
+			else if ((unsigned char)c < 0x20) {
+
+				stream << ' ';
+			}
+			else {
+
+				stream << c;
+			}
+		}
+		stream << '"';
+	}
+
+	std::vector<ThreadZones> Profiler::snapshot(long long from, long long to) {
+
+		std::vector<ThreadBuffer*> buffers;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffers = threadBuffers;
+		}
+		std::vector<ThreadZones> threads;
+		std::vector<ProfileZone> zones;
+		for (ThreadBuffer* buffer : buffers) {
+
+			copyZones(buffer, zones);
+			ThreadZones thread;
+			thread.threadID = buffer->threadID;
+			thread.threadName = buffer->threadName;
+			for (const ProfileZone& zone : zones) {
+
+				if (zone.start >= from && zone.start < to) {
+
+					thread.zones.push_back(zone);
+				}
+			}
+			threads.push_back(std::move(thread));
+		}
+		return threads;
+	}
+
+	void Profiler::exportChromeTrace(const char* filePath) {
+
+		std::ofstream file(filePath);
+		if (!file.is_open()) {
+
+			std::string message = "Failed to open '" + std::string(filePath) + "' for the profiler trace";
+			BNDR_EXCEPTION(message.c_str());
+		}
+
+		std::vector<ThreadBuffer*> buffers;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffers = threadBuffers;
+		}
+
+		// the trace event format wants microseconds
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		std::vector<ProfileZone> zones;
+		for (ThreadBuffer* buffer : buffers) {
+
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadID << ",\"args\":{\"name\":";
+			writeJSONString(file, buffer->threadName);
+			file << "}}";
+			first = false;
+
+			copyZones(buffer, zones);
+			for (const ProfileZone& zone : zones) {
+
+				file << ",\n{\"name\":";
+				writeJSONString(file, zone.name);
+				file << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadID << ",\"ts\":" << (double)(zone.start - epoch) * 0.001
+					<< ",\"dur\":" << (double)(zone.end - zone.start) * 0.001 << "}";
+			}
+		}
+
+		// frame markers as global instant events
+		unsigned long long count = getFrameCount();
+		unsigned long long firstFrame = (count > FRAME_CAPACITY) ? count - FRAME_CAPACITY : 0;
+		for (unsigned long long frame = firstFrame; frame < count; frame++) {
+
+			file << (first ? "" : ",\n") << "{\"name\":\"frame " << frame << "\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":"
+				<< (double)(frameStarts[frame % FRAME_CAPACITY] - epoch) * 0.001 << "}";
+			first = false;
+		}
+		file << "\n]}\n";
+	}
+
+	void Profiler::clear() {
+
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (ThreadBuffer* buffer : threadBuffers) {
+
+			buffer->writeCount.store(0, std::memory_order_release);
+		}
+		frameCount.store(0, std::memory_order_release);
+		epoch = now();
+	}
+}
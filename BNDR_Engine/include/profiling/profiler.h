@@ -0,0 +1,194 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	// a finished zone (times in nanoseconds of the steady clock)
+	struct ProfileZone {
+
+		// the name passed to BNDR_PROFILE_SCOPE (must be a string literal or otherwise outlive the profiler)
+		const char* name;
+		long long start;
+		long long end;
+		// the nesting depth of the zone on its thread (0 for top level zones)
+		int depth;
+	};
+
+	// a node of the aggregated per frame tree
+	struct ProfileTreeNode {
+
+		const char* name;
+		// the name of the thread the zone ran on
+		std::string threadName;
+		int depth;
+		// how many times the zone ran under the same parent during the frame
+		int calls;
+		// the total time in milliseconds (including children) and the time not spent in child zones
+		float totalTime;
+		float selfTime;
+	};
+
+	// the zones of one thread (or timeline) copied out of the profiler
+	struct ThreadZones {
+
+		uint threadID;
+		std::string threadName;
+		std::vector<ProfileZone> zones;
+	};
+
+	// bndr::Profiler
+	// Description: Static hierarchical CPU profiler. Every thread that enters a zone gets its own ring of zones
+	// (registered once with a lock, after that recording a zone is two clock reads and a store with no locking).
+	// The main thread marks frame boundaries so the zones can be shown per frame as an aggregated tree, and everything
+	// recorded can be exported as Chrome trace event JSON (open it with chrome://tracing or ui.perfetto.dev).
+	// Zones are recorded with the BNDR_PROFILE_SCOPE macro which compiles to nothing unless BNDR_PROFILE is defined, the few
+	// coarse zones marked with BNDR_FLIGHT_SCOPE are recorded in every build for bndr::FlightRecorder
+	class BNDR_API Profiler {
+
+	public:
+
+		// the number of zones each thread keeps (older zones are overwritten)
+		static const int ZONE_CAPACITY = 1 << 16;
+		// the number of frame markers kept
+		static const int FRAME_CAPACITY = 1024;
+
+		// the per thread ring of zones (only the owning thread writes to it)
+		struct ThreadBuffer {
+
+			uint threadID;
+			std::string threadName;
+			ProfileZone zones[ZONE_CAPACITY];
+			// the total number of zones written (the writer publishes with release, readers load with acquire)
+			std::atomic<unsigned long long> writeCount;
+			// the current nesting depth
+			int depth = 0;
+			ThreadBuffer(uint id) : threadID(id), threadName("thread " + std::to_string(id)), writeCount(0) {}
+			ThreadBuffer(uint id, const char* name) : threadID(id), threadName(name), writeCount(0) {}
+		};
+
+	private:
+
+		static std::mutex registryMutex;
+		static std::vector<ThreadBuffer*> threadBuffers;
+		// start times of the frames (written by the thread that calls markFrame)
+		static long long frameStarts[FRAME_CAPACITY];
+		static std::atomic<unsigned long long> frameCount;
+		// the time the profiler started (subtracted from exported timestamps)
+		static long long epoch;
+
+		// collect a copy of the zones of a thread that are still in its ring
+		static void copyZones(ThreadBuffer* buffer, std::vector<ProfileZone>& zones);
+
+	public:
+
+		// get the current time in nanoseconds
+		static inline long long now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+		// get the buffer of the calling thread (registers the thread the first time)
+		static ThreadBuffer* getThreadBuffer();
+		// register a buffer for a timeline that is not a cpu thread (i.e. the GPU), only one thread may record into it
+		static ThreadBuffer* registerTimeline(const char* name);
+		// append a finished zone to a buffer (only the thread that owns the buffer may call this)
+		static inline void recordZone(ThreadBuffer* buffer, const char* name, long long start, long long end, int depth) {
+
+			// only the owner writes to the buffer, so a relaxed load is enough to find the slot
+			unsigned long long index = buffer->writeCount.load(std::memory_order_relaxed);
+			ProfileZone& zone = buffer->zones[index & (ZONE_CAPACITY - 1)];
+			zone.name = name;
+			zone.start = start;
+			zone.end = end;
+			zone.depth = depth;
+			buffer->writeCount.store(index + 1, std::memory_order_release);
+		}
+		// name the calling thread in reports and traces
+		static void setThreadName(const char* name);
+		// record the start of a new frame (called by Window::update)
+		static void markFrame();
+		// get the number of frames marked so far
+		static inline unsigned long long getFrameCount() { return frameCount.load(std::memory_order_acquire); }
+		// build the aggregated tree of every zone that started during a finished frame (1 is the last finished frame)
+		static std::vector<ProfileTreeNode> buildFrameTree(int framesAgo = 1);
+		// print the aggregated tree of a finished frame
+		static void printFrameTree(int framesAgo = 1);
+		// copy the zones of every thread that started in [from, to) (nanoseconds of the steady clock)
+		static std::vector<ThreadZones> snapshot(long long from, long long to);
+		// get the time the profiler started (trace timestamps are relative to it)
+		static inline long long getEpoch() { return epoch; }
+		// write everything still in the buffers to a Chrome trace event JSON file
+		static void exportChromeTrace(const char* filePath);
+		// write a string as a JSON string literal
+		static void writeJSONString(std::ostream& stream, const std::string& text);
+		// drop every recorded zone and frame marker (only call this while no other thread is inside a zone)
+		static void clear();
+	};
+
+	// bndr::ProfileScope
+	// Description: Records a zone from its construction until the end of the scope (use BNDR_PROFILE_SCOPE instead of
+	// creating it directly so that it compiles out when profiling is disabled)
+	class BNDR_API ProfileScope {
+
+		const char* name;
+		long long start;
+		Profiler::ThreadBuffer* buffer;
+
+	public:
+
+		ProfileScope(const char* zoneName) : name(zoneName), buffer(Profiler::getThreadBuffer()) {
+
+			buffer->depth++;
+			start = Profiler::now();
+		}
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+		~ProfileScope() {
+
+			long long end = Profiler::now();
+			buffer->depth--;
+			Profiler::recordZone(buffer, name, start, end, buffer->depth);
+		}
+	};
+}
+
+#define BNDR_PROFILE_CONCAT_INNER(a, b) a##b
+#define BNDR_PROFILE_CONCAT(a, b) BNDR_PROFILE_CONCAT_INNER(a, b)
+
+// profile the rest of the enclosing scope in every build (only for zones that run a few times per frame, the flight
+// recorder dumps them even when BNDR_PROFILE is not defined)
+#define BNDR_FLIGHT_SCOPE(name) ::bndr::ProfileScope BNDR_PROFILE_CONCAT(bndrFlightScope, __LINE__)(name)
+
+#ifdef BNDR_PROFILE
+// profile the rest of the enclosing scope
+#define BNDR_PROFILE_SCOPE(name) ::bndr::ProfileScope BNDR_PROFILE_CONCAT(bndrProfileScope, __LINE__)(name)
+// profile the rest of the enclosing function
+#define BNDR_PROFILE_FUNCTION() BNDR_PROFILE_SCOPE(__FUNCTION__)
+// mark the start of a new frame
+#define BNDR_PROFILE_FRAME() ::bndr::Profiler::markFrame()
+// name the calling thread in reports and traces
+#define BNDR_PROFILE_THREAD(name) ::bndr::Profiler::setThreadName(name)
+#else
+#define BNDR_PROFILE_SCOPE(name)
+#define BNDR_PROFILE_FUNCTION()
+#define BNDR_PROFILE_FRAME()
+#define BNDR_PROFILE_THREAD(name)
+#endif
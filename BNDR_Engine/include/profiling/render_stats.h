@@ -0,0 +1,64 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	// the render work of one frame
+	struct RenderCounters {
+
+		// glDrawArrays/glDrawElements calls
+		uint drawCalls = 0;
+		// program, vertex array, buffer and texture binds plus uniform uploads sent to the driver
+		uint stateChanges = 0;
+		// binds skipped by bndr::GLState because the state was already set
+		uint elidedCalls = 0;
+		// bytes of vertex, index and texture data sent to the GPU
+		unsigned long long bytesUploaded = 0;
+	};
+
+	// bndr::RenderStats
+	// Description: Always on counters of the render work issued by the engine (a few integer increments per draw).
+	// The counters accumulate until takeFrame() returns and resets them, which bndr::FlightRecorder does once per frame.
+	// Only the thread that owns the OpenGL context may touch the counters
+	class BNDR_API RenderStats {
+
+		static RenderCounters counters;
+
+	public:
+
+		// count a draw call
+		static inline void addDrawCall() { counters.drawCalls++; }
+		// count a change of GPU state
+		static inline void addStateChange() { counters.stateChanges++; }
+		// count a redundant call that was skipped
+		static inline void addElidedCall() { counters.elidedCalls++; }
+		// count bytes uploaded to the GPU
+		static inline void addBytesUploaded(unsigned long long bytes) { counters.bytesUploaded += bytes; }
+		// get the counters without resetting them
+		static inline const RenderCounters& getCounters() { return counters; }
+		// get the counters accumulated since the last call and reset them
+		static RenderCounters takeFrame();
+	};
+}
@@ -0,0 +1,205 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "tasks.h"
+
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L) || __cplusplus >= 202002L
+namespace bndr {
+
+	TaskID TaskScheduler::spawn(Task&& task) {
+
+		if (!task.coroutine) {
+
+			BNDR_EXCEPTION("Cannot spawn a task that was moved from or already spawned");
+		}
+		Task::handle coroutine = std::exchange(task.coroutine, nullptr);
+		TaskID id = nextID++;
+		coroutine.promise().scheduler = this;
+		coroutine.promise().id = id;
+		tasks.insert(std::make_pair(id, coroutine));
+		resume(id);
+		return id;
+	}
+
+	void TaskScheduler::resume(TaskID id) {
+
+		// the task may have been cancelled while it waited
+		std::unordered_map<TaskID, Task::handle>::iterator task = tasks.find(id);
+		if (task == tasks.end()) {
+
+			return;
+		}
+		Task::handle coroutine = task->second;
+		runningTasks.push_back(std::make_pair(id, false));
+		coroutine.resume();
+		bool cancelled = runningTasks.back().second;
+		runningTasks.pop_back();
+
+		if (cancelled || coroutine.done()) {
+
+			std::exception_ptr exception = coroutine.promise().exception;
+			tasks.erase(id);
+			coroutine.destroy();
+			if (exception) {
+
+				std::rethrow_exception(exception);
+			}
+		}
+	}
+
+	void TaskScheduler::resumeCatching(TaskID id, std::exception_ptr& failure) {
+
+		try {
+
+			resume(id);
+		}
+		catch (...) {
+
+			if (!failure) {
+
+				failure = std::current_exception();
+			}
+		}
+	}
+
+	void TaskScheduler::update(float deltaTime) {
+
+		time += (double)deltaTime;
+		// a throwing task must not leave the swapped lists half processed (the rest would be resumed twice or never)
+		std::exception_ptr failure;
+
+		// tasks that await nextFrame() again while being resumed go into the fresh list and wait for the next update
+		resumingTasks.swap(nextFrameTasks);
+		for (TaskID id : resumingTasks) {
+
+			resumeCatching(id, failure);
+		}
+		resumingTasks.clear();
+
+		// only the tasks at the front of the queue are touched
+		while (!wakeQueue.empty() && wakeQueue.top().time <= time) {
+
+			TaskID id = wakeQueue.top().id;
+			wakeQueue.pop();
+			resumeCatching(id, failure);
+		}
+
+		checkingTasks.swap(predicateTasks);
+		for (std::pair<TaskID, std::function<bool()>>& waiting : checkingTasks) {
+
+			if (!isRunning(waiting.first)) {
+
+				continue;
+			}
+			bool ready = false;
+			try {
+
+				ready = waiting.second();
+			}
+			catch (...) {
+
+				// the predicate would throw again every frame, so its task is given up
+				if (!failure) {
+
+					failure = std::current_exception();
+				}
+				cancel(waiting.first);
+				continue;
+			}
+			if (ready) {
+
+				resumeCatching(waiting.first, failure);
+			}
+			else {
+
+				predicateTasks.push_back(std::move(waiting));
+			}
+		}
+		checkingTasks.clear();
+
+		if (failure) {
+
+			std::rethrow_exception(failure);
+		}
+	}
+
+	bool TaskScheduler::cancel(TaskID id) {
+
+		std::unordered_map<TaskID, Task::handle>::iterator task = tasks.find(id);
+		if (task == tasks.end()) {
+
+			return false;
+		}
+		// a task cannot be destroyed while it runs (or while a task it spawned runs), so it is destroyed once it suspends
+		for (std::pair<TaskID, bool>& running : runningTasks) {
+
+			if (running.first == id) {
+
+				running.second = true;
+				return true;
+			}
+		}
+		Task::handle coroutine = task->second;
+		tasks.erase(task);
+		coroutine.destroy();
+		return true;
+	}
+
+	void TaskScheduler::cancelAll() {
+
+		std::vector<TaskID> ids;
+		for (const std::pair<const TaskID, Task::handle>& task : tasks) {
+
+			ids.push_back(task.first);
+		}
+		for (TaskID id : ids) {
+
+			cancel(id);
+		}
+	}
+
+	void TaskScheduler::waitFrame(TaskID id) {
+
+		nextFrameTasks.push_back(id);
+	}
+
+	void TaskScheduler::waitSeconds(TaskID id, float delay) {
+
+		WakeEntry entry;
+		entry.time = time + (double)delay;
+		entry.sequence = nextSequence++;
+		entry.id = id;
+		wakeQueue.push(entry);
+	}
+
+	void TaskScheduler::waitUntil(TaskID id, std::function<bool()>&& predicate) {
+
+		predicateTasks.push_back(std::make_pair(id, std::move(predicate)));
+	}
+
+	TaskScheduler::~TaskScheduler() {
+
+		cancelAll();
+	}
+}
+#endif
@@ -0,0 +1,202 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+// coroutines need C++20 (the engine is built with /std:c++20, applications on an older standard simply do not get tasks)
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L) || __cplusplus >= 202002L
+#include <coroutine>
+#include <exception>
+
+namespace bndr {
+
+	class TaskScheduler;
+	// identifies a task spawned in a bndr::TaskScheduler (0 is never a valid id)
+	typedef unsigned long long TaskID;
+
+	// bndr::Task
+	// Description: The return type of a gameplay coroutine. A task does nothing until it is handed to a bndr::TaskScheduler
+	// with spawn(), after that it runs until its first co_await and is resumed by the scheduler when what it awaits happens.
+	// A suspended task costs no per frame work (except tasks waiting on bndr::until, whose predicate is checked every frame).
+	// Usage:
+	//        bndr::Task blink(bndr::BasicRect* rect) {
+	//            while (true) {
+	//                rect->setFillColor(bndr::RED);
+	//                co_await bndr::seconds(0.5f);
+	//                rect->setFillColor(bndr::WHITE);
+	//                co_await bndr::seconds(0.5f);
+	//            }
+	//        }
+	//        scheduler.spawn(blink(&rect));
+	class Task {
+
+	public:
+
+		struct promise_type {
+
+			// the scheduler running the task and the id it was given (set by spawn)
+			TaskScheduler* scheduler = nullptr;
+			TaskID id = 0;
+			// an exception that escaped the task (rethrown by the scheduler)
+			std::exception_ptr exception;
+
+			Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			// tasks start suspended so that they only run inside a scheduler
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			// the scheduler destroys finished tasks
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { exception = std::current_exception(); }
+		};
+		using handle = std::coroutine_handle<promise_type>;
+
+	private:
+
+		handle coroutine;
+		explicit Task(handle taskCoroutine) : coroutine(taskCoroutine) {}
+		friend class TaskScheduler;
+
+	public:
+
+		Task(const Task&) = delete;
+		Task(Task&& task) noexcept : coroutine(std::exchange(task.coroutine, nullptr)) {}
+		Task& operator=(const Task&) = delete;
+		Task& operator=(Task&& task) noexcept {
+
+			if (this != &task) {
+
+				if (coroutine) { coroutine.destroy(); }
+				coroutine = std::exchange(task.coroutine, nullptr);
+			}
+			return *this;
+		}
+		// destroys the coroutine if it was never spawned
+		~Task() { if (coroutine) { coroutine.destroy(); } }
+	};
+
+	// bndr::TaskScheduler
+	// Description: Resumes tasks once per frame. Sleeping tasks wait in a queue sorted by wake time, so update() only
+	// touches the tasks that wake up this frame, the tasks waiting for the next frame and the tasks waiting on a predicate
+	class BNDR_API TaskScheduler {
+
+		// a task sleeping until a point in time
+		struct WakeEntry {
+
+			double time;
+			// keeps tasks that wake at the same time in the order they went to sleep
+			unsigned long long sequence;
+			TaskID id;
+		};
+		struct WakesLater {
+
+			bool operator()(const WakeEntry& a, const WakeEntry& b) const { return (a.time != b.time) ? a.time > b.time : a.sequence > b.sequence; }
+		};
+
+		std::priority_queue<WakeEntry, std::vector<WakeEntry>, WakesLater> wakeQueue;
+		// tasks waiting for the next frame (the second vector is swapped in while they are resumed)
+		std::vector<TaskID> nextFrameTasks;
+		std::vector<TaskID> resumingTasks;
+		// tasks waiting for a predicate to become true
+		std::vector<std::pair<TaskID, std::function<bool()>>> predicateTasks;
+		std::vector<std::pair<TaskID, std::function<bool()>>> checkingTasks;
+		// every live task (the wait queues only hold ids, so cancelled tasks are skipped when their entry comes up)
+		std::unordered_map<TaskID, Task::handle> tasks;
+		// the time in seconds since the scheduler was created
+		double time = 0.0;
+		TaskID nextID = 1;
+		unsigned long long nextSequence = 0;
+		// the tasks being resumed, innermost last (a task that spawns another is still running while the new one runs),
+		// and whether each was cancelled while it ran
+		std::vector<std::pair<TaskID, bool>> runningTasks;
+
+		// resume a task and destroy it if it finished (rethrows exceptions that escaped the task)
+		void resume(TaskID id);
+		// resume a task and keep the first exception that escapes it in failure instead of throwing
+		void resumeCatching(TaskID id, std::exception_ptr& failure);
+
+	public:
+
+		TaskScheduler() {}
+		TaskScheduler(const TaskScheduler&) = delete;
+		TaskScheduler& operator=(const TaskScheduler&) = delete;
+		// take ownership of a task and run it until its first co_await
+		TaskID spawn(Task&& task);
+		// advance the time and resume every task that is due (call once per frame)
+		// every due task is resumed even if one throws, the first exception is rethrown at the end of the update
+		// (a task whose until() predicate throws is cancelled)
+		void update(float deltaTime);
+		// destroy a task (its locals are destroyed as if it returned at its current co_await)
+		bool cancel(TaskID id);
+		// destroy every task
+		void cancelAll();
+		// check if a task has neither finished nor been cancelled
+		inline bool isRunning(TaskID id) const { return tasks.find(id) != tasks.end(); }
+		// get the number of live tasks
+		inline int getTaskCount() const { return (int)tasks.size(); }
+		// get the time in seconds since the scheduler was created
+		inline double getTime() const { return time; }
+		// (used by the awaitables) resume a task on the next update
+		void waitFrame(TaskID id);
+		// (used by the awaitables) resume a task once delay seconds have passed
+		void waitSeconds(TaskID id, float delay);
+		// (used by the awaitables) resume a task on the first update where the predicate returns true
+		void waitUntil(TaskID id, std::function<bool()>&& predicate);
+		// bndr::TaskScheduler::~TaskScheduler
+		// Description: Destroys every task that has not finished
+		~TaskScheduler();
+	};
+
+	// awaitable that resumes the task on the next frame
+	struct NextFrameAwaitable {
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(Task::handle coroutine) const { coroutine.promise().scheduler->waitFrame(coroutine.promise().id); }
+		void await_resume() const noexcept {}
+	};
+
+	// awaitable that resumes the task after a delay in seconds
+	struct SecondsAwaitable {
+
+		float delay;
+		bool await_ready() const noexcept { return delay <= 0.0f; }
+		void await_suspend(Task::handle coroutine) const { coroutine.promise().scheduler->waitSeconds(coroutine.promise().id, delay); }
+		void await_resume() const noexcept {}
+	};
+
+	// awaitable that resumes the task once a predicate returns true
+	struct UntilAwaitable {
+
+		std::function<bool()> predicate;
+		bool await_ready() const { return predicate(); }
+		void await_suspend(Task::handle coroutine) { coroutine.promise().scheduler->waitUntil(coroutine.promise().id, std::move(predicate)); }
+		void await_resume() const noexcept {}
+	};
+
+	// co_await bndr::nextFrame() to continue on the next frame
+	inline NextFrameAwaitable nextFrame() { return NextFrameAwaitable(); }
+	// co_await bndr::seconds(s) to continue after s seconds
+	inline SecondsAwaitable seconds(float delay) { return SecondsAwaitable{ delay }; }
+	// co_await bndr::until(predicate) to continue once the predicate returns true (checked once per frame)
+	inline UntilAwaitable until(std::function<bool()> predicate) { return UntilAwaitable{ std::move(predicate) }; }
+}
+#endif
@@ -0,0 +1,210 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "frame_stats.h"
+
+namespace bndr {
+
+	FrameStats::FrameStats(int capacity, float histogramLowerBound, int octaves, int bucketsInOctave)
+		: Clock(), frameTimes(), histogram(), histogramMin(histogramLowerBound), bucketsPerOctave((float)bucketsInOctave) {
+
+		if (capacity <= 0 || histogramLowerBound <= 0.0f || octaves <= 0 || bucketsInOctave <= 0) {
+
+			BNDR_EXCEPTION("FrameStats needs a positive capacity, histogram lower bound, octave count and buckets per octave");
+		}
+		frameTimes.resize(capacity, 0.0f);
+		scratch.reserve(capacity);
+		histogram.resize(octaves * bucketsInOctave, 0);
+	}
+
+	float FrameStats::beginFrame() {
+
+		// the first call only starts measuring
+		if (!clockStarted) {
+
+			clockStarted = true;
+			deltaTime();
+			return 0.0f;
+		}
+		float seconds = deltaTime();
+		addFrame(seconds);
+		return seconds;
+	}
+
+	void FrameStats::addFrame(float seconds) {
+
+		frameTimes[nextFrame] = seconds;
+		nextFrame = (nextFrame + 1) % (int)frameTimes.size();
+		if (storedFrames < (int)frameTimes.size()) {
+
+			storedFrames++;
+		}
+
+		// Welford's update of the lifetime mean and variance
+		totalFrames++;
+		double delta = (double)seconds - lifetimeMean;
+		lifetimeMean += delta / (double)totalFrames;
+		lifetimeM2 += delta * ((double)seconds - lifetimeMean);
+		lifetimeMax = std::max(lifetimeMax, seconds);
+
+		histogram[getBucket(seconds)]++;
+	}
+
+	int FrameStats::getBucket(float seconds) const {
+
+		if (seconds <= histogramMin) {
+
+			return 0;
+		}
+		int bucket = (int)(std::log2(seconds / histogramMin) * bucketsPerOctave);
+		return std::min(bucket, (int)histogram.size() - 1);
+	}
+
+	float FrameStats::getBucketLowerBound(int bucket) const {
+
+		return histogramMin * std::exp2((float)bucket / bucketsPerOctave);
+	}
+
+	FrameTimeSummary FrameStats::getSummary(int windowFrames) const {
+
+		FrameTimeSummary summary;
+		int count = (windowFrames <= 0 || windowFrames > storedFrames) ? storedFrames : windowFrames;
+		if (count == 0) {
+
+			return summary;
+		}
+
+		// copy the window out of the ring (newest frames first) while computing the mean and extremes
+		int capacity = (int)frameTimes.size();
+		scratch.resize(count);
+		double sum = 0.0;
+		float minTime = frameTimes[(nextFrame - 1 + capacity) % capacity];
+		float maxTime = minTime;
+		for (int i = 0; i < count; i++) {
+
+			float time = frameTimes[(nextFrame - 1 - i + 2 * capacity) % capacity];
+			scratch[i] = time;
+			sum += time;
+			minTime = std::min(minTime, time);
+			maxTime = std::max(maxTime, time);
+		}
+		double mean = sum / (double)count;
+		double squares = 0.0;
+		for (int i = 0; i < count; i++) {
+
+			double delta = (double)scratch[i] - mean;
+			squares += delta * delta;
+		}
+
+		summary.frameCount = count;
+		summary.mean = (float)mean;
+		summary.standardDeviation = (count > 1) ? (float)std::sqrt(squares / (double)(count - 1)) : 0.0f;
+		summary.min = minTime;
+		summary.max = maxTime;
+
+		// select the percentiles in increasing order so that each selection only partitions what is left above the previous one
+		int p50 = (int)(0.50f * (float)(count - 1) + 0.5f);
+		int p95 = (int)(0.95f * (float)(count - 1) + 0.5f);
+		int p99 = (int)(0.99f * (float)(count - 1) + 0.5f);
+		std::nth_element(scratch.begin(), scratch.begin() + p50, scratch.end());
+		summary.p50 = scratch[p50];
+		std::nth_element(scratch.begin() + p50, scratch.begin() + p95, scratch.end());
+		summary.p95 = scratch[p95];
+		std::nth_element(scratch.begin() + p95, scratch.begin() + p99, scratch.end());
+		summary.p99 = scratch[p99];
+		return summary;
+	}
+
+	float FrameStats::getPercentile(float percentile, int windowFrames) const {
+
+		int count = (windowFrames <= 0 || windowFrames > storedFrames) ? storedFrames : windowFrames;
+		if (count == 0) {
+
+			return 0.0f;
+		}
+		int capacity = (int)frameTimes.size();
+		scratch.resize(count);
+		for (int i = 0; i < count; i++) {
+
+			scratch[i] = frameTimes[(nextFrame - 1 - i + 2 * capacity) % capacity];
+		}
+		float clamped = std::min(std::max(percentile, 0.0f), 100.0f);
+		int rank = (int)(clamped * 0.01f * (float)(count - 1) + 0.5f);
+		std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.end());
+		return scratch[rank];
+	}
+
+	float FrameStats::getLastFrameTime() const {
+
+		if (storedFrames == 0) {
+
+			return 0.0f;
+		}
+		return frameTimes[(nextFrame - 1 + (int)frameTimes.size()) % (int)frameTimes.size()];
+	}
+
+	float FrameStats::getHistogramPercentile(float percentile) const {
+
+		if (totalFrames == 0) {
+
+			return 0.0f;
+		}
+		// walk the buckets until the requested share of frames is covered and interpolate inside that bucket
+		double target = (double)std::min(std::max(percentile, 0.0f), 100.0f) * 0.01 * (double)totalFrames;
+		double covered = 0.0;
+		for (int i = 0; i < (int)histogram.size(); i++) {
+
+			double next = covered + (double)histogram[i];
+			if (next >= target && histogram[i] > 0) {
+
+				float fraction = (float)((target - covered) / (double)histogram[i]);
+				float lower = getBucketLowerBound(i);
+				float upper = getBucketLowerBound(i + 1);
+				return std::min(lower + (upper - lower) * fraction, lifetimeMax);
+			}
+			covered = next;
+		}
+		return lifetimeMax;
+	}
+
+	void FrameStats::reset() {
+
+		std::fill(frameTimes.begin(), frameTimes.end(), 0.0f);
+		std::fill(histogram.begin(), histogram.end(), 0);
+		nextFrame = 0;
+		storedFrames = 0;
+		totalFrames = 0;
+		lifetimeMean = 0.0;
+		lifetimeM2 = 0.0;
+		lifetimeMax = 0.0f;
+		clockStarted = false;
+	}
+
+	void FrameStats::print(int windowFrames) const {
+
+		FrameTimeSummary summary = getSummary(windowFrames);
+		std::cout << "frames: " << summary.frameCount << " mean: " << summary.mean * 1000.0f << "ms stddev: " << summary.standardDeviation * 1000.0f
+			<< "ms p50: " << summary.p50 * 1000.0f << "ms p95: " << summary.p95 * 1000.0f << "ms p99: " << summary.p99 * 1000.0f
+			<< "ms max: " << summary.max * 1000.0f << "ms\n";
+	}
+}
@@ -0,0 +1,114 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "timers.h"
+
+namespace bndr {
+
+	// summary of the frame times over a window of recent frames (all times in seconds)
+	struct FrameTimeSummary {
+
+		// the number of frames the summary covers
+		int frameCount = 0;
+		float mean = 0.0f;
+		float standardDeviation = 0.0f;
+		float min = 0.0f;
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+	};
+
+	// bndr::FrameStats
+	// Description: Collects frame times so that percentiles can be read in game instead of computed offline from logs.
+	// The most recent frames are kept in a fixed size ring (percentiles over any window up to its capacity), the lifetime
+	// mean and variance are updated online, and every frame is counted in a log bucketed histogram (buckets grow by a
+	// constant factor, so a 1ms spike is as visible next to 16ms frames as a 10ms spike next to 160ms frames).
+	// Usage:
+	//        stats.beginFrame(); (or stats.addFrame(deltaTime) with your own clock)
+	//        FrameTimeSummary last5Seconds = stats.getSummary(300);
+	class BNDR_API FrameStats : protected Clock {
+
+		// ring of the most recent frame times
+		std::vector<float> frameTimes;
+		// the index the next frame time is written to
+		int nextFrame = 0;
+		// the number of valid frame times in the ring
+		int storedFrames = 0;
+		// lifetime statistics (Welford's online algorithm)
+		ulong totalFrames = 0;
+		double lifetimeMean = 0.0;
+		double lifetimeM2 = 0.0;
+		float lifetimeMax = 0.0f;
+		// histogram buckets (bucket 0 also counts everything below the lower bound, the last bucket everything above the top)
+		std::vector<ulong> histogram;
+		float histogramMin;
+		float bucketsPerOctave;
+		// scratch space for selecting percentiles so that queries never allocate
+		mutable std::vector<float> scratch;
+		// whether beginFrame has been called before (the first call only starts the clock)
+		bool clockStarted = false;
+
+	public:
+
+		// bndr::FrameStats::FrameStats
+		// Arguments:
+		//        capacity = The number of recent frames kept for percentiles
+		//        histogramLowerBound = The frame time in seconds where the first histogram bucket starts
+		//        octaves = The number of doublings of the frame time the histogram covers
+		//        bucketsInOctave = The number of histogram buckets per doubling of the frame time
+		// Description: Allocates the ring and the histogram up front (by default 0.25ms to ~1s in 48 buckets)
+		FrameStats(int capacity = 1024, float histogramLowerBound = 0.00025f, int octaves = 12, int bucketsInOctave = 4);
+		// measure the time since the last call with the internal clock and add it as a frame (returns the frame time)
+		float beginFrame();
+		// add a frame time in seconds
+		void addFrame(float seconds);
+		// get the summary of the most recent windowFrames frames (0 means the whole ring)
+		FrameTimeSummary getSummary(int windowFrames = 0) const;
+		// get the frame time at percentile (0.0f to 100.0f) of the most recent windowFrames frames
+		float getPercentile(float percentile, int windowFrames = 0) const;
+		// get the most recent frame time
+		float getLastFrameTime() const;
+		// get the lifetime number of frames
+		inline ulong getTotalFrames() const { return totalFrames; }
+		// get the lifetime mean frame time
+		inline float getLifetimeMean() const { return (float)lifetimeMean; }
+		// get the lifetime standard deviation of the frame time
+		inline float getLifetimeStandardDeviation() const { return (totalFrames > 1) ? (float)std::sqrt(lifetimeM2 / (double)(totalFrames - 1)) : 0.0f; }
+		// get the lifetime max frame time
+		inline float getLifetimeMax() const { return lifetimeMax; }
+		// get the lifetime histogram counts
+		inline const std::vector<ulong>& getHistogram() const { return histogram; }
+		// get the frame time where a histogram bucket starts (bucket getHistogram().size() gives the upper bound of the last)
+		float getBucketLowerBound(int bucket) const;
+		// get the bucket a frame time is counted in
+		int getBucket(float seconds) const;
+		// estimate a lifetime percentile from the histogram (accurate to one bucket)
+		float getHistogramPercentile(float percentile) const;
+		// forget every frame
+		void reset();
+		// print the summary of the most recent windowFrames frames
+		void print(int windowFrames = 0) const;
+	};
+}
@@ -0,0 +1,88 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "FrameBuffer.h"
+#include "GLState.h"
+
+namespace bndr {
+
+	FrameBuffer::FrameBuffer(int bufferWidth, int bufferHeight) : width(bufferWidth), height(bufferHeight) {
+
+		// create the color texture that the framebuffer renders into
+		GL_DEBUG_FUNC(glGenTextures(1, &colorTextureID));
+		GLState::bindTexture(GL_TEXTURE0, colorTextureID);
+		// the color texture is magnified onto the screen so filter it linearly and never repeat the edges
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		allocateStorage();
+
+		// create the framebuffer and attach the color texture to it
+		GL_DEBUG_FUNC(glGenFramebuffers(1, &bufferID));
+		bind();
+		GL_DEBUG_FUNC(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTextureID, 0));
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+
+			unbind();
+			BNDR_EXCEPTION("Failed to create a complete offscreen framebuffer");
+		}
+		unbind();
+	}
+
+	void FrameBuffer::allocateStorage() {
+
+		// the texture must already be bound
+		GL_DEBUG_FUNC(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+	}
+
+	void FrameBuffer::resize(int bufferWidth, int bufferHeight) {
+
+		// nothing to do if the size did not change
+		if (bufferWidth == width && bufferHeight == height) {
+
+			return;
+		}
+		width = bufferWidth;
+		height = bufferHeight;
+		GLState::bindTexture(GL_TEXTURE0, colorTextureID);
+		allocateStorage();
+	}
+
+	void FrameBuffer::blitToScreen(int srcWidth, int srcHeight, int dstWidth, int dstHeight) const {
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, bufferID);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		// nearest filtering is exact (and cheaper) when no scaling happens
+		uint filter = (srcWidth == dstWidth && srcHeight == dstHeight) ? GL_NEAREST : GL_LINEAR;
+		GL_DEBUG_FUNC(glBlitFramebuffer(0, 0, srcWidth, srcHeight, 0, 0, dstWidth, dstHeight, GL_COLOR_BUFFER_BIT, filter));
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	FrameBuffer::~FrameBuffer() {
+
+		glDeleteFramebuffers(1, &bufferID);
+		GLState::deleteTexture(colorTextureID);
+	}
+}
@@ -0,0 +1,77 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "GLDebug.h"
+
+namespace bndr {
+
+	// bndr::FrameBuffer
+	// Description: An offscreen render target with a single RGBA color attachment. Anything drawn while the FrameBuffer
+	// is bound ends up in its color texture instead of the window, which can then be copied (and scaled) to the screen
+	class FrameBuffer {
+
+		uint bufferID;
+		// the texture that stores the color attachment
+		uint colorTextureID;
+		// the allocated size of the color attachment in pixels
+		int width;
+		int height;
+
+		// (re)allocate the color attachment storage
+		void allocateStorage();
+
+	public:
+
+		// bndr::FrameBuffer::FrameBuffer
+		// Arguments:
+		//        bufferWidth = The width in pixels of the color attachment
+		//        bufferHeight = The height in pixels of the color attachment
+		// Description: Creates an OpenGL framebuffer object with a linearly filtered color texture attached to it
+		FrameBuffer(int bufferWidth, int bufferHeight);
+		// the copy constructor is not allowed
+		FrameBuffer(const FrameBuffer&) = delete;
+		// the move constructor is not allowed
+		FrameBuffer(FrameBuffer&&) = delete;
+		// assignment operator is not allowed
+		FrameBuffer& operator=(const FrameBuffer&) = delete;
+		// resize the color attachment (the previous contents are lost)
+		void resize(int bufferWidth, int bufferHeight);
+		// bind the framebuffer so that draw calls render into it
+		inline void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, bufferID); }
+		// bind the default framebuffer (the window) again
+		inline void unbind() const { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+		// copy the region (0, 0, srcWidth, srcHeight) of the color attachment onto the whole window framebuffer
+		// (linear filtering is used when the sizes differ)
+		void blitToScreen(int srcWidth, int srcHeight, int dstWidth, int dstHeight) const;
+		// get the width of the color attachment
+		inline int getWidth() const { return width; }
+		// get the height of the color attachment
+		inline int getHeight() const { return height; }
+		// get the id of the color texture
+		inline uint getColorTextureID() const { return colorTextureID; }
+		// bndr::FrameBuffer::~FrameBuffer
+		// Description: Deletes the framebuffer and its color texture from graphics memory
+		~FrameBuffer();
+	};
+}
@@ -0,0 +1,351 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "GLState.h"
+
+namespace bndr {
+
+	uint GLState::program = GLState::UNKNOWN;
+	uint GLState::vertexArray = GLState::UNKNOWN;
+	uint GLState::arrayBuffer = GLState::UNKNOWN;
+	uint GLState::elementBuffer = GLState::UNKNOWN;
+	uint GLState::uniformBuffer = GLState::UNKNOWN;
+	uint GLState::copyReadBuffer = GLState::UNKNOWN;
+	uint GLState::uniformBindings[GLState::MAX_UNIFORM_BINDINGS];
+	uint GLState::activeUnit = GLState::UNKNOWN;
+	uint GLState::textures[GLState::MAX_TEXTURE_UNITS];
+	uint GLState::textureArrays[GLState::MAX_TEXTURE_UNITS];
+	unsigned long long GLState::unitUses[GLState::MAX_TEXTURE_UNITS];
+	unsigned long long GLState::useCounter = 0;
+	int GLState::textureUnitCount = 0;
+	uint GLState::blending = GLState::UNKNOWN;
+	uint GLState::blendSource = GLState::UNKNOWN;
+	uint GLState::blendDestination = GLState::UNKNOWN;
+	uint GLState::blendEquation = GLState::UNKNOWN;
+
+	void GLState::invalidate() {
+
+		program = UNKNOWN;
+		vertexArray = UNKNOWN;
+		arrayBuffer = UNKNOWN;
+		elementBuffer = UNKNOWN;
+		uniformBuffer = UNKNOWN;
+		copyReadBuffer = UNKNOWN;
+		for (int i = 0; i < MAX_UNIFORM_BINDINGS; i++) {
+
+			uniformBindings[i] = UNKNOWN;
+		}
+		activeUnit = UNKNOWN;
+		for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+
+			textures[i] = UNKNOWN;
+			textureArrays[i] = UNKNOWN;
+			unitUses[i] = 0;
+		}
+		blending = UNKNOWN;
+		blendSource = UNKNOWN;
+		blendDestination = UNKNOWN;
+		blendEquation = UNKNOWN;
+	}
+
+	uint* GLState::getBufferShadow(uint target) {
+
+		switch (target) {
+
+		case GL_ARRAY_BUFFER: return &arrayBuffer;
+		case GL_ELEMENT_ARRAY_BUFFER: return &elementBuffer;
+		case GL_UNIFORM_BUFFER: return &uniformBuffer;
+		case GL_COPY_READ_BUFFER: return &copyReadBuffer;
+		default: return nullptr;
+		}
+	}
+
+	void GLState::useProgram(uint programID) {
+
+		if (program == programID) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		glUseProgram(programID);
+		program = programID;
+	}
+
+	void GLState::bindVertexArray(uint arrayID) {
+
+		if (vertexArray == arrayID) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		glBindVertexArray(arrayID);
+		vertexArray = arrayID;
+		elementBuffer = UNKNOWN;
+	}
+
+	void GLState::bindBuffer(uint target, uint bufferID) {
+
+		uint* shadow = getBufferShadow(target);
+		if (shadow != nullptr && *shadow == bufferID) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		glBindBuffer(target, bufferID);
+		if (shadow != nullptr) {
+
+			*shadow = bufferID;
+		}
+	}
+
+	void GLState::bindUniformBufferBase(uint bindingPoint, uint bufferID) {
+
+		bool shadowed = bindingPoint < (uint)MAX_UNIFORM_BINDINGS;
+		if (shadowed && uniformBindings[bindingPoint] == bufferID && uniformBuffer == bufferID) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, bufferID);
+		if (shadowed) {
+
+			uniformBindings[bindingPoint] = bufferID;
+		}
+		uniformBuffer = bufferID;
+	}
+
+	void GLState::activeTexture(uint unit) {
+
+		if (activeUnit == unit) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		glActiveTexture(unit);
+		activeUnit = unit;
+	}
+
+	void GLState::bindTexture(uint unit, uint textureID) {
+
+		uint index = unit - GL_TEXTURE0;
+		if (index < (uint)MAX_TEXTURE_UNITS) {
+
+			// a texture bound to a unit directly counts as used, so the allocator does not replace it right away
+			unitUses[index] = ++useCounter;
+			if (textures[index] == textureID) {
+
+				elide();
+				return;
+			}
+		}
+		activeTexture(unit);
+		RenderStats::addStateChange();
+		GL_DEBUG_FUNC(glBindTexture(GL_TEXTURE_2D, textureID));
+		if (index < (uint)MAX_TEXTURE_UNITS) {
+
+			textures[index] = textureID;
+		}
+	}
+
+	void GLState::bindTextureArray(uint unit, uint textureID) {
+
+		uint index = unit - GL_TEXTURE0;
+		if (index < (uint)MAX_TEXTURE_UNITS) {
+
+			// a texture bound to a unit directly counts as used, so the allocator does not replace it right away
+			unitUses[index] = ++useCounter;
+			if (textureArrays[index] == textureID) {
+
+				elide();
+				return;
+			}
+		}
+		activeTexture(unit);
+		RenderStats::addStateChange();
+		GL_DEBUG_FUNC(glBindTexture(GL_TEXTURE_2D_ARRAY, textureID));
+		if (index < (uint)MAX_TEXTURE_UNITS) {
+
+			textureArrays[index] = textureID;
+		}
+	}
+
+	int GLState::getTextureUnitCount() {
+
+		if (textureUnitCount == 0) {
+
+			int units = 0;
+			glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+			// the shadows only cover MAX_TEXTURE_UNITS units (every OpenGL 3.3 driver has at least 16)
+			textureUnitCount = (units > MAX_TEXTURE_UNITS) ? MAX_TEXTURE_UNITS : ((units <= FIRST_RESIDENT_UNIT) ? FIRST_RESIDENT_UNIT + 1 : units);
+		}
+		return textureUnitCount;
+	}
+
+	int GLState::acquireUnit(uint textureID, const uint* shadows, bool textureArray) {
+
+		int unitCount = getTextureUnitCount();
+		int leastRecent = FIRST_RESIDENT_UNIT;
+		for (int i = FIRST_RESIDENT_UNIT; i < unitCount; i++) {
+
+			if (shadows[i] == textureID) {
+
+				// still resident, not even the active unit has to change
+				unitUses[i] = ++useCounter;
+				elide();
+				return i;
+			}
+			if (unitUses[i] < unitUses[leastRecent]) {
+
+				leastRecent = i;
+			}
+		}
+		if (textureArray) {
+
+			bindTextureArray(GL_TEXTURE0 + leastRecent, textureID);
+		}
+		else {
+
+			bindTexture(GL_TEXTURE0 + leastRecent, textureID);
+		}
+		unitUses[leastRecent] = ++useCounter;
+		return leastRecent;
+	}
+
+	int GLState::acquireTextureUnit(uint textureID) {
+
+		return acquireUnit(textureID, textures, false);
+	}
+
+	int GLState::acquireTextureArrayUnit(uint textureID) {
+
+		return acquireUnit(textureID, textureArrays, true);
+	}
+
+	void GLState::setBlending(bool enable) {
+
+		uint value = enable ? 1 : 0;
+		if (blending == value) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		if (enable) {
+
+			glEnable(GL_BLEND);
+		}
+		else {
+
+			glDisable(GL_BLEND);
+		}
+		blending = value;
+	}
+
+	void GLState::setBlendFunc(uint source, uint destination) {
+
+		if (blendSource == source && blendDestination == destination) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		glBlendFunc(source, destination);
+		blendSource = source;
+		blendDestination = destination;
+	}
+
+	void GLState::setBlendEquation(uint equation) {
+
+		if (blendEquation == equation) {
+
+			elide();
+			return;
+		}
+		RenderStats::addStateChange();
+		glBlendEquation(equation);
+		blendEquation = equation;
+	}
+
+	void GLState::deleteProgram(uint programID) {
+
+		// a deleted program stays in use until another one is, but its name may be handed out again
+		if (program == programID) {
+
+			program = UNKNOWN;
+		}
+		glDeleteProgram(programID);
+	}
+
+	void GLState::deleteVertexArray(uint arrayID) {
+
+		if (vertexArray == arrayID) {
+
+			vertexArray = 0;
+			elementBuffer = UNKNOWN;
+		}
+		glDeleteVertexArrays(1, &arrayID);
+	}
+
+	void GLState::deleteBuffer(uint bufferID) {
+
+		uint* shadows[] = { &arrayBuffer, &elementBuffer, &uniformBuffer, &copyReadBuffer };
+		for (uint* shadow : shadows) {
+
+			if (*shadow == bufferID) {
+
+				*shadow = 0;
+			}
+		}
+		for (int i = 0; i < MAX_UNIFORM_BINDINGS; i++) {
+
+			if (uniformBindings[i] == bufferID) {
+
+				uniformBindings[i] = 0;
+			}
+		}
+		glDeleteBuffers(1, &bufferID);
+	}
+
+	void GLState::deleteTexture(uint textureID) {
+
+		for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+
+			if (textures[i] == textureID) {
+
+				textures[i] = 0;
+				unitUses[i] = 0;
+			}
+			if (textureArrays[i] == textureID) {
+
+				textureArrays[i] = 0;
+				unitUses[i] = 0;
+			}
+		}
+		glDeleteTextures(1, &textureID);
+	}
+}
@@ -0,0 +1,120 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "GLDebug.h"
+#include "../../profiling/render_stats.h"
+
+namespace bndr {
+
+	// bndr::GLState
+	// Description: Static shadow of the OpenGL state the engine binds (program, vertex array, buffers, texture units and
+	// blending). Every bind goes through it and is only sent to the driver when the value actually changes, the skipped
+	// calls are counted in RenderStats. Objects stay bound after use instead of being reset to 0, so consecutive surfaces
+	// that share a program, vertex array or texture cost no state calls at all. The shadow is only right if nothing binds
+	// behind its back, so code that calls OpenGL directly must call invalidate() afterwards.
+	// Textures drawn by surfaces are not bound to a fixed unit: acquireTextureUnit() keeps the most recently drawn textures
+	// resident across the texture units and replaces the least recently used one on a miss, so drawing the same few
+	// textures over and over binds nothing and the shader is told which unit to sample instead.
+	// Only the thread that owns the OpenGL context may use it
+	class BNDR_API GLState {
+
+		// the value of a binding that is not known (the next bind is always sent)
+		static const uint UNKNOWN = 0xFFFFFFFF;
+		static const int MAX_TEXTURE_UNITS = 32;
+		static const int MAX_UNIFORM_BINDINGS = 16;
+		// unit 0 is left to uploads and direct binds, the allocator hands out the units after it
+		static const int FIRST_RESIDENT_UNIT = 1;
+
+		static uint program;
+		static uint vertexArray;
+		static uint arrayBuffer;
+		// the element buffer is part of the vertex array state, so it is forgotten whenever the vertex array changes
+		static uint elementBuffer;
+		static uint uniformBuffer;
+		static uint copyReadBuffer;
+		static uint uniformBindings[MAX_UNIFORM_BINDINGS];
+		// the active unit as its GL_TEXTUREi enum
+		static uint activeUnit;
+		// the 2D texture bound to every unit
+		static uint textures[MAX_TEXTURE_UNITS];
+		// the 2D array texture bound to every unit (a unit has a separate binding per target)
+		static uint textureArrays[MAX_TEXTURE_UNITS];
+		// when every unit was last acquired (0 if never), the smallest one is replaced on a miss
+		static unsigned long long unitUses[MAX_TEXTURE_UNITS];
+		static unsigned long long useCounter;
+		// the units the allocator may use (GL_MAX_TEXTURE_IMAGE_UNITS capped to MAX_TEXTURE_UNITS, 0 until queried)
+		static int textureUnitCount;
+		// UNKNOWN, 0 or 1
+		static uint blending;
+		static uint blendSource;
+		static uint blendDestination;
+		static uint blendEquation;
+
+		// get the shadow of a generic buffer binding (nullptr for targets that are not shadowed)
+		static uint* getBufferShadow(uint target);
+		// count a skipped call
+		static inline void elide() { RenderStats::addElidedCall(); }
+		// find the unit a texture is resident on in the shadows of a target, or bind it to the least recently used unit
+		static int acquireUnit(uint textureID, const uint* shadows, bool textureArray);
+
+	public:
+
+		// forget every binding (called by the Window once its context exists, call it again after OpenGL was used directly)
+		static void invalidate();
+		// glUseProgram
+		static void useProgram(uint programID);
+		// get the program in use (0 if none, may be stale after invalidate())
+		static inline uint getProgram() { return program; }
+		// glBindVertexArray
+		static void bindVertexArray(uint arrayID);
+		// glBindBuffer (the array, element, uniform and copy read targets are shadowed)
+		static void bindBuffer(uint target, uint bufferID);
+		// glBindBufferBase for the uniform buffer target (also sets the generic binding like OpenGL does)
+		static void bindUniformBufferBase(uint bindingPoint, uint bufferID);
+		// glActiveTexture
+		static void activeTexture(uint unit);
+		// glActiveTexture + glBindTexture(GL_TEXTURE_2D) for a unit given as its GL_TEXTUREi enum
+		static void bindTexture(uint unit, uint textureID);
+		// glActiveTexture + glBindTexture(GL_TEXTURE_2D_ARRAY) for a unit given as its GL_TEXTUREi enum
+		static void bindTextureArray(uint unit, uint textureID);
+		// make a 2D texture resident on a unit and return the unit index for the sampler uniform (0 based, not GL_TEXTUREi)
+		// nothing is bound if the texture still is on the unit it got last time
+		static int acquireTextureUnit(uint textureID);
+		// make a 2D array texture resident on a unit and return the unit index for the sampler uniform
+		static int acquireTextureArrayUnit(uint textureID);
+		// get the number of units the allocator spreads textures over (queries the driver the first time)
+		static int getTextureUnitCount();
+		// glEnable/glDisable(GL_BLEND)
+		static void setBlending(bool enable);
+		// glBlendFunc
+		static void setBlendFunc(uint source, uint destination);
+		// glBlendEquation
+		static void setBlendEquation(uint equation);
+		// delete objects and drop them from the shadow (OpenGL unbinds deleted objects and may reuse their names)
+		static void deleteProgram(uint programID);
+		static void deleteVertexArray(uint arrayID);
+		static void deleteBuffer(uint bufferID);
+		static void deleteTexture(uint textureID);
+	};
+}
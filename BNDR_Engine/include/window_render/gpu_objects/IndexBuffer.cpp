@@ -22,6 +22,7 @@ SOFTWARE.*/
 
 #include "pch.h"
 #include "IndexBuffer.h"
+#include "../../profiling/render_stats.h"
 
 namespace bndr {
 
@@ -31,7 +32,8 @@ namespace bndr {
 		bind();
 		size = indexData.size();
 		GL_DEBUG_FUNC(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint) * size, (const void*)&indexData[0], GL_DYNAMIC_DRAW));
-		unbind();
+		RenderStats::addBytesUploaded(sizeof(uint) * size);
+		// the element buffer binding belongs to the vertex array being built, so it stays bound
 	}
 
 	IndexBuffer::IndexBuffer(const IndexBuffer& ib) {
@@ -41,22 +43,22 @@ namespace bndr {
 		std::unique_ptr<uint> data = ib.readData();
 		bind();
 		GL_DEBUG_FUNC(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint) * size, (const void*)data.get(), GL_DYNAMIC_DRAW));
-		unbind();
+		RenderStats::addBytesUploaded(sizeof(uint) * size);
 	}
 
 	std::unique_ptr<uint> IndexBuffer::readData() const {
 
 		uint* data = new uint[size];
-		bind();
-		GL_DEBUG_FUNC(glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size * sizeof(uint), (void*)data));
-		unbind();
+		// read through the copy target so the element buffer of the bound vertex array is left alone
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, bufferID);
+		GL_DEBUG_FUNC(glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size * sizeof(uint), (void*)data));
 		return std::unique_ptr<uint>(data);
 	}
 
 	void IndexBuffer::render(uint drawMode) {
 
-		bind();
+		// the vertex array being drawn already has this buffer bound
 		GL_DEBUG_FUNC(glDrawElements(drawMode, size, GL_UNSIGNED_INT, NULL));
-		unbind();
+		RenderStats::addDrawCall();
 	}
 }
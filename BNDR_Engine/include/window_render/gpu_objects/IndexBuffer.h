@@ -22,7 +22,7 @@ SOFTWARE.*/
 
 #pragma once
 #include <pch.h>
-#include "GLDebug.h"
+#include "GLState.h"
 
 namespace bndr {
 
@@ -43,16 +43,16 @@ namespace bndr {
 		// read from the buffer data in the GPU
 		std::unique_ptr<uint> readData() const;
 		// bind the buffer
-		inline void bind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferID); }
+		inline void bind() const { GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferID); }
 		// unbind the buffer
-		inline void unbind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
+		inline void unbind() const { GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
 		// returns the number of indices
 		inline uint getSize() { return size; }
 		// render the vertices using indices
 		void render(uint drawMode);
 		// bndr::IndexBuffer::~IndexBuffer()
 		// Description: Uses glDeleteBuffers to clear the buffer from graphics memory
-		~IndexBuffer() { glDeleteBuffers(1, &bufferID); }
+		~IndexBuffer() { GLState::deleteBuffer(bufferID); }
 	};
 }
 
@@ -0,0 +1,46 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "UniformBuffer.h"
+#include "../../profiling/render_stats.h"
+
+namespace bndr {
+
+	UniformBuffer::UniformBuffer(int sizeInBytes, uint binding) : size(sizeInBytes), bindingPoint(binding) {
+
+		glGenBuffers(1, &bufferID);
+		GLState::bindBuffer(GL_UNIFORM_BUFFER, bufferID);
+		GL_DEBUG_FUNC(glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW));
+	}
+
+	void UniformBuffer::write(const void* data, int sizeInBytes, int offset) {
+
+		if (offset < 0 || offset + sizeInBytes > size) {
+
+			BNDR_EXCEPTION("Uniform buffer write is out of range");
+		}
+		GLState::bindBuffer(GL_UNIFORM_BUFFER, bufferID);
+		GL_DEBUG_FUNC(glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeInBytes, data));
+		RenderStats::addBytesUploaded(sizeInBytes);
+	}
+}
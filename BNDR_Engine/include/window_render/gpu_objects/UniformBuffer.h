@@ -0,0 +1,89 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "GLState.h"
+
+// the GLSL declaration of the frame globals block (concatenate it into a shader source after the version line)
+// every member is read directly by name in the shader (i.e. aspect, viewport, time, view)
+#define BNDR_FRAME_GLOBALS_GLSL \
+	"layout (std140) uniform FrameGlobals {\n" \
+	"vec2 viewport;\n" \
+	"float aspect;\n" \
+	"float time;\n" \
+	"mat3 view;\n" \
+	"};\n"
+
+namespace bndr {
+
+	// the binding point of the frame globals block (programs attach their FrameGlobals block to it after linking)
+	const uint FRAME_GLOBALS_BINDING = 0;
+
+	// bndr::FrameGlobals
+	// Description: CPU mirror of the FrameGlobals block in std140 layout. The members are ordered so that no padding is
+	// needed except for the mat3, whose columns are each padded to a vec4 as std140 requires
+	struct FrameGlobals {
+
+		// the framebuffer size in pixels (offset 0)
+		float viewport[2];
+		// the height divided by the width of the framebuffer (offset 8), the surface shaders scale x by it
+		float aspect;
+		// seconds since the window was created (offset 12)
+		float time;
+		// the view transform applied to every surface after its own transform (offset 16, 3 columns of vec4)
+		float view[12];
+	};
+
+	// bndr::UniformBuffer
+	// Description: A uniform buffer object that holds state shared by many programs. The buffer is written with a single
+	// glBufferSubData and bound to a binding point, every program whose block is attached to that point reads it
+	class BNDR_API UniformBuffer {
+
+		uint bufferID;
+		// the size of the buffer in bytes
+		int size;
+		uint bindingPoint;
+
+	public:
+
+		// bndr::UniformBuffer::UniformBuffer
+		// Arguments:
+		//        sizeInBytes = The size of the block in bytes (std140 layout)
+		//        binding = The binding point the block is bound to
+		// Description: Creates the buffer with undefined contents
+		UniformBuffer(int sizeInBytes, uint binding);
+		UniformBuffer(const UniformBuffer&) = delete;
+		UniformBuffer(UniformBuffer&&) = delete;
+		UniformBuffer& operator=(const UniformBuffer&) = delete;
+		// write part of the buffer
+		void write(const void* data, int sizeInBytes, int offset = 0);
+		// bind the whole buffer to its binding point
+		inline void bind() const { GLState::bindUniformBufferBase(bindingPoint, bufferID); }
+		inline uint getID() const { return bufferID; }
+		inline int getSize() const { return size; }
+		inline uint getBindingPoint() const { return bindingPoint; }
+		// bndr::UniformBuffer::~UniformBuffer
+		// Description: Deletes the buffer
+		~UniformBuffer() { GLState::deleteBuffer(bufferID); }
+	};
+}
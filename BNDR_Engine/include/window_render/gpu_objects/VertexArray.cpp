@@ -22,6 +22,7 @@ SOFTWARE.*/
 
 #include <pch.h>
 #include "VertexArray.h"
+#include "../../profiling/profiler.h"
 
 namespace bndr {
 
@@ -68,6 +69,7 @@ namespace bndr {
 
 	void VertexArray::render() {
 
+		BNDR_PROFILE_SCOPE("VertexArray::render");
 		bind();
 		// if the programmer wants to use an IndexBuffer then render using the IndexBuffer
 		if (iBuffer != nullptr) {
@@ -79,7 +81,7 @@ namespace bndr {
 
 			vBuffer->render(drawMode);
 		}
-		unbind();
+		// the vertex array stays bound so the next draw of the same surface skips the bind
 	}
 
 	VertexArray::~VertexArray() {
@@ -92,6 +94,6 @@ namespace bndr {
 			delete iBuffer;
 		}
 		// delete the vertex array
-		glDeleteVertexArrays(1, &arrayID);
+		GLState::deleteVertexArray(arrayID);
 	}
 }
@@ -24,6 +24,7 @@ SOFTWARE.*/
 #include <pch.h>
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
+#include "GLState.h"
 
 namespace bndr {
 
@@ -69,14 +70,14 @@ namespace bndr {
 		VertexArray(VertexArray&&) = delete;
 		// assignment operator is not allowed
 		VertexArray& operator=(const VertexArray&) = delete;
-		// update the vertex buffer data
-		inline void updateVertexBufferData(float* data) { bind(); vBuffer->writeData(data); unbind(); }
+		// update the vertex buffer data (the array buffer binding is not part of the vertex array, so it is not bound)
+		inline void updateVertexBufferData(float* data) { vBuffer->writeData(data); }
 		// render the vertex array
 		void render();
 		// bind the vertex array
-		inline void bind() const { glBindVertexArray(arrayID); }
+		inline void bind() const { GLState::bindVertexArray(arrayID); }
 		// unbind the vertex array
-		inline void unbind() const { glBindVertexArray(0); }
+		inline void unbind() const { GLState::bindVertexArray(0); }
 		// bndr::VertexArray::~VertexArray
 		// Description: Delete the VertexBuffer and IndexBuffer, as well as any textures
 		~VertexArray();
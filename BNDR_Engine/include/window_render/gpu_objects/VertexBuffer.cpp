@@ -22,6 +22,7 @@ SOFTWARE.*/
 
 #include <pch.h>
 #include "VertexBuffer.h"
+#include "../../profiling/render_stats.h"
 
 namespace bndr {
 
@@ -32,6 +33,7 @@ namespace bndr {
 		GL_DEBUG_FUNC(glGenBuffers(1, &bufferID));
 		bind();
 		GL_DEBUG_FUNC(glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertexData.size(), &vertexData[0], GL_DYNAMIC_DRAW));
+		RenderStats::addBytesUploaded(sizeof(float) * vertexData.size());
 
 		// the vertices number is equal to the size of the entire data divided by the size of each data block
 		verticesNumber = (sizeof(float) * vertexData.size()) / dataBlockBytes;
@@ -74,6 +76,7 @@ namespace bndr {
 		bind();
 
 		GL_DEBUG_FUNC(glBufferData(GL_ARRAY_BUFFER, sizeof(float) * verticesNumber * floatsPerBlock, (const void*)vertexData.get(), GL_DYNAMIC_DRAW));
+		RenderStats::addBytesUploaded(sizeof(float) * verticesNumber * floatsPerBlock);
 		VertexBuffer::interleafVertexAttribs(floatsPerBlock * sizeof(float), vbFlags);
 		unbind();
 
@@ -93,15 +96,15 @@ namespace bndr {
 		bind();
 		//void* ptr = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
 		GL_DEBUG_FUNC(glBufferSubData(GL_ARRAY_BUFFER, 0, verticesNumber * floatsPerBlock * sizeof(float), (const void*)data));
+		RenderStats::addBytesUploaded(verticesNumber * floatsPerBlock * sizeof(float));
 		//memcpy(ptr, data, verticesNumber * floatsPerBlock * sizeof(float));
 		//GL_DEBUG_FUNC(glUnmapBuffer(GL_ARRAY_BUFFER));
-		unbind();
 	}
 
 	void VertexBuffer::render(uint drawMode) {
 
-		bind();
+		// the attribute pointers recorded in the vertex array already refer to this buffer
 		GL_DEBUG_FUNC(glDrawArrays(drawMode, 0, verticesNumber));
-		unbind();
+		RenderStats::addDrawCall();
 	}
 }
@@ -23,7 +23,7 @@ SOFTWARE.*/
 #pragma once
 
 #include <pch.h>
-#include "GLDebug.h"
+#include "GLState.h"
 
 namespace bndr {
 
@@ -140,16 +140,16 @@ namespace bndr {
 		// DO NOT USE: This is meanto to be used automatically by the class
 		void writeData(float* data);
 		// bind the buffer
-		inline void bind() const { glBindBuffer(GL_ARRAY_BUFFER, bufferID); }
+		inline void bind() const { GLState::bindBuffer(GL_ARRAY_BUFFER, bufferID); }
 		// unbind the buffer
-		inline void unbind() const { glBindBuffer(GL_ARRAY_BUFFER, 0); }
+		inline void unbind() const { GLState::bindBuffer(GL_ARRAY_BUFFER, 0); }
 		// returns the number of vertices
 		inline int getNumVertices() { return verticesNumber; }
-		// render the vertices
+		// render the vertices (the vertex array they belong to must be bound)
 		void render(uint drawMode);
 		// bndr::VertexBuffer::~VertexBuffer()
 		// Description: Uses glDeleteBuffers to clear the buffer from graphics memory
-		~VertexBuffer() { glDeleteBuffers(1, &bufferID); }
+		~VertexBuffer() { GLState::deleteBuffer(bufferID); }
 	};
 }
 
@@ -0,0 +1,352 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "bitmap_loader.h"
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// msvc lets every function use the intrinsics, the cpu check below decides which ones run
+#define BNDR_TARGET_SSSE3
+#define BNDR_TARGET_AVX2
+#else
+#define BNDR_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BNDR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace bndr {
+
+	// the row converters available on this cpu
+	enum simdLevels {
+
+		SIMD_NONE = 0,
+		SIMD_SSSE3 = 1,
+		SIMD_AVX2 = 2
+	};
+
+	// the bitmap compression values the loader accepts
+	static const uint BITMAP_BI_RGB = 0;
+	static const uint BITMAP_BI_BITFIELDS = 3;
+	// the size of the file header plus the smallest info header
+	static const unsigned long long BITMAP_HEADER_BYTES = 54;
+
+	static int detectSimdLevel() {
+
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+		__cpuid(info, 1);
+		bool ssse3 = (info[2] & (1 << 9)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		bool avx2 = false;
+		// the os has to save the ymm registers too
+		if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+#else
+		bool ssse3 = __builtin_cpu_supports("ssse3");
+		bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+		return avx2 ? SIMD_AVX2 : (ssse3 ? SIMD_SSSE3 : SIMD_NONE);
+	}
+
+	static int getSimdLevel() {
+
+		static const int level = detectSimdLevel();
+		return level;
+	}
+
+	static void convertBGRToRGBAScalar(const uchar* source, uchar* destination, int pixelCount) {
+
+		for (int i = 0; i < pixelCount; i++) {
+
+			destination[0] = source[2];
+			destination[1] = source[1];
+			destination[2] = source[0];
+			destination[3] = (uchar)255;
+			source += 3;
+			destination += 4;
+		}
+	}
+
+	// the BGRA converters OR the alpha with forcedAlpha (0 keeps the alpha, 0xFF000000 makes every pixel opaque)
+	static void convertBGRAToRGBAScalar(const uchar* source, uchar* destination, int pixelCount, uint forcedAlpha) {
+
+		uchar alpha = (uchar)(forcedAlpha >> 24);
+		for (int i = 0; i < pixelCount; i++) {
+
+			destination[0] = source[2];
+			destination[1] = source[1];
+			destination[2] = source[0];
+			destination[3] = source[3] | alpha;
+			source += 4;
+			destination += 4;
+		}
+	}
+
+	BNDR_TARGET_SSSE3 static void convertBGRToRGBASSSE3(const uchar* source, uchar* destination, int pixelCount) {
+
+		// 4 pixels per step, the fourth byte of every pixel is zeroed by the shuffle and filled with the alpha
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+		int i = 0;
+		// a step loads 16 bytes but only uses 12, so the last pixels are left to the scalar loop
+		for (; i + 6 <= pixelCount; i += 4) {
+
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(source + i * 3));
+			pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha);
+			_mm_storeu_si128((__m128i*)(destination + i * 4), pixels);
+		}
+		convertBGRToRGBAScalar(source + i * 3, destination + i * 4, pixelCount - i);
+	}
+
+	BNDR_TARGET_AVX2 static void convertBGRToRGBAAVX2(const uchar* source, uchar* destination, int pixelCount) {
+
+		// the shuffle works within 128 bit lanes, so the upper lane is loaded from the fifth pixel on
+		const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+		int i = 0;
+		for (; i + 10 <= pixelCount; i += 8) {
+
+			const uchar* pixelSource = source + i * 3;
+			__m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)pixelSource)),
+				_mm_loadu_si128((const __m128i*)(pixelSource + 12)), 1);
+			pixels = _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha);
+			_mm256_storeu_si256((__m256i*)(destination + i * 4), pixels);
+		}
+		convertBGRToRGBASSSE3(source + i * 3, destination + i * 4, pixelCount - i);
+	}
+
+	BNDR_TARGET_SSSE3 static void convertBGRAToRGBASSSE3(const uchar* source, uchar* destination, int pixelCount, uint forcedAlpha) {
+
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		const __m128i alpha = _mm_set1_epi32((int)forcedAlpha);
+		int i = 0;
+		for (; i + 4 <= pixelCount; i += 4) {
+
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(source + i * 4));
+			_mm_storeu_si128((__m128i*)(destination + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+		}
+		convertBGRAToRGBAScalar(source + i * 4, destination + i * 4, pixelCount - i, forcedAlpha);
+	}
+
+	BNDR_TARGET_AVX2 static void convertBGRAToRGBAAVX2(const uchar* source, uchar* destination, int pixelCount, uint forcedAlpha) {
+
+		const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		const __m256i alpha = _mm256_set1_epi32((int)forcedAlpha);
+		int i = 0;
+		for (; i + 8 <= pixelCount; i += 8) {
+
+			__m256i pixels = _mm256_loadu_si256((const __m256i*)(source + i * 4));
+			_mm256_storeu_si256((__m256i*)(destination + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+		}
+		convertBGRAToRGBASSSE3(source + i * 4, destination + i * 4, pixelCount - i, forcedAlpha);
+	}
+
+	static void convertBGRAToRGBAWithAlpha(const uchar* source, uchar* destination, int pixelCount, uint forcedAlpha) {
+
+		switch (getSimdLevel()) {
+
+		case SIMD_AVX2: convertBGRAToRGBAAVX2(source, destination, pixelCount, forcedAlpha); break;
+		case SIMD_SSSE3: convertBGRAToRGBASSSE3(source, destination, pixelCount, forcedAlpha); break;
+		default: convertBGRAToRGBAScalar(source, destination, pixelCount, forcedAlpha); break;
+		}
+	}
+
+	void convertBGRToRGBA(const uchar* source, uchar* destination, int pixelCount) {
+
+		switch (getSimdLevel()) {
+
+		case SIMD_AVX2: convertBGRToRGBAAVX2(source, destination, pixelCount); break;
+		case SIMD_SSSE3: convertBGRToRGBASSSE3(source, destination, pixelCount); break;
+		default: convertBGRToRGBAScalar(source, destination, pixelCount); break;
+		}
+	}
+
+	void convertBGRAToRGBA(const uchar* source, uchar* destination, int pixelCount) {
+
+		convertBGRAToRGBAWithAlpha(source, destination, pixelCount, 0);
+	}
+
+	void convertBGRXToRGBA(const uchar* source, uchar* destination, int pixelCount) {
+
+		convertBGRAToRGBAWithAlpha(source, destination, pixelCount, 0xFF000000);
+	}
+
+	// read a little endian header field
+	static uint readHeaderUint(const uchar* header, int offset) { uint value; std::memcpy(&value, header + offset, sizeof(value)); return value; }
+	static int readHeaderInt(const uchar* header, int offset) { int value; std::memcpy(&value, header + offset, sizeof(value)); return value; }
+	static unsigned short readHeaderShort(const uchar* header, int offset) { unsigned short value; std::memcpy(&value, header + offset, sizeof(value)); return value; }
+
+	MappedBitMap::MappedBitMap(const char* bitMapFile) {
+
+		// the handles are released before an exception leaves the constructor (the destructor would not run)
+		auto fail = [this, bitMapFile](const char* reason) {
+
+			release();
+			std::string message = "The bitmap file " + std::string("'") + std::string(bitMapFile) + std::string("' ") + reason;
+			BNDR_EXCEPTION(message.c_str());
+		};
+		file = CreateFileA(bitMapFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+
+			std::string message = "Failed to open bit map file " + std::string("'") + std::string(bitMapFile) + std::string("'");
+			BNDR_EXCEPTION(message.c_str());
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || (unsigned long long)fileSize.QuadPart < BITMAP_HEADER_BYTES) {
+
+			fail("has an invalid file format");
+		}
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL) {
+
+			view = (const uchar*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		}
+		if (view == nullptr) {
+
+			fail("could not be mapped into memory");
+		}
+
+		// validate the header once, the rows are trusted from here on
+		if (view[0] != (uchar)'B' || view[1] != (uchar)'M') {
+
+			fail("has an invalid file format");
+		}
+		unsigned long long size = (unsigned long long)fileSize.QuadPart;
+		uint dataOffset = readHeaderUint(view, 0x0A);
+		uint infoSize = readHeaderUint(view, 0x0E);
+		width = readHeaderInt(view, 0x12);
+		int fileHeight = readHeaderInt(view, 0x16);
+		unsigned short planes = readHeaderShort(view, 0x1A);
+		bitsPerPixel = (int)readHeaderShort(view, 0x1C);
+		uint compression = readHeaderUint(view, 0x1E);
+		if (infoSize < 40 || planes != 1) {
+
+			fail("has an invalid file format");
+		}
+		if (width <= 0 || fileHeight == 0) {
+
+			fail("has a dimension of 0 pixels");
+		}
+		if (bitsPerPixel != 24 && bitsPerPixel != 32) {
+
+			fail("is not a 24 or 32 bit bitmap");
+		}
+		if (compression == BITMAP_BI_BITFIELDS) {
+
+			// only the masks of plain BGRA are accepted (they follow a 40 byte header and are part of larger ones)
+			if (bitsPerPixel != 32 || size < 0x42 || readHeaderUint(view, 0x36) != 0x00FF0000 ||
+				readHeaderUint(view, 0x3A) != 0x0000FF00 || readHeaderUint(view, 0x3E) != 0x000000FF) {
+
+				fail("uses a pixel layout other than BGR or BGRA");
+			}
+			// the alpha mask only exists in the V3 header and later ones, without it the fourth byte is unused
+			uint alphaMask = (infoSize >= 56 && size >= 0x46) ? readHeaderUint(view, 0x42) : 0;
+			if (alphaMask != 0 && alphaMask != 0xFF000000) {
+
+				fail("uses a pixel layout other than BGR or BGRA");
+			}
+			alpha = alphaMask != 0;
+		}
+		else if (compression != BITMAP_BI_RGB) {
+
+			fail("is compressed");
+		}
+		// a negative height means the rows are stored from the top down
+		topDown = fileHeight < 0;
+		height = topDown ? -fileHeight : fileHeight;
+		unsigned long long rowBytes = (((unsigned long long)width * bitsPerPixel + 31) / 32) * 4;
+		// rows are padded to 4 bytes no matter what the size field in the header says
+		if (rowBytes > 0x7FFFFFFF || dataOffset < BITMAP_HEADER_BYTES || (unsigned long long)dataOffset + rowBytes * height > size) {
+
+			fail("is shorter than its header says");
+		}
+		stride = (int)rowBytes;
+		pixels = view + dataOffset;
+	}
+
+	void MappedBitMap::copyBottomUp(uchar* destination) const {
+
+		if (!topDown) {
+
+			std::memcpy(destination, pixels, (size_t)stride * height);
+			return;
+		}
+		for (int row = 0; row < height; row++) {
+
+			std::memcpy(destination + (size_t)stride * row, getRow(row), stride);
+		}
+	}
+
+	void MappedBitMap::convertToRGBA(uchar* destination, bool topRowFirst) const {
+
+		size_t destinationStride = (size_t)width * 4;
+		for (int row = 0; row < height; row++) {
+
+			const uchar* source = getRow(topRowFirst ? (height - 1 - row) : row);
+			if (alpha) {
+
+				convertBGRAToRGBA(source, destination + destinationStride * row, width);
+			}
+			else if (bitsPerPixel == 32) {
+
+				convertBGRXToRGBA(source, destination + destinationStride * row, width);
+			}
+			else {
+
+				convertBGRToRGBA(source, destination + destinationStride * row, width);
+			}
+		}
+	}
+
+	void MappedBitMap::release() {
+
+		if (view != nullptr) {
+
+			UnmapViewOfFile(view);
+			view = nullptr;
+		}
+		if (mapping != NULL) {
+
+			CloseHandle(mapping);
+			mapping = NULL;
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+
+			CloseHandle(file);
+			file = INVALID_HANDLE_VALUE;
+		}
+		pixels = nullptr;
+	}
+
+	MappedBitMap::~MappedBitMap() {
+
+		release();
+	}
+}
@@ -0,0 +1,94 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	// bndr::MappedBitMap
+	// Description: A bitmap file mapped into memory with a Win32 file mapping instead of being read into a buffer. The
+	// header is validated once when the file is opened (24 bit BGR and 32 bit BGRA images, bottom-up or top-down, rows
+	// padded to 4 bytes), after that the rows are read straight out of the mapping. The fourth byte of a 32 bit pixel is
+	// only alpha in BI_BITFIELDS files with an alpha mask, in BI_RGB files it is reserved (usually 0) and ignored.
+	// A bottom-up image already has the row order and alignment OpenGL expects, so isUploadReady() images are handed to
+	// glTexImage2D without any copy
+	class BNDR_API MappedBitMap {
+
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+		const uchar* view = nullptr;
+		// the first byte of the pixel array
+		const uchar* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		int bitsPerPixel = 0;
+		// the bytes of a row including its padding
+		int stride = 0;
+		// set if the first row of the file is the top row of the image
+		bool topDown = false;
+		// set if the fourth byte of every pixel is alpha
+		bool alpha = false;
+
+		// unmap the file and close the handles
+		void release();
+
+	public:
+
+		// map and validate a bitmap file (throws if the file is missing or not a supported bitmap)
+		explicit MappedBitMap(const char* bitMapFile);
+		MappedBitMap(const MappedBitMap&) = delete;
+		MappedBitMap& operator=(const MappedBitMap&) = delete;
+		inline int getWidth() const { return width; }
+		inline int getHeight() const { return height; }
+		inline int getBitsPerPixel() const { return bitsPerPixel; }
+		inline int getBytesPerPixel() const { return bitsPerPixel / 8; }
+		inline int getStride() const { return stride; }
+		inline bool isTopDown() const { return topDown; }
+		// check if the pixels have an alpha channel (32 bit files without one still have 4 bytes per pixel)
+		inline bool hasAlpha() const { return alpha; }
+		// get a row counted from the bottom of the image (the row order of OpenGL textures)
+		inline const uchar* getRow(int row) const { return pixels + (size_t)stride * (topDown ? (height - 1 - row) : row); }
+		// get the pixel array as it is in the file
+		inline const uchar* getPixels() const { return pixels; }
+		// check if the pixel array can be passed to OpenGL as it is (bottom-up rows padded to 4 bytes)
+		inline bool isUploadReady() const { return !topDown; }
+		// the pixel format of the rows for glTexImage2D (GL_BGR or GL_BGRA)
+		inline uint getGLFormat() const { return (bitsPerPixel == 32) ? GL_BGRA : GL_BGR; }
+		// the internal format that keeps every channel of the file (GL_RGB or GL_RGBA, the unused byte of 32 bit files without
+		// alpha is dropped by the upload)
+		inline uint getGLInternalFormat() const { return alpha ? GL_RGBA : GL_RGB; }
+		// copy the rows bottom-up in the layout of the file (getStride() * getHeight() bytes)
+		void copyBottomUp(uchar* destination) const;
+		// convert the pixels to tightly packed RGBA (width * height * 4 bytes), top row first if topRowFirst is set
+		// (images without alpha get an alpha of 255)
+		void convertToRGBA(uchar* destination, bool topRowFirst) const;
+		~MappedBitMap();
+	};
+
+	// convert a row of BGR pixels to RGBA with an alpha of 255 (uses AVX2 or SSSE3 shuffles when the CPU has them)
+	BNDR_API void convertBGRToRGBA(const uchar* source, uchar* destination, int pixelCount);
+	// convert a row of BGRA pixels to RGBA (uses AVX2 or SSSE3 shuffles when the CPU has them)
+	BNDR_API void convertBGRAToRGBA(const uchar* source, uchar* destination, int pixelCount);
+	// convert a row of 32 bit BGR pixels whose fourth byte is unused to RGBA with an alpha of 255
+	BNDR_API void convertBGRXToRGBA(const uchar* source, uchar* destination, int pixelCount);
+}
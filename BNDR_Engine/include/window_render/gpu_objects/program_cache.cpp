@@ -0,0 +1,221 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "program_cache.h"
+
+namespace bndr {
+
+	std::string ProgramBinaryCache::directory = "shader_cache";
+	bool ProgramBinaryCache::enabled = true;
+	unsigned long long ProgramBinaryCache::driverHash = 0;
+	bool ProgramBinaryCache::driverHashed = false;
+	std::unordered_map<unsigned long long, ProgramBinaryCache::Binary> ProgramBinaryCache::binaries;
+
+	void ProgramBinaryCache::setDirectory(const char* path) {
+
+		directory = path;
+		// strip trailing separators so entry paths are always directory + "/" + name
+		while (directory.size() > 1 && (directory.back() == '/' || directory.back() == '\\')) {
+
+			directory.pop_back();
+		}
+	}
+
+	bool ProgramBinaryCache::isActive() {
+
+		if (!enabled || !GLEW_ARB_get_program_binary) {
+
+			return false;
+		}
+		// some drivers expose the extension but no formats, in which case nothing can be cached
+		static int formatCount = -1;
+		if (formatCount == -1) {
+
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		}
+		return formatCount > 0;
+	}
+
+	unsigned long long ProgramBinaryCache::computeKey(const std::string& vertexSource, const std::string& fragmentSource) {
+
+		if (!driverHashed) {
+
+			// a binary is only valid for the exact driver that produced it
+			const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+			unsigned long long hash = FNV_OFFSET_BASIS;
+			for (GLenum name : strings) {
+
+				const char* value = reinterpret_cast<const char*>(glGetString(name));
+				hash = hashString((value != nullptr) ? value : "", hash);
+			}
+			int formatCount = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+			if (formatCount > 0) {
+
+				std::vector<int> formats(formatCount);
+				glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, &formats[0]);
+				hash = hashBytes(&formats[0], formats.size() * sizeof(int), hash);
+			}
+			driverHash = hash;
+			driverHashed = true;
+		}
+		uint version = ENTRY_VERSION;
+		unsigned long long key = hashValue(version, driverHash);
+		key = hashString(vertexSource, key);
+		return hashString(fragmentSource, key);
+	}
+
+	std::string ProgramBinaryCache::getEntryPath(unsigned long long key) {
+
+		return directory + "/" + hashToHex(key) + ".bin";
+	}
+
+	void ProgramBinaryCache::invalidate(unsigned long long key, const char* reason) {
+
+		binaries.erase(key);
+		std::string path = getEntryPath(key);
+		std::string message = "Discarding cached program binary '" + path + "' (" + reason + ")";
+		BNDR_MESSAGE(message.c_str());
+		std::remove(path.c_str());
+	}
+
+	bool ProgramBinaryCache::readEntry(unsigned long long key, Binary& binary) {
+
+		std::ifstream file(getEntryPath(key), std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+
+			// a plain miss
+			return false;
+		}
+		EntryHeader header;
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != ENTRY_MAGIC || header.version != ENTRY_VERSION
+			|| header.key != key || header.binaryLength == 0) {
+
+			file.close();
+			invalidate(key, "bad header");
+			return false;
+		}
+		binary.format = header.binaryFormat;
+		binary.data.resize(header.binaryLength);
+		if (!file.read(&binary.data[0], binary.data.size()) || hashBytes(&binary.data[0], binary.data.size()) != header.checksum) {
+
+			file.close();
+			invalidate(key, "truncated or corrupt");
+			return false;
+		}
+		return true;
+	}
+
+	uint ProgramBinaryCache::load(const std::string& vertexSource, const std::string& fragmentSource) {
+
+		if (!isActive()) {
+
+			return 0;
+		}
+		unsigned long long key = computeKey(vertexSource, fragmentSource);
+		auto entry = binaries.find(key);
+		if (entry == binaries.end()) {
+
+			Binary binary;
+			if (!readEntry(key, binary)) {
+
+				return 0;
+			}
+			entry = binaries.insert(std::make_pair(key, std::move(binary))).first;
+		}
+
+		const Binary& binary = entry->second;
+		uint programID = glCreateProgram();
+		glProgramBinary(programID, (GLenum)binary.format, &binary.data[0], (int)binary.data.size());
+		int linked = GL_FALSE;
+		glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+		if (linked != GL_TRUE) {
+
+			// the driver is allowed to reject any binary (i.e. after an update that kept the version string)
+			glDeleteProgram(programID);
+			// glProgramBinary reports an unknown format as GL_INVALID_ENUM, clear it so it is not blamed on the next call
+			while (glGetError() != GL_NO_ERROR) {}
+			invalidate(key, "rejected by the driver");
+			return 0;
+		}
+		return programID;
+	}
+
+	void ProgramBinaryCache::store(uint programID, const std::string& vertexSource, const std::string& fragmentSource) {
+
+		if (!isActive()) {
+
+			return;
+		}
+		int binaryLength = 0;
+		glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if (binaryLength <= 0) {
+
+			return;
+		}
+		std::vector<char> binary(binaryLength);
+		GLenum binaryFormat = 0;
+		glGetProgramBinary(programID, binaryLength, &binaryLength, &binaryFormat, &binary[0]);
+		if (binaryLength <= 0) {
+
+			return;
+		}
+
+		EntryHeader header;
+		header.magic = ENTRY_MAGIC;
+		header.version = ENTRY_VERSION;
+		header.key = computeKey(vertexSource, fragmentSource);
+		header.binaryFormat = (uint)binaryFormat;
+		header.binaryLength = (uint)binaryLength;
+		header.checksum = hashBytes(&binary[0], (size_t)binaryLength);
+
+		// fails harmlessly if the directory already exists
+		CreateDirectoryA(directory.c_str(), NULL);
+		// write to a temporary file and move it into place so a crash never leaves a half written entry behind
+		std::string path = getEntryPath(header.key);
+		std::string tempPath = path + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+
+				std::string message = "Failed to open '" + tempPath + "' for the program binary cache";
+				BNDR_MESSAGE(message.c_str());
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(&binary[0], binaryLength);
+			if (!file.good()) {
+
+				file.close();
+				std::remove(tempPath.c_str());
+				return;
+			}
+		}
+		if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+
+			std::remove(tempPath.c_str());
+		}
+		binary.resize(binaryLength);
+		binaries[header.key] = Binary{ header.binaryFormat, std::move(binary) };
+	}
+}
@@ -0,0 +1,94 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "../../data_structures/hashing.h"
+
+namespace bndr {
+
+	// bndr::ProgramBinaryCache
+	// Description: Static on disk cache of linked program binaries (glGetProgramBinary) so that the shaders only have to be
+	// compiled the first time the engine runs on a machine. An entry is keyed by a 64 bit hash of the vertex and fragment
+	// source together with the GL vendor, renderer, version and supported binary formats, so a driver update or a shader
+	// edit simply misses the cache. Every entry also stores a checksum of the binary; an entry that is corrupt or that the
+	// driver rejects is deleted and the program is compiled from source again (and re-cached).
+	// The cache is disabled automatically when the context does not support program binaries
+	class BNDR_API ProgramBinaryCache {
+
+		// the header written in front of every cached binary
+		struct EntryHeader {
+
+			uint magic;
+			uint version;
+			// the full key the entry was written for (checked so a file name collision is never loaded)
+			unsigned long long key;
+			uint binaryFormat;
+			uint binaryLength;
+			// FNV-1a hash of the binary
+			unsigned long long checksum;
+		};
+
+		// a binary kept in memory after it was read or written once
+		struct Binary {
+
+			uint format;
+			std::vector<char> data;
+		};
+
+		static const uint ENTRY_MAGIC = 0x43504E42; // "BNPC"
+		static const uint ENTRY_VERSION = 1;
+
+		// every surface creates its own program, so the binaries are kept in memory to read each file only once
+		static std::unordered_map<unsigned long long, Binary> binaries;
+
+		static std::string directory;
+		static bool enabled;
+		// the hash of the driver strings and binary formats (computed once a context exists)
+		static unsigned long long driverHash;
+		static bool driverHashed;
+
+		// get the file of a cache entry
+		static std::string getEntryPath(unsigned long long key);
+		// delete an entry that could not be used
+		static void invalidate(unsigned long long key, const char* reason);
+		// read and validate the file of an entry, returns false (and deletes the file if it is damaged) on a miss
+		static bool readEntry(unsigned long long key, Binary& binary);
+
+	public:
+
+		// set the directory the binaries are written to (created on the first store, default "shader_cache")
+		static void setDirectory(const char* path);
+		inline static const std::string& getDirectory() { return directory; }
+		// enable or disable the cache (enabled by default)
+		inline static void setEnabled(bool enable) { enabled = enable; }
+		// check if the cache is enabled and the context can retrieve program binaries (requires a current context)
+		static bool isActive();
+		// compute the key of a vertex/fragment source pair for the current driver (requires a current context)
+		static unsigned long long computeKey(const std::string& vertexSource, const std::string& fragmentSource);
+		// create a program from the cached binary of the sources
+		// returns the linked program or 0 if there is no usable entry (the caller then compiles from source)
+		static uint load(const std::string& vertexSource, const std::string& fragmentSource);
+		// write the binary of a linked program to the cache (the program should have been linked with the retrievable hint)
+		static void store(uint programID, const std::string& vertexSource, const std::string& fragmentSource);
+	};
+}
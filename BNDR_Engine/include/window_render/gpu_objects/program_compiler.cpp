@@ -0,0 +1,275 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "program_compiler.h"
+#include "program_cache.h"
+#include "GLState.h"
+
+namespace bndr {
+
+	uint ProgramCompiler::mode = COMPILE_BLOCKING;
+	GLFWwindow* ProgramCompiler::workerWindow = nullptr;
+	std::thread ProgramCompiler::workerThread;
+	std::mutex ProgramCompiler::queueMutex;
+	std::condition_variable ProgramCompiler::queueCondition;
+	std::deque<ProgramCompileJob*> ProgramCompiler::queue;
+	bool ProgramCompiler::stopping = false;
+
+	// submit the source of a shader for compiling (the status is only read once the program is linked)
+	static uint compileShader(uint shaderType, const std::string& source) {
+
+		uint shaderID = glCreateShader(shaderType);
+		const char* sourceCode = source.c_str();
+		GL_DEBUG_FUNC(glShaderSource(shaderID, 1, &sourceCode, NULL));
+		glCompileShader(shaderID);
+		return shaderID;
+	}
+
+	// append the compile log of a shader that failed
+	static void appendShaderLog(uint shaderID, const char* stageName, std::string& errorLog) {
+
+		int compiled = 0;
+		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &compiled);
+		if (compiled) {
+
+			return;
+		}
+		int logLength = 0;
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> log(std::max<int>(logLength, 1));
+		glGetShaderInfoLog(shaderID, (int)log.size(), NULL, &log[0]);
+		errorLog += std::string(stageName) + " shader: " + &log[0] + "\n";
+	}
+
+	void ProgramCompiler::start(GLFWwindow* mainWindow) {
+
+		if (GLEW_KHR_parallel_shader_compile) {
+
+			// let the driver compile on as many threads as it likes
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+			mode = COMPILE_PARALLEL_KHR;
+			return;
+		}
+		if (mode == COMPILE_SHARED_CONTEXT) {
+
+			return;
+		}
+		// the worker context uses the same hints as the window so the same driver entry points apply to it
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		workerWindow = glfwCreateWindow(1, 1, "BNDR shader compiler", NULL, mainWindow);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+		if (workerWindow == nullptr) {
+
+			BNDR_MESSAGE("Failed to create the shader compiler context, programs are compiled on the render thread");
+			mode = COMPILE_BLOCKING;
+			return;
+		}
+		stopping = false;
+		mode = COMPILE_SHARED_CONTEXT;
+		workerThread = std::thread(ProgramCompiler::workerLoop);
+	}
+
+	void ProgramCompiler::stop() {
+
+		if (mode == COMPILE_SHARED_CONTEXT) {
+
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				stopping = true;
+			}
+			queueCondition.notify_all();
+			workerThread.join();
+			glfwDestroyWindow(workerWindow);
+			workerWindow = nullptr;
+			// the render context compiles whatever the worker never started
+			for (ProgramCompileJob* job : queue) {
+
+				issueCalls(job);
+				readStatus(job);
+				job->done.store(true);
+			}
+			queue.clear();
+		}
+		mode = COMPILE_BLOCKING;
+	}
+
+	void ProgramCompiler::workerLoop() {
+
+		glfwMakeContextCurrent(workerWindow);
+		while (true) {
+
+			ProgramCompileJob* job = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				queueCondition.wait(lock, []() { return stopping || !queue.empty(); });
+				if (stopping) {
+
+					break;
+				}
+				job = queue.front();
+				queue.pop_front();
+			}
+			issueCalls(job);
+			readStatus(job);
+			// the program has to be complete before the render context may use it
+			glFinish();
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				job->done.store(true);
+			}
+			queueCondition.notify_all();
+		}
+		glfwMakeContextCurrent(NULL);
+	}
+
+	void ProgramCompiler::issueCalls(ProgramCompileJob* job) {
+
+		if (job->ownsShaders) {
+
+			job->vertexShader = compileShader(GL_VERTEX_SHADER, job->vertexSource);
+			job->fragmentShader = compileShader(GL_FRAGMENT_SHADER, job->fragmentSource);
+		}
+		glAttachShader(job->programID, job->vertexShader);
+		glAttachShader(job->programID, job->fragmentShader);
+		glLinkProgram(job->programID);
+	}
+
+	void ProgramCompiler::readStatus(ProgramCompileJob* job) {
+
+		int linked = 0;
+		glGetProgramiv(job->programID, GL_LINK_STATUS, &linked);
+		if (!linked) {
+
+			job->failed = true;
+			appendShaderLog(job->vertexShader, "vertex", job->errorLog);
+			appendShaderLog(job->fragmentShader, "fragment", job->errorLog);
+			int logLength = 0;
+			glGetProgramiv(job->programID, GL_INFO_LOG_LENGTH, &logLength);
+			std::vector<char> log(std::max<int>(logLength, 1));
+			glGetProgramInfoLog(job->programID, (int)log.size(), NULL, &log[0]);
+			job->errorLog += std::string("program: ") + &log[0];
+		}
+		glDetachShader(job->programID, job->vertexShader);
+		glDetachShader(job->programID, job->fragmentShader);
+		if (job->ownsShaders) {
+
+			glDeleteShader(job->vertexShader);
+			glDeleteShader(job->fragmentShader);
+		}
+	}
+
+	bool ProgramCompiler::takeQueued(ProgramCompileJob* job) {
+
+		std::lock_guard<std::mutex> lock(queueMutex);
+		auto queued = std::find(queue.begin(), queue.end(), job);
+		if (queued == queue.end()) {
+
+			return false;
+		}
+		queue.erase(queued);
+		return true;
+	}
+
+	ProgramCompileJob* ProgramCompiler::submit(const std::string& vertexSource, const std::string& fragmentSource, uint vertexShader, uint fragmentShader) {
+
+		ProgramCompileJob* job = new ProgramCompileJob();
+		job->vertexSource = vertexSource;
+		job->fragmentSource = fragmentSource;
+		job->vertexShader = vertexShader;
+		job->fragmentShader = fragmentShader;
+		job->ownsShaders = (vertexShader == 0 || fragmentShader == 0);
+		job->programID = glCreateProgram();
+		if (ProgramBinaryCache::isActive()) {
+
+			// ask the driver to keep the binary around for glGetProgramBinary
+			glProgramParameteri(job->programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		if (mode == COMPILE_SHARED_CONTEXT) {
+
+			// the worker context only sees the new program object (and shaders handed in) once the commands are flushed
+			glFlush();
+			job->onWorker = true;
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				queue.push_back(job);
+			}
+			queueCondition.notify_all();
+			return job;
+		}
+		// with KHR_parallel_shader_compile these calls return right away and the driver compiles in the background
+		issueCalls(job);
+		return job;
+	}
+
+	bool ProgramCompiler::poll(ProgramCompileJob* job) {
+
+		if (job->onWorker) {
+
+			return job->done.load();
+		}
+		if (mode == COMPILE_PARALLEL_KHR) {
+
+			int complete = 0;
+			glGetProgramiv(job->programID, GL_COMPLETION_STATUS_KHR, &complete);
+			return complete != 0;
+		}
+		// a blocking compile completes when its status is read
+		return true;
+	}
+
+	void ProgramCompiler::wait(ProgramCompileJob* job) {
+
+		// jobs on the render thread complete when finish() reads their status
+		if (!job->onWorker) {
+
+			return;
+		}
+		// no need to wait for the jobs in front of it
+		if (takeQueued(job)) {
+
+			issueCalls(job);
+			readStatus(job);
+			job->done.store(true);
+			return;
+		}
+		std::unique_lock<std::mutex> lock(queueMutex);
+		queueCondition.wait(lock, [job]() { return job->done.load(); });
+	}
+
+	bool ProgramCompiler::finish(ProgramCompileJob* job, std::string& errorLog) {
+
+		wait(job);
+		if (!job->onWorker) {
+
+			readStatus(job);
+		}
+		bool succeeded = !job->failed;
+		if (!succeeded) {
+
+			errorLog = job->errorLog;
+			GLState::deleteProgram(job->programID);
+		}
+		delete job;
+		return succeeded;
+	}
+}
@@ -0,0 +1,105 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	// how bndr::ProgramCompiler gets programs compiled without stalling the render thread
+	enum programCompileModes {
+
+		// compile and link on the render thread, the first readiness check waits for the driver
+		COMPILE_BLOCKING = 0,
+		// submit on the render thread and poll GL_COMPLETION_STATUS_KHR (the driver compiles on its own threads)
+		COMPILE_PARALLEL_KHR = 1,
+		// compile and link on a worker thread with a hidden context that shares objects with the window
+		COMPILE_SHARED_CONTEXT = 2
+	};
+
+	// a program being compiled and linked by bndr::ProgramCompiler
+	struct ProgramCompileJob {
+
+		std::string vertexSource;
+		std::string fragmentSource;
+		// the program object (created on the render thread, so its name is known right away)
+		uint programID = 0;
+		// shaders compiled by the job are deleted once it is linked, shaders handed in are left alone
+		uint vertexShader = 0;
+		uint fragmentShader = 0;
+		bool ownsShaders = false;
+		// set if the job was queued for the worker thread
+		bool onWorker = false;
+		// set by the worker once the program is linked and its status read (shared context mode only)
+		std::atomic<bool> done{ false };
+		// the status once it was read
+		bool failed = false;
+		std::string errorLog;
+	};
+
+	// bndr::ProgramCompiler
+	// Description: Static compiler that never blocks on the driver. submit() issues the compile and link and returns at
+	// once, poll() checks the job without waiting. With GL_KHR_parallel_shader_compile the calls are made on the render
+	// thread and the driver compiles on its own threads (GL_COMPLETION_STATUS_KHR is polled), without it a worker thread
+	// with a hidden shared context compiles the jobs in order. The compile and link logs are only read once a job
+	// completed, so several programs compile at the same time. Window starts and stops the compiler, until then (or if
+	// neither mode is available) jobs compile on the render thread
+	class BNDR_API ProgramCompiler {
+
+		static uint mode;
+		// the hidden window that owns the worker context
+		static GLFWwindow* workerWindow;
+		static std::thread workerThread;
+		static std::mutex queueMutex;
+		static std::condition_variable queueCondition;
+		static std::deque<ProgramCompileJob*> queue;
+		static bool stopping;
+
+		// the body of the worker thread
+		static void workerLoop();
+		// compile (if needed) and link the job with the current context
+		static void issueCalls(ProgramCompileJob* job);
+		// read the compile and link status of an issued job (waits for the driver) and free the shaders it compiled
+		static void readStatus(ProgramCompileJob* job);
+		// take a job out of the worker queue if the worker has not started it yet
+		static bool takeQueued(ProgramCompileJob* job);
+
+	public:
+
+		// pick the compile mode for the context of the window (the window has to be current)
+		static void start(GLFWwindow* mainWindow);
+		// stop the worker (jobs it has not started are compiled by the render thread when they are waited on)
+		static void stop();
+		// get the mode in use (see enum bndr::programCompileModes)
+		static inline uint getMode() { return mode; }
+		// start compiling and linking a program from sources, or link already compiled shaders if their ids are given
+		// (the job is owned by the caller and freed with finish())
+		static ProgramCompileJob* submit(const std::string& vertexSource, const std::string& fragmentSource, uint vertexShader = 0, uint fragmentShader = 0);
+		// check if a job completed without waiting
+		static bool poll(ProgramCompileJob* job);
+		// wait until a job completed
+		static void wait(ProgramCompileJob* job);
+		// read the status of a completed job and free it, returns false (with the log in errorLog) if it failed
+		// the program object is kept on success and deleted on failure
+		static bool finish(ProgramCompileJob* job, std::string& errorLog);
+	};
+}
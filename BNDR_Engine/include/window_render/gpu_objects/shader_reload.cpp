@@ -0,0 +1,331 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "shader_reload.h"
+#include "shaders.h"
+
+namespace bndr {
+
+	std::mutex ShaderHotReload::watchMutex;
+	std::vector<ShaderHotReload::WatchedProgram> ShaderHotReload::programs;
+	std::vector<ShaderHotReload::WatchedFile> ShaderHotReload::files;
+	bool ShaderHotReload::filesChanged = false;
+	std::vector<std::string> ShaderHotReload::changedPaths;
+	std::atomic<bool> ShaderHotReload::hasChanges(false);
+	std::vector<ShaderHotReload::PendingReload> ShaderHotReload::pending;
+	std::function<void(Program*)> ShaderHotReload::reloadCallback;
+	std::thread ShaderHotReload::watchThread;
+	std::atomic<bool> ShaderHotReload::running(false);
+
+	// get the directory part of a path ("." for a bare file name)
+	static std::string getDirectory(const std::string& path) {
+
+		size_t separator = path.find_last_of("/\\");
+		return (separator == std::string::npos) ? std::string(".") : path.substr(0, separator);
+	}
+
+	unsigned long long ShaderHotReload::getLastWriteTime(const std::string& path) {
+
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)) {
+
+			return 0;
+		}
+		return ((unsigned long long)attributes.ftLastWriteTime.dwHighDateTime << 32) | (unsigned long long)attributes.ftLastWriteTime.dwLowDateTime;
+	}
+
+	bool ShaderHotReload::readFile(const std::string& path, std::string& contents) {
+
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+
+			return false;
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		contents = stream.str();
+		return !contents.empty();
+	}
+
+	void ShaderHotReload::start() {
+
+		if (running.load()) {
+
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(watchMutex);
+			// pick up edits made while nothing was watching
+			for (WatchedFile& file : files) {
+
+				file.lastWrite = getLastWriteTime(file.path);
+			}
+			filesChanged = true;
+		}
+		running.store(true);
+		watchThread = std::thread(&ShaderHotReload::watchLoop);
+	}
+
+	void ShaderHotReload::stop() {
+
+		if (!running.load()) {
+
+			return;
+		}
+		running.store(false);
+		watchThread.join();
+		for (PendingReload& reload : pending) {
+
+			uint programID = reload.job->programID;
+			std::string errorLog;
+			if (ProgramCompiler::finish(reload.job, errorLog)) {
+
+				GLState::deleteProgram(programID);
+			}
+		}
+		pending.clear();
+	}
+
+	void ShaderHotReload::watchLoop() {
+
+		std::vector<HANDLE> handles;
+		while (running.load()) {
+
+			{
+				std::lock_guard<std::mutex> lock(watchMutex);
+				if (filesChanged) {
+
+					for (HANDLE handle : handles) {
+
+						FindCloseChangeNotification(handle);
+					}
+					handles.clear();
+					std::vector<std::string> directories;
+					for (const WatchedFile& file : files) {
+
+						std::string directory = getDirectory(file.path);
+						if (std::find(directories.begin(), directories.end(), directory) == directories.end()) {
+
+							directories.push_back(directory);
+						}
+					}
+					for (const std::string& directory : directories) {
+
+						// WaitForMultipleObjects takes no more handles than this, the other directories are not watched
+						if (handles.size() >= MAXIMUM_WAIT_OBJECTS) {
+
+							break;
+						}
+						HANDLE handle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+						if (handle != INVALID_HANDLE_VALUE) {
+
+							handles.push_back(handle);
+						}
+					}
+					filesChanged = false;
+				}
+			}
+
+			// wake up on a change or every quarter second to notice stop() and new directories
+			if (handles.empty()) {
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(250));
+				continue;
+			}
+			DWORD result = WaitForMultipleObjects((DWORD)handles.size(), &handles[0], FALSE, 250);
+			if (result == WAIT_TIMEOUT || result >= WAIT_OBJECT_0 + handles.size()) {
+
+				continue;
+			}
+			FindNextChangeNotification(handles[result - WAIT_OBJECT_0]);
+
+			// the notification only says something in the directory changed, compare the write times to find out what
+			std::lock_guard<std::mutex> lock(watchMutex);
+			for (WatchedFile& file : files) {
+
+				unsigned long long lastWrite = getLastWriteTime(file.path);
+				if (lastWrite != 0 && lastWrite != file.lastWrite) {
+
+					file.lastWrite = lastWrite;
+					changedPaths.push_back(file.path);
+					hasChanges.store(true, std::memory_order_release);
+				}
+			}
+		}
+		for (HANDLE handle : handles) {
+
+			FindCloseChangeNotification(handle);
+		}
+	}
+
+	void ShaderHotReload::watch(Program* program, const std::string& vertexPath, const std::string& fragmentPath,
+		const std::string& vertexSource, const std::string& fragmentSource) {
+
+		std::lock_guard<std::mutex> lock(watchMutex);
+		programs.push_back({ program, vertexPath, fragmentPath, vertexSource, fragmentSource });
+		for (const std::string* path : { &vertexPath, &fragmentPath }) {
+
+			if (path->empty()) {
+
+				continue;
+			}
+			bool known = false;
+			for (const WatchedFile& file : files) {
+
+				known = known || (file.path == *path);
+			}
+			if (!known) {
+
+				files.push_back({ *path, getLastWriteTime(*path) });
+				filesChanged = true;
+			}
+		}
+	}
+
+	void ShaderHotReload::unwatch(Program* program) {
+
+		std::lock_guard<std::mutex> lock(watchMutex);
+		programs.erase(std::remove_if(programs.begin(), programs.end(), [=](const WatchedProgram& watched) { return watched.program == program; }), programs.end());
+		// a compile that is still running for the program is dropped when it finishes
+		for (PendingReload& reload : pending) {
+
+			if (reload.program == program) {
+
+				reload.program = nullptr;
+			}
+		}
+	}
+
+	void ShaderHotReload::beginReload(const WatchedProgram& watched) {
+
+		PendingReload reload;
+		reload.program = watched.program;
+		reload.vertexSource = watched.vertexSource;
+		reload.fragmentSource = watched.fragmentSource;
+		// the compiler issues the calls without waiting (driver threads or its worker context, see ProgramCompiler)
+		reload.job = ProgramCompiler::submit(reload.vertexSource, reload.fragmentSource);
+		pending.push_back(std::move(reload));
+	}
+
+	void ShaderHotReload::finishReload(PendingReload& reload) {
+
+		// the job is freed by finish, which also deletes the program object if the link failed
+		uint programID = reload.job->programID;
+		std::string errorLog;
+		bool succeeded = ProgramCompiler::finish(reload.job, errorLog);
+		reload.job = nullptr;
+		if (!succeeded) {
+
+			// the new source has errors
+			if (reload.program != nullptr) {
+
+				std::string message = "Shader reload failed, keeping the previous program\n" + errorLog;
+				BNDR_MESSAGE(message.c_str());
+			}
+			return;
+		}
+		if (reload.program == nullptr) {
+
+			// the program was deleted while compiling
+			GLState::deleteProgram(programID);
+			return;
+		}
+		reload.program->swapLinkedProgram(programID, reload.vertexSource, reload.fragmentSource);
+		BNDR_MESSAGE("Shader reloaded");
+		if (reloadCallback) {
+
+			reloadCallback(reload.program);
+		}
+	}
+
+	void ShaderHotReload::update() {
+
+		if (hasChanges.load(std::memory_order_acquire)) {
+
+			std::vector<WatchedProgram> reloads;
+			{
+				std::lock_guard<std::mutex> lock(watchMutex);
+				std::vector<std::string> paths;
+				paths.swap(changedPaths);
+				hasChanges.store(false, std::memory_order_relaxed);
+				// read every changed file once, an editor may still hold one in which case it is tried again next frame
+				std::vector<std::pair<std::string, std::string>> sources;
+				for (const std::string& path : paths) {
+
+					bool seen = false;
+					for (const std::pair<std::string, std::string>& source : sources) {
+
+						seen = seen || (source.first == path);
+					}
+					seen = seen || (std::find(changedPaths.begin(), changedPaths.end(), path) != changedPaths.end());
+					if (seen) {
+
+						continue;
+					}
+					std::string contents;
+					if (readFile(path, contents)) {
+
+						sources.push_back(std::make_pair(path, std::move(contents)));
+					}
+					else {
+
+						changedPaths.push_back(path);
+						hasChanges.store(true, std::memory_order_relaxed);
+					}
+				}
+				for (WatchedProgram& watched : programs) {
+
+					bool changed = false;
+					for (const std::pair<std::string, std::string>& source : sources) {
+
+						if (source.first == watched.vertexPath) { watched.vertexSource = source.second; changed = true; }
+						if (source.first == watched.fragmentPath) { watched.fragmentSource = source.second; changed = true; }
+					}
+					// wait for the other stage if it is being retried so the program is rebuilt once with both edits
+					bool waiting = std::find(changedPaths.begin(), changedPaths.end(), watched.vertexPath) != changedPaths.end()
+						|| std::find(changedPaths.begin(), changedPaths.end(), watched.fragmentPath) != changedPaths.end();
+					if (changed && !waiting) {
+
+						reloads.push_back(watched);
+					}
+				}
+			}
+			for (const WatchedProgram& watched : reloads) {
+
+				beginReload(watched);
+			}
+		}
+
+		// swap in the programs whose compile finished
+		for (size_t i = 0; i < pending.size();) {
+
+			if (!ProgramCompiler::poll(pending[i].job)) {
+
+				i++;
+				continue;
+			}
+			finishReload(pending[i]);
+			pending.erase(pending.begin() + i);
+		}
+	}
+}
@@ -0,0 +1,111 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	class Program;
+	struct ProgramCompileJob;
+
+	// bndr::ShaderHotReload
+	// Description: Static development helper that recompiles programs built from shader files when the files change on
+	// disk. A background thread waits on Win32 change notifications for the directories of the watched files and flags the
+	// files whose last write time changed. update() (called by Window::update at the start of every frame) then submits
+	// the new sources to bndr::ProgramCompiler, so they compile on the driver's threads or the compiler's worker context
+	// without stalling the frame, and polls the jobs in the following frames. A program is swapped only once its
+	// replacement linked successfully, so a shader with errors leaves the old program running and the error is printed instead.
+	// Programs are registered automatically by Program(Shader&&, Shader&&) when either shader was read from a file
+	class BNDR_API ShaderHotReload {
+
+		// a program whose shaders come from files
+		struct WatchedProgram {
+
+			Program* program;
+			// empty for a stage whose source was not read from a file (that source is kept as it was)
+			std::string vertexPath;
+			std::string fragmentPath;
+			std::string vertexSource;
+			std::string fragmentSource;
+		};
+
+		// a replacement that is compiling
+		struct PendingReload {
+
+			Program* program;
+			ProgramCompileJob* job;
+			std::string vertexSource;
+			std::string fragmentSource;
+		};
+
+		// a watched file and its last write time
+		struct WatchedFile {
+
+			std::string path;
+			unsigned long long lastWrite;
+		};
+
+		static std::mutex watchMutex;
+		static std::vector<WatchedProgram> programs;
+		static std::vector<WatchedFile> files;
+		// set when the watched directories changed so the thread rebuilds its notification handles
+		static bool filesChanged;
+		// paths written by the watcher thread and picked up by update()
+		static std::vector<std::string> changedPaths;
+		static std::atomic<bool> hasChanges;
+		// only touched on the render thread
+		static std::vector<PendingReload> pending;
+		static std::function<void(Program*)> reloadCallback;
+		static std::thread watchThread;
+		static std::atomic<bool> running;
+
+		// the body of the watcher thread
+		static void watchLoop();
+		// get the last write time of a file (0 if it cannot be read)
+		static unsigned long long getLastWriteTime(const std::string& path);
+		// read a whole file, returns false if it is missing or still locked by the editor
+		static bool readFile(const std::string& path, std::string& contents);
+		// submit the current sources of a watched program to bndr::ProgramCompiler
+		static void beginReload(const WatchedProgram& watched);
+		// finish a completed compile job, swap the program on success and print the log on failure
+		static void finishReload(PendingReload& reload);
+
+	public:
+
+		// start watching the registered files (the watcher thread runs until stop())
+		static void start();
+		// stop the watcher thread (pending compiles are dropped)
+		static void stop();
+		// check if the watcher thread is running
+		static inline bool isRunning() { return running.load(); }
+		// register a program built from files (either path may be empty, that stage keeps its current source)
+		static void watch(Program* program, const std::string& vertexPath, const std::string& fragmentPath,
+			const std::string& vertexSource, const std::string& fragmentSource);
+		// stop reloading a program (called by ~Program)
+		static void unwatch(Program* program);
+		// called after a program was swapped (its uniform values are lost and its uniform handles must be resolved again)
+		static inline void setReloadCallback(std::function<void(Program*)>&& callback) { reloadCallback = std::move(callback); }
+		// (render thread, frame boundary) start compiles for changed files and swap the programs that finished
+		static void update();
+	};
+}
@@ -0,0 +1,237 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "shader_variants.h"
+#include "shaders.h"
+
+// the transform every surface shares (the model matrix composed by the surface on the CPU, then the view of the frame globals)
+#define BNDR_SURFACE_TRANSFORM_GLSL \
+	"vec3 newPos = model * vec3(position.xy, 1.0);\n" \
+	"vec3 viewPos = view * vec3(newPos.xy, 1.0);\n" \
+	"gl_Position = vec4(viewPos.x*aspect, viewPos.y, 0.0f, 1.0);\n"
+
+namespace bndr {
+
+	// the vertex stage of every surface variant
+	static const char* const SURFACE_VERTEX_BODY =
+		BNDR_FRAME_GLOBALS_GLSL
+		"layout (location = 0) in vec3 position;\n"
+		"#ifdef BNDR_VERTEX_COLORS\n"
+		"layout (location = 1) in vec4 color;\n"
+		"#else\n"
+		"uniform vec4 color;\n"
+		"#endif\n"
+		"#ifdef BNDR_TEXTURE\n"
+		"layout (location = 2) in vec2 texCoords;\n"
+		"out vec2 fragTexCoords;\n"
+		"#endif\n"
+		"#ifdef BNDR_TEXTURE_ARRAY\n"
+		"layout (location = 3) in float texLayer;\n"
+		// the layer is the same at every vertex of a quad, so it is not interpolated
+		"flat out float fragTexLayer;\n"
+		"#endif\n"
+		"uniform mat3 model;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		BNDR_SURFACE_TRANSFORM_GLSL
+		"#ifdef BNDR_TEXTURE\n"
+		// textured surfaces have always been shifted by this much, kept so existing scenes line up
+		"gl_Position.x -= (-1.0*aspect) + 1.0;\n"
+		"fragTexCoords = texCoords;\n"
+		"#endif\n"
+		"#ifdef BNDR_TEXTURE_ARRAY\n"
+		"fragTexLayer = texLayer;\n"
+		"#endif\n"
+		"fragColor = color;\n"
+		"}\n";
+
+	// the fragment stage of every surface variant
+	static const char* const SURFACE_FRAGMENT_BODY =
+		"in vec4 fragColor;\n"
+		"out vec4 finalColor;\n"
+		"#ifdef BNDR_TEXTURE\n"
+		"in vec2 fragTexCoords;\n"
+		"#ifdef BNDR_TEXTURE_ARRAY\n"
+		"flat in float fragTexLayer;\n"
+		"uniform sampler2DArray tex0;\n"
+		"#else\n"
+		"uniform sampler2D tex0;\n"
+		"#endif\n"
+		"#endif\n"
+		"#ifdef BNDR_TEXTURE_MIX2\n"
+		"uniform sampler2D tex1;\n"
+		"uniform float nestedTexAlphaWeight;\n"
+		"#endif\n"
+		"#ifdef BNDR_TEXTURE_MIX3\n"
+		"uniform sampler2D tex2;\n"
+		"uniform float outerTexAlphaWeight;\n"
+		"#endif\n"
+		"void main() {\n"
+		"#ifdef BNDR_TEXTURE\n"
+		"#ifdef BNDR_TEXTURE_ARRAY\n"
+		"vec4 texColor = texture(tex0, vec3(fragTexCoords, fragTexLayer));\n"
+		"#else\n"
+		"vec4 texColor = texture(tex0, fragTexCoords);\n"
+		"#endif\n"
+		"#ifdef BNDR_TEXTURE_MIX2\n"
+		"texColor = mix(texColor, texture(tex1, fragTexCoords), nestedTexAlphaWeight);\n"
+		"#endif\n"
+		"#ifdef BNDR_TEXTURE_MIX3\n"
+		"texColor = mix(texColor, texture(tex2, fragTexCoords), outerTexAlphaWeight);\n"
+		"#endif\n"
+		"#ifdef BNDR_WHITE_KEY\n"
+		"if (texColor == vec4(1.0, 1.0, 1.0, 1.0)) {\n"
+		"finalColor = vec4(0.0, 0.0, 0.0, 0.0);\n"
+		"return;\n"
+		"}\n"
+		"#endif\n"
+		"finalColor = texColor * fragColor;\n"
+		"#else\n"
+		"finalColor = fragColor;\n"
+		"#endif\n"
+		"}\n";
+
+	// the feature bits with their #define and manifest names
+	struct ShaderFeatureName {
+
+		uint bit;
+		const char* define;
+		const char* name;
+	};
+	static const ShaderFeatureName FEATURE_NAMES[] = {
+
+		{ SHADER_COLOR_UNIFORM, "BNDR_COLOR_UNIFORM", "COLOR_UNIFORM" },
+		{ SHADER_VERTEX_COLORS, "BNDR_VERTEX_COLORS", "VERTEX_COLORS" },
+		{ SHADER_TEXTURE, "BNDR_TEXTURE", "TEXTURE" },
+		{ SHADER_WHITE_KEY, "BNDR_WHITE_KEY", "WHITE_KEY" },
+		{ SHADER_TEXTURE_MIX2, "BNDR_TEXTURE_MIX2", "TEXTURE_MIX2" },
+		{ SHADER_TEXTURE_MIX3, "BNDR_TEXTURE_MIX3", "TEXTURE_MIX3" },
+		{ SHADER_TEXTURE_ARRAY, "BNDR_TEXTURE_ARRAY", "TEXTURE_ARRAY" }
+	};
+
+	std::vector<Program*> ShaderVariants::precompiled;
+
+	uint ShaderVariants::normalize(uint features) {
+
+		if (features & SHADER_TEXTURE_MIX3) {
+
+			features |= SHADER_TEXTURE_MIX2;
+		}
+		if (features & (SHADER_TEXTURE_MIX2 | SHADER_WHITE_KEY | SHADER_TEXTURE_ARRAY)) {
+
+			features |= SHADER_TEXTURE;
+		}
+		if ((features & SHADER_TEXTURE_ARRAY) && (features & SHADER_TEXTURE_MIX2)) {
+
+			BNDR_EXCEPTION("A shader variant cannot mix its array texture with other textures");
+		}
+		if ((features & SHADER_COLOR_UNIFORM) && (features & SHADER_VERTEX_COLORS)) {
+
+			BNDR_EXCEPTION("A shader variant cannot take its color from both a uniform and the vertices");
+		}
+		if (!(features & (SHADER_COLOR_UNIFORM | SHADER_VERTEX_COLORS))) {
+
+			features |= SHADER_COLOR_UNIFORM;
+		}
+		return features;
+	}
+
+	std::string ShaderVariants::assembleSource(uint features, bool vertexStage) {
+
+		features = normalize(features);
+		std::string source = "# version 330 core\n";
+		for (const ShaderFeatureName& feature : FEATURE_NAMES) {
+
+			if (features & feature.bit) {
+
+				source += "#define ";
+				source += feature.define;
+				source += "\n";
+			}
+		}
+		source += vertexStage ? SURFACE_VERTEX_BODY : SURFACE_FRAGMENT_BODY;
+		return source;
+	}
+
+	Program* ShaderVariants::acquire(uint features) {
+
+		std::string vert = assembleSource(features, true);
+		std::string frag = assembleSource(features, false);
+		return Program::generateProgramFromSource(vert, frag);
+	}
+
+	void ShaderVariants::precompile(uint features) {
+
+		precompiled.push_back(acquire(features));
+	}
+
+	void ShaderVariants::loadManifest(const char* manifestPath) {
+
+		std::ifstream manifest(manifestPath, std::ios::in);
+		if (!manifest.is_open()) {
+
+			std::string message = "Failed to open shader variant manifest '" + std::string(manifestPath) + "'";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		std::string line;
+		while (std::getline(manifest, line)) {
+
+			line = line.substr(0, line.find('#'));
+			std::stringstream words(line);
+			std::string word;
+			uint features = 0;
+			bool empty = true;
+			while (words >> word) {
+
+				empty = false;
+				uint bit = 0;
+				for (const ShaderFeatureName& feature : FEATURE_NAMES) {
+
+					if (word == feature.name) {
+
+						bit = feature.bit;
+					}
+				}
+				if (bit == 0) {
+
+					std::string message = "Unknown shader feature '" + word + "' in manifest '" + std::string(manifestPath) + "'";
+					BNDR_EXCEPTION(message.c_str());
+				}
+				features |= bit;
+			}
+			if (!empty) {
+
+				precompile(features);
+			}
+		}
+	}
+
+	void ShaderVariants::releasePrecompiled() {
+
+		for (Program* program : precompiled) {
+
+			Program::release(program);
+		}
+		precompiled.clear();
+	}
+}
@@ -0,0 +1,79 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	class Program;
+
+	// bndr::shaderFeatures
+	// Description: Feature bits of the built-in surface shader. Every bit becomes a #define in front of the shared source,
+	// so a variant only contains the code its surfaces need
+	enum shaderFeatures {
+
+		// the fill color comes from the "color" uniform (BasicRect, BasicTriangle)
+		SHADER_COLOR_UNIFORM = 0x01,
+		// the color comes from vertex attribute 1 (ColorfulRect, ColorfulTriangle, TexturedRect)
+		SHADER_VERTEX_COLORS = 0x02,
+		// sample "tex0" with the texture coordinates in vertex attribute 2
+		SHADER_TEXTURE = 0x04,
+		// texels that are exactly white are drawn fully transparent
+		SHADER_WHITE_KEY = 0x08,
+		// blend "tex1" over "tex0" by "nestedTexAlphaWeight"
+		SHADER_TEXTURE_MIX2 = 0x10,
+		// blend "tex2" over the result by "outerTexAlphaWeight" (implies SHADER_TEXTURE_MIX2)
+		SHADER_TEXTURE_MIX3 = 0x20,
+		// "tex0" is a 2D array texture and the layer comes from vertex attribute 3 (implies SHADER_TEXTURE, cannot be mixed)
+		SHADER_TEXTURE_ARRAY = 0x40
+	};
+
+	// bndr::ShaderVariants
+	// Description: Static builder of the surface shader variants. The vertex and fragment bodies are single string literals
+	// assembled at compile time from shared snippets, at runtime only the #define lines of a feature set are put in front.
+	// Variants are compiled lazily the first time a surface asks for them and are shared (see Program::generateProgramFromSource),
+	// or ahead of time with precompile()/loadManifest() so that the first surface of a kind does not stall the frame
+	class BNDR_API ShaderVariants {
+
+		// programs kept alive by precompile()
+		static std::vector<Program*> precompiled;
+
+	public:
+
+		// add the bits implied by others and check that the set is valid (throws if both color sources are requested or an
+		// array texture is mixed)
+		static uint normalize(uint features);
+		// build the vertex or fragment source of a feature set
+		static std::string assembleSource(uint features, bool vertexStage);
+		// get the shared program of a feature set (give it back with Program::release)
+		// the program compiles in the background, surfaces are skipped until Program::isReady()
+		static Program* acquire(uint features);
+		// compile a variant now and keep it alive until releasePrecompiled()
+		static void precompile(uint features);
+		// precompile every variant listed in a manifest file
+		// one variant per line as feature names without the SHADER_ prefix (i.e. "VERTEX_COLORS TEXTURE WHITE_KEY"), # starts a comment
+		static void loadManifest(const char* manifestPath);
+		// give back the precompiled variants (called by ~Window while the context still exists)
+		static void releasePrecompiled();
+	};
+}
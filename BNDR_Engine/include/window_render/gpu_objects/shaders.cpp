@@ -22,12 +22,16 @@ SOFTWARE.*/
 
 #include <pch.h>
 #include "shaders.h"
+#include "../../profiling/profiler.h"
 
 namespace bndr {
 
 	// define the shader map
 	// std::unordered_map<std::string, uint> Program::programMap;
-	std::unordered_map<std::string, std::pair<Shader, Shader>> Program::shaderMap;
+	std::unordered_map<unsigned long long, std::pair<Shader, Shader>> Program::shaderMap;
+	std::unordered_map<unsigned long long, std::pair<std::string, std::string>> Program::sourceMap;
+	std::unordered_map<unsigned long long, Program*> Program::sharedPrograms;
+	// no program is bound until one is used
 
 	Shader::Shader(uint shaderType, const char* shaderSource, bool fromFile) {
 
@@ -43,6 +47,7 @@ namespace bndr {
 			std::stringstream shaderSourceStream;
 			shaderSourceStream << shaderFileBuffer.rdbuf();
 			shaderData = shaderSourceStream.str();
+			filePath = shaderSource;
 
 		}
 		// if we aren't reading from a file, then the const char pointer is the actual source code
@@ -56,65 +61,58 @@ namespace bndr {
 		GL_DEBUG_FUNC(glShaderSource(shaderID, 1, &shaderSourceCode, NULL));
 
 		// now it's time to compile the shader
+		// (the status is read when the program it is linked into completes, so the compile does not stall the thread)
 		glCompileShader(shaderID);
-
-		int infoLogLen;
-		// check for compilation errors
-		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLen);
-		if (infoLogLen > 0) {
-
-			char infoLogBuffer[250];
-			glGetShaderInfoLog(shaderID, 250, &infoLogLen, infoLogBuffer);
-			// raise an exception with the shader compilation error
-			BNDR_EXCEPTION(infoLogBuffer);
-		}
 	}
 
 	Shader::Shader(Shader&& shader) noexcept {
 
 		shaderID = shader.shaderID;
 		shaderData = shader.shaderData;
+		filePath = shader.filePath;
 	}
 
 
 	Program::Program(Shader&& vertexShader, Shader&& fragmentShader) {
 
 		// define the key to access the already compiled shaders
-		programKey = Program::generateMapKey(vertexShader, fragmentShader);
+		programKey = Program::generateProgramKey(vertexShader.getShaderSource(), fragmentShader.getShaderSource());
 
 		Shader* vShader = &vertexShader;
 		Shader* fShader = &fragmentShader;
+		// programs built directly from shaders are ready when the constructor returns, as they always were
 		// check if program already exists
-		if (Program::programExists(programKey.c_str())) {
+		if (Program::programExists(programKey)) {
 
-			std::pair<Shader,Shader>* pairPtr = &Program::shaderMap[programKey.c_str()];
-			vShader = &pairPtr->first;
-			fShader = &pairPtr->second;
-			//std::string message = "the program with map key " + std::string("\"") + programKey + std::string("\"") + " already exists\n";
-			//BNDR_MESSAGE(message.c_str());
-			return;
+			linkFromKey(programKey);
+			waitUntilReady();
 		}
+		else {
 
-		Program::linkProgram(programID, vShader, fShader);
+			compileJob = ProgramCompiler::submit(vShader->getShaderSource(), fShader->getShaderSource(), vShader->getShaderID(), fShader->getShaderID());
+			programID = compileJob->programID;
+			waitUntilReady();
 
-		// the shaders have reached the end of their scope and will be deleted automatically in
-		// the Shader class destructor once the function ends
+			// now we must not forget to add the program to the map
+			Program::sourceMap.insert(std::make_pair(programKey, std::make_pair(std::string(vShader->getShaderSource()), std::string(fShader->getShaderSource()))));
+			Program::shaderMap.insert(std::make_pair(programKey, std::make_pair(*vShader, *fShader)));
+			//std::string msg = "Added new program with hash key " + std::string("\"") + mapKey + std::string("\"");
+			//BNDR_MESSAGE(msg.c_str());
+		}
+		// programs built from shader files are recompiled when the files change (only registered once the link succeeded,
+		// a constructor that throws never runs the destructor that would unwatch the program)
+		if (!vertexShader.getFilePath().empty() || !fragmentShader.getFilePath().empty()) {
 
-		// now we must not forget to add the program to the map
-		Program::shaderMap.insert(std::make_pair(programKey.c_str(), std::make_pair(*vShader, *fShader)));
-		//std::string msg = "Added new program with hash key " + std::string("\"") + mapKey + std::string("\"");
-		//BNDR_MESSAGE(msg.c_str());
+			ShaderHotReload::watch(this, vertexShader.getFilePath(), fragmentShader.getFilePath(), vertexShader.getShaderSource(), fragmentShader.getShaderSource());
+			hotReload = true;
+		}
 	}
 
-	Program::Program(const char* mapKey) {
+	Program::Program(unsigned long long mapKey) {
 
-		std::pair<Shader,Shader>* pairPtr = &Program::shaderMap[mapKey];
 		// copy the map key
 		programKey = mapKey;
-		Shader* vShader = &pairPtr->first;
-		Shader* fShader = &pairPtr->second;
-
-		Program::linkProgram(programID, vShader, fShader);
+		linkFromKey(programKey);
 
 		//std::string message = "the program with map key " + std::string("\"") + mapKey + std::string("\"") + " already exists\n";
 		//BNDR_MESSAGE(message.c_str());
@@ -122,146 +120,350 @@ namespace bndr {
 
 	Program::Program(const Program& program) {
 
-		std::pair<Shader, Shader>* pairPtr = &Program::shaderMap[program.programKey];
 		// copy the map key
 		programKey = program.programKey;
-		Shader* vShader = &pairPtr->first;
-		Shader* fShader = &pairPtr->second;
+		linkFromKey(programKey);
+		waitUntilReady();
+	}
+
+	void Program::linkFromKey(unsigned long long key) {
+
+		const std::pair<std::string, std::string>& sources = Program::sourceMap[key];
+		programID = ProgramBinaryCache::load(sources.first, sources.second);
+		if (programID != 0) {
+
+			reflectUniforms();
+			generation++;
+			return;
+		}
+		// cache miss, compile in the background (programs built from shaders only link them again)
+		uint vertexShader = 0;
+		uint fragmentShader = 0;
+		auto shaders = Program::shaderMap.find(key);
+		if (shaders != Program::shaderMap.end()) {
+
+			vertexShader = shaders->second.first.getShaderID();
+			fragmentShader = shaders->second.second.getShaderID();
+		}
+		compileJob = ProgramCompiler::submit(sources.first, sources.second, vertexShader, fragmentShader);
+		programID = compileJob->programID;
+	}
+
+	bool Program::isReady() {
+
+		if (compileJob == nullptr) {
 
-		Program::linkProgram(programID, vShader, fShader);
+			return true;
+		}
+		if (!ProgramCompiler::poll(compileJob)) {
+
+			return false;
+		}
+		finishCompile();
+		return true;
 	}
 
-	std::vector<float> Program::getFloatUniformValue(const char* uniformName, int numFloats) const {
+	void Program::waitUntilReady() {
 
-		use();
-		try {
+		if (compileJob != nullptr) {
 
-			int uniformLocation = glGetUniformLocation(programID, uniformName);
-			if (uniformLocation == -1) {
-				std::string message = "Cannot locate uniform '" + std::string(uniformName) + "' in shader program";
-				BNDR_EXCEPTION(message.c_str());
-			}
-			std::vector<float> data(numFloats);
-			glGetUniformfv(programID, uniformLocation, &data[0]);
-			return data;
-			
+			finishCompile();
 		}
-		catch (std::runtime_error& e) {
+	}
 
-			std::cout << e.what() << "\n";
+	void Program::finishCompile() {
+
+		std::string vertexSource = compileJob->vertexSource;
+		std::string fragmentSource = compileJob->fragmentSource;
+		std::string errorLog;
+		bool linked = ProgramCompiler::finish(compileJob, errorLog);
+		compileJob = nullptr;
+		if (!linked) {
+
+			// the compiler already deleted the program object
+			programID = 0;
+			BNDR_EXCEPTION(errorLog.c_str());
 		}
-		unuse();
+		reflectUniforms();
+		generation++;
+		ProgramBinaryCache::store(programID, vertexSource, fragmentSource);
 	}
 
-	void Program::setFloatUniformValue(const char* uniformName, const float* data, uint dataType) const {
+	bool Program::hasProgramUniforms() {
 
-		use();
-		try {
+		// glProgramUniform* is core in OpenGL 4.1, on the 3.3 context it needs ARB_separate_shader_objects
+		static bool supported = (GLEW_ARB_separate_shader_objects != 0);
+		return supported;
+	}
+
+	void Program::reflectUniforms() {
 
-			int uniformLocation = glGetUniformLocation(programID, uniformName);
-			if (uniformLocation == -1) {
-				std::string message = "Cannot locate uniform '" + std::string(uniformName) + "' in shader program";
-				BNDR_EXCEPTION(message.c_str());
+		// attach the shared per frame block (the binding is program state, so it has to be set again after every link)
+		uint globalsIndex = glGetUniformBlockIndex(programID, "FrameGlobals");
+		if (globalsIndex != GL_INVALID_INDEX) {
+
+			glUniformBlockBinding(programID, globalsIndex, FRAME_GLOBALS_BINDING);
+		}
+		uniforms.clear();
+		int uniformCount = 0;
+		int maxNameLength = 0;
+		glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+		glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<char> nameBuffer(std::max<int>(maxNameLength, 1) + 1);
+		for (int i = 0; i < uniformCount; i++) {
+
+			int nameLength = 0;
+			int size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(programID, (uint)i, (int)nameBuffer.size(), &nameLength, &size, &type, &nameBuffer[0]);
+			UniformInfo info;
+			info.name.assign(&nameBuffer[0], nameLength);
+			info.location = glGetUniformLocation(programID, info.name.c_str());
+			// uniforms inside uniform blocks have no location
+			if (info.location == -1) {
+
+				continue;
 			}
-			switch (dataType) {
+			// arrays are reported as "name[0]"
+			if (info.name.size() > 3 && info.name.compare(info.name.size() - 3, 3, "[0]") == 0) {
 
-			case FLOAT:
+				info.name.resize(info.name.size() - 3);
+			}
+			info.type = (uint)type;
+			info.size = size;
+			uniforms.push_back(info);
+		}
+	}
 
-				GL_DEBUG_FUNC(glUniform1f(uniformLocation, *data));
-				break;
-			case VEC2:
+	UniformHandle Program::getUniform(const char* uniformName) const {
 
-				GL_DEBUG_FUNC(glUniform2f(uniformLocation, data[0], data[1]));
-				break;
-			case VEC3:
+		UniformHandle handle;
+		for (const UniformInfo& info : uniforms) {
 
-				GL_DEBUG_FUNC(glUniform3f(uniformLocation, data[0], data[1], data[2]));
-				break;
-			case VEC4:
+			if (info.name == uniformName) {
 
-				GL_DEBUG_FUNC(glUniform4f(uniformLocation, data[0], data[1], data[2], data[3]));
+				handle.location = info.location;
+				handle.type = info.type;
+				handle.size = info.size;
 				break;
-			case MAT2X2:
+			}
+		}
+		return handle;
+	}
 
-				GL_DEBUG_FUNC(glUniformMatrix2fv(uniformLocation, 1, GL_TRUE, data));
-				break;
-			case MAT3X3:
+	void Program::setUniform(UniformHandle uniform, const float* data) const {
 
-				GL_DEBUG_FUNC(glUniformMatrix3fv(uniformLocation, 1, GL_TRUE, data));
-				break;
-			case MAT4x4:
+		if (!uniform.isValid()) {
 
-				GL_DEBUG_FUNC(glUniformMatrix4fv(uniformLocation, 1, GL_TRUE, data));
-				break;
+			return;
+		}
+		RenderStats::addStateChange();
+		if (Program::hasProgramUniforms()) {
+
+			switch (uniform.type) {
+
+			case GL_FLOAT: glProgramUniform1fv(programID, uniform.location, uniform.size, data); break;
+			case GL_FLOAT_VEC2: glProgramUniform2fv(programID, uniform.location, uniform.size, data); break;
+			case GL_FLOAT_VEC3: glProgramUniform3fv(programID, uniform.location, uniform.size, data); break;
+			case GL_FLOAT_VEC4: glProgramUniform4fv(programID, uniform.location, uniform.size, data); break;
+			case GL_FLOAT_MAT2: glProgramUniformMatrix2fv(programID, uniform.location, uniform.size, GL_TRUE, data); break;
+			case GL_FLOAT_MAT3: glProgramUniformMatrix3fv(programID, uniform.location, uniform.size, GL_TRUE, data); break;
+			case GL_FLOAT_MAT4: glProgramUniformMatrix4fv(programID, uniform.location, uniform.size, GL_TRUE, data); break;
+			default: BNDR_MESSAGE("Cannot set a non float uniform with float data"); break;
 			}
+			return;
+		}
+		bindForUniforms();
+		switch (uniform.type) {
+
+		case GL_FLOAT: glUniform1fv(uniform.location, uniform.size, data); break;
+		case GL_FLOAT_VEC2: glUniform2fv(uniform.location, uniform.size, data); break;
+		case GL_FLOAT_VEC3: glUniform3fv(uniform.location, uniform.size, data); break;
+		case GL_FLOAT_VEC4: glUniform4fv(uniform.location, uniform.size, data); break;
+		case GL_FLOAT_MAT2: glUniformMatrix2fv(uniform.location, uniform.size, GL_TRUE, data); break;
+		case GL_FLOAT_MAT3: glUniformMatrix3fv(uniform.location, uniform.size, GL_TRUE, data); break;
+		case GL_FLOAT_MAT4: glUniformMatrix4fv(uniform.location, uniform.size, GL_TRUE, data); break;
+		default: BNDR_MESSAGE("Cannot set a non float uniform with float data"); break;
+		}
+	}
+
+	void Program::setUniform(UniformHandle uniform, const int* data) const {
+
+		if (!uniform.isValid()) {
+
+			return;
 		}
-		catch (std::runtime_error& e) {
+		RenderStats::addStateChange();
+		if (uniform.type == GL_FLOAT || uniform.type == GL_FLOAT_VEC2 || uniform.type == GL_FLOAT_VEC3 || uniform.type == GL_FLOAT_VEC4
+			|| uniform.type == GL_FLOAT_MAT2 || uniform.type == GL_FLOAT_MAT3 || uniform.type == GL_FLOAT_MAT4) {
 
-			std::cout << e.what() << "\n";
+			BNDR_MESSAGE("Cannot set a float uniform with int data");
+			return;
 		}
-		unuse();
+		// ints, bools and samplers are all set with the 1i family
+		if (Program::hasProgramUniforms()) {
+
+			glProgramUniform1iv(programID, uniform.location, uniform.size, data);
+			return;
+		}
+		bindForUniforms();
+		glUniform1iv(uniform.location, uniform.size, data);
 	}
 
-	void Program::setFloatArrayUniformValue(const char* uniformName, const float* data, int arraySize) const {
+	// report a uniform that is not active in a program (the name based setters used to throw and catch this)
+	static void reportMissingUniform(const char* uniformName) {
 
-		use();
-		try {
+		std::string message = "Cannot locate uniform '" + std::string(uniformName) + "' in shader program";
+		BNDR_MESSAGE(message.c_str());
+	}
 
-			int uniformLocation = glGetUniformLocation(programID, uniformName);
-			if (uniformLocation == -1) {
-				std::string data = "Cannot locate uniform '" + std::string(uniformName) + "' in shader program";
-				BNDR_EXCEPTION(data.c_str());
-			}
-			GL_DEBUG_FUNC(glUniform1fv(uniformLocation, arraySize, data));
+	// get the OpenGL type of a bndr::uniformDataTypes value (0 if it is not one)
+	static uint toGLUniformType(uint dataType) {
+
+		switch (dataType) {
+
+		case FLOAT: return GL_FLOAT;
+		case VEC2: return GL_FLOAT_VEC2;
+		case VEC3: return GL_FLOAT_VEC3;
+		case VEC4: return GL_FLOAT_VEC4;
+		case MAT2X2: return GL_FLOAT_MAT2;
+		case MAT3X3: return GL_FLOAT_MAT3;
+		case MAT4x4: return GL_FLOAT_MAT4;
+		default: return 0;
+		}
+	}
+
+	std::vector<float> Program::getFloatUniformValue(const char* uniformName, int numFloats) const {
+
+		std::vector<float> data;
+		if (numFloats <= 0) {
+
+			return data;
 		}
-		catch (std::runtime_error& e) {
+		data.resize(numFloats);
+		UniformHandle uniform = getUniform(uniformName);
+		if (!uniform.isValid()) {
 
-			std::cout << e.what();
+			reportMissingUniform(uniformName);
+			return data;
 		}
-		unuse();
+		glGetUniformfv(programID, uniform.location, &data[0]);
+		return data;
 	}
 
-	void Program::setIntArrayUniformValue(const char* uniformName, const int* data, int arraySize) const {
+	void Program::setFloatUniformValue(const char* uniformName, const float* data, uint dataType) const {
 
-		use();
-		try {
+		BNDR_PROFILE_SCOPE("Program::setFloatUniformValue");
+		UniformHandle uniform = getUniform(uniformName);
+		if (!uniform.isValid()) {
 
-			int uniformLocation = glGetUniformLocation(programID, uniformName);
-			if (uniformLocation == -1) {
-				std::string data = "Cannot locate uniform '" + std::string(uniformName) + "' in shader program";
-				BNDR_EXCEPTION(data.c_str());
-			}
-			GL_DEBUG_FUNC(glUniform1iv(uniformLocation, arraySize, data));
+			reportMissingUniform(uniformName);
+			return;
+		}
+		if (toGLUniformType(dataType) != uniform.type) {
+
+			std::string message = "The data type passed for uniform '" + std::string(uniformName) + "' does not match its type in the shader program";
+			BNDR_MESSAGE(message.c_str());
+			return;
 		}
-		catch (std::runtime_error& e) {
+		// a single value, like the glUniform*f calls this used to make (arrays go through setFloatArrayUniformValue)
+		uniform.size = 1;
+		setUniform(uniform, data);
+	}
+
+	void Program::setFloatArrayUniformValue(const char* uniformName, const float* data, int arraySize) const {
 
-			std::cout << e.what();
+		UniformHandle uniform = getUniform(uniformName);
+		if (!uniform.isValid()) {
+
+			reportMissingUniform(uniformName);
+			return;
 		}
-		unuse();
+		uniform.size = std::min<int>(uniform.size, arraySize);
+		setUniform(uniform, data);
+	}
+
+	void Program::setIntArrayUniformValue(const char* uniformName, const int* data, int arraySize) const {
+
+		UniformHandle uniform = getUniform(uniformName);
+		if (!uniform.isValid()) {
+
+			reportMissingUniform(uniformName);
+			return;
+		}
+		uniform.size = std::min<int>(uniform.size, arraySize);
+		setUniform(uniform, data);
 	}
 
 	void Program::setIntUniformValue(const char* uniformName, int value) {
 
-		use();
-		try {
+		UniformHandle uniform = getUniform(uniformName);
+		if (!uniform.isValid()) {
 
-			int uniformLocation = glGetUniformLocation(programID, uniformName);
-			if (uniformLocation == -1) {
-				std::string data = "Cannot locate uniform '" + std::string(uniformName) + "' in shader program";
-				BNDR_EXCEPTION(data.c_str());
-			}
-			GL_DEBUG_FUNC(glUniform1i(uniformLocation, value));
+			reportMissingUniform(uniformName);
+			return;
 		}
-		catch (std::runtime_error& e) {
+		uniform.size = 1;
+		setUniform(uniform, &value);
+	}
+
+	void Program::swapLinkedProgram(uint newProgramID, const std::string& vertexSource, const std::string& fragmentSource) {
+
+		// the first link has to be done before it can be replaced
+		waitUntilReady();
+		// keep the program current if it was (a deleted program stays in use until it is unbound)
+		bool wasInUse = (GLState::getProgram() == programID);
+		GLState::deleteProgram(programID);
+		if (wasInUse) {
 
-			std::cout << e.what();
+			GLState::useProgram(newProgramID);
 		}
-		unuse();
+		programID = newProgramID;
+		reflectUniforms();
+		generation++;
+		// the new program starts with every sampler on unit 0
+		textureUnit = -1;
+		// copies made from now on get the new sources
+		programKey = Program::generateProgramKey(vertexSource, fragmentSource);
+		if (!Program::programExists(programKey)) {
+
+			Program::sourceMap.insert(std::make_pair(programKey, std::make_pair(vertexSource, fragmentSource)));
+		}
+		ProgramBinaryCache::store(programID, vertexSource, fragmentSource);
+	}
+
+	void Program::release(Program* program) {
 
+		if (program == nullptr) {
+
+			return;
+		}
+		if (program->shared) {
+
+			if (--program->references > 0) {
+
+				return;
+			}
+			Program::sharedPrograms.erase(program->programKey);
+		}
+		delete program;
 	}
 
 	Program::~Program() {
 
-		glDeleteProgram(programID);
+		if (hotReload) {
+
+			ShaderHotReload::unwatch(this);
+		}
+		if (compileJob != nullptr) {
+
+			// a failed job deletes its program object itself
+			std::string errorLog;
+			if (!ProgramCompiler::finish(compileJob, errorLog)) {
+
+				return;
+			}
+		}
+		GLState::deleteProgram(programID);
 	}
 }
@@ -24,6 +24,14 @@ SOFTWARE.*/
 #include <pch.h>
 #include "../../data_structures/matrices.h"
 #include "GLDebug.h"
+#include "program_cache.h"
+#include "UniformBuffer.h"
+#include "GLState.h"
+#include "program_compiler.h"
+#include "shader_reload.h"
+#include "shader_variants.h"
+#include "../../data_structures/hashing.h"
+#include "../../profiling/render_stats.h"
 
 
 namespace bndr {
@@ -42,6 +50,8 @@ namespace bndr {
 		uint shaderID;
 		// shader source code
 		std::string shaderData;
+		// the file the source was read from (empty if the source was passed directly)
+		std::string filePath;
 
 	public:
 
@@ -55,9 +65,9 @@ namespace bndr {
 		// Description: This constructor creates and compiles an OpenGL shader to be used in a program
 		Shader(uint shaderType, const char* shaderSource, bool fromFile = false);
 		// copy constructor
-		Shader(const Shader& shader) { shaderID = shader.shaderID; shaderData = shader.shaderData; }
+		Shader(const Shader& shader) { shaderID = shader.shaderID; shaderData = shader.shaderData; filePath = shader.filePath; }
 
-		inline Shader& operator=(const Shader& shader) { shaderID = shader.shaderID; shaderData = shader.shaderData; return (*this); }
+		inline Shader& operator=(const Shader& shader) { shaderID = shader.shaderID; shaderData = shader.shaderData; filePath = shader.filePath; return (*this); }
 		// move constructor
 		Shader(Shader&& shader) noexcept;
 		// get the shaderID (read-only)
@@ -66,6 +76,8 @@ namespace bndr {
 		inline const char* getShaderSource() { return shaderData.c_str(); }
 		// get length of shader source code
 		inline int getShaderLength() { return shaderData.size(); }
+		// get the file the source was read from (empty if it was not read from a file)
+		inline const std::string& getFilePath() const { return filePath; }
 		~Shader() { BNDR_MESSAGE("Shader Deleted!"); }
 	};
 
@@ -80,19 +92,78 @@ namespace bndr {
 		MAT4x4 = 7
 	};
 
+	// an active uniform of a linked program (reflected with glGetActiveUniform)
+	struct UniformInfo {
+
+		// the name of the uniform (arrays are stored without the trailing "[0]")
+		std::string name;
+		int location;
+		// the OpenGL type (i.e. GL_FLOAT_VEC2 or GL_SAMPLER_2D)
+		uint type;
+		// the number of array elements (1 for non arrays)
+		int size;
+	};
+
+	// bndr::UniformHandle
+	// Description: A uniform of a specific program resolved once with Program::getUniform. The handle carries the
+	// reflected type and array size, so setting a value needs no name lookup and picks the right glUniform call by itself.
+	// An invalid handle (the uniform is not active in the program) is ignored when set
+	struct UniformHandle {
+
+		int location = -1;
+		uint type = 0;
+		int size = 0;
+		inline bool isValid() const { return location != -1; }
+	};
+
 	// bndr::Program
 	// Description: class that contains OpenGL program given shaders to compile and link
 	class Program {
 
 		uint programID;
+		// every active uniform of the program (filled in after linking)
+		std::vector<UniformInfo> uniforms;
+
+		// read the active uniforms of the linked program into the uniform table
+		void reflectUniforms();
+		// make the program current for glUniform* calls if glProgramUniform* is not available (it stays bound afterwards)
+		inline void bindForUniforms() const { GLState::useProgram(programID); }
+		// check if values can be written with glProgramUniform* (no program bind needed)
+		static bool hasProgramUniforms();
 		// make sure we do not have duplicate programs as well as store static template programs in the map
 
-		// map of previously created shaders so that shaders are not created more than once for new programs
-		static std::unordered_map<std::string, std::pair<Shader, Shader>> shaderMap;
+		// the shaders handed to Program(Shader&&, Shader&&), copies of those programs link them again instead of compiling
+		static std::unordered_map<unsigned long long, std::pair<Shader, Shader>> shaderMap;
+		// the vertex and fragment source of every program key
+		static std::unordered_map<unsigned long long, std::pair<std::string, std::string>> sourceMap;
+		// the shared program of every key handed out by generateProgramFromSource
+		static std::unordered_map<unsigned long long, Program*> sharedPrograms;
+
+		// link programID for a known program key, from the binary cache if possible (ready right away), otherwise the
+		// compile and link are submitted to bndr::ProgramCompiler and the program is pending until isReady()
+		void linkFromKey(unsigned long long key);
+		// the compile and link in flight (nullptr once the program is ready)
+		ProgramCompileJob* compileJob = nullptr;
+		// incremented every time a link finishes (see getGeneration)
+		uint generation = 0;
+		// read the result of the compile job, reflect the uniforms and store the binary (throws if the program failed to link)
+		void finishCompile();
 
 		// save the key so when we copy the program it generates the equivalent program quickly from the
 		// respective shaders
-		std::string programKey;
+		unsigned long long programKey = 0;
+		// shared programs are deleted by release() once nothing references them anymore
+		bool shared = false;
+		int references = 1;
+		// set when the program is registered with ShaderHotReload
+		bool hotReload = false;
+		// the unit the texture sampler was last pointed at by setTextureUnit (-1 if it was not yet)
+		int textureUnit = -1;
+
+		friend class ShaderHotReload;
+		friend class ShaderVariants;
+		// replace the linked program with a newly linked one built from new sources (used by ShaderHotReload)
+		void swapLinkedProgram(uint newProgramID, const std::string& vertexSource, const std::string& fragmentSource);
 	public:
 
 		Program() : programID(0) {}
@@ -105,13 +176,42 @@ namespace bndr {
 		Program(Program&& program) = delete;
 		Program& operator=(const Program& program) = delete;
 		inline uint getID() { return programID; }
+		// check if the program finished compiling and linking without waiting for it (a pending program has no uniforms
+		// and must not be drawn with)
+		bool isReady();
+		// wait until the program finished compiling and linking
+		void waitUntilReady();
+		// incremented every time the program is linked (also by a hot reload), uniform handles resolved for another
+		// generation are stale
+		inline uint getGeneration() const { return generation; }
 		// use the program
-		inline void use() const { glUseProgram(programID); }
-		// stop using the program
-		inline void unuse() const { glUseProgram(0); }
+		inline void use() const { GLState::useProgram(programID); }
+		// stop using the program (not needed between draws, the next use() replaces it)
+		inline void unuse() const { GLState::useProgram(0); }
+		// get the active uniforms of the program
+		inline const std::vector<UniformInfo>& getUniforms() const { return uniforms; }
+		// resolve a uniform by name (do this once and keep the handle, the handle is invalid if the uniform is not active)
+		UniformHandle getUniform(const char* uniformName) const;
+		// set a float, vector or matrix uniform (or an array of them) from the data (matrices are row major)
+		void setUniform(UniformHandle uniform, const float* data) const;
+		// set a float uniform
+		inline void setUniform(UniformHandle uniform, float value) const { setUniform(uniform, &value); }
+		// set an int, bool or sampler uniform (or an array of them) from the data
+		void setUniform(UniformHandle uniform, const int* data) const;
+		// set an int, bool or sampler uniform
+		inline void setUniform(UniformHandle uniform, int value) const { setUniform(uniform, &value); }
+		// point the texture sampler of the program at a unit (nothing is sent if it already reads that unit)
+		inline void setTextureUnit(UniformHandle sampler, int unit) {
+			if (textureUnit != unit) {
+				setUniform(sampler, unit);
+				textureUnit = unit;
+			}
+		}
 		// get back a float uniform value
 		std::vector<float> getFloatUniformValue(const char* uniformName, int numFloats) const;
 		// modify a uniform value that whose primitive attribute(s) is/are of type float
+		// (looks the uniform up by name every call, keep a UniformHandle from getUniform for anything done per frame)
+		// dataType is one of bndr::uniformDataTypes, nothing is set if it does not match the type of the uniform
 		void setFloatUniformValue(const char* uniformName, const float* data, uint dataType) const;
 		// modify a uniform value that is an array of type float
 		void setFloatArrayUniformValue(const char* uniformName, const float* data, int arraySize) const;
@@ -119,257 +219,111 @@ namespace bndr {
 		void setIntArrayUniformValue(const char* uniformName, const int* data, int arraySize) const;
 		// modify a uniform value that is a single int
 		void setIntUniformValue(const char* uniformName, int value);
+		// give back a shared program from ShaderVariants::acquire (or generateProgramFromSource), it is deleted with the last
+		// reference (programs that are not shared, like the ones of the templates, are deleted right away)
+		static void release(Program* program);
+		// get the number of owners of a shared program
+		inline int getReferenceCount() const { return references; }
 		// deletes the OpenGL program
 		~Program();
 
-		static void linkProgram(uint& programID, Shader* vShader, Shader* fShader) {
-
-			// create the program and attach the shaders
-			programID = glCreateProgram();
-			glAttachShader(programID, vShader->getShaderID());
-			glAttachShader(programID, fShader->getShaderID());
-
-			// link the program
-			glLinkProgram(programID);
-
-			// check for link errors
-			int infoLogLen;
-			glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &infoLogLen);
-
-			if (infoLogLen > 0) {
-
-				char infoLogBuffer[250];
-				glGetProgramInfoLog(programID, 250, &infoLogLen, infoLogBuffer);
-				// raise an exception with the program link error
-				BNDR_EXCEPTION(infoLogBuffer);
-			}
-
-			// detach the shaders
-			glDetachShader(programID, vShader->getShaderID());
-			glDetachShader(programID, fShader->getShaderID());
-		}
-
-		// program templates
+		// program templates (kept for existing code, every call returns a ready program of its own built from the matching
+		// variant of bndr::ShaderVariants, the caller owns it and deletes it as before)
 
 		// this template is meant to be used for polygons of one single color
-		static Program* defaultPolygonProgram() {
-
-			std::string vert = "# version 330 core\n"
-				"layout (location = 0) in vec3 position;\n"
-				"uniform float aspect;\n"
-				"uniform vec2 center;\n"
-				"uniform vec2 translation;\n"
-				"uniform float theta;\n"
-				"uniform vec2 scale;\n"
-				"uniform vec4 color;\n"
-				"out vec4 fragColor;\n"
-				"void main() {\n"
-				"vec3 newPos = position;\n"
-				"newPos.x *= scale.x;\n"
-				"newPos.y *= scale.y;\n"
-				"vec3 rotation = vec3(cos(theta), sin(theta), 0.0);\n"
-				"vec3 rotCenter = vec3(center, 0.0);\n"
-				"newPos -= rotCenter;\n"
-				"vec3 rotPos = vec3(newPos.x * rotation.x - newPos.y * rotation.y, newPos.y * rotation.x + newPos.x * rotation.y, 0.0);\n"
-				"newPos = rotPos + rotCenter;\n"
-				"newPos += vec3(translation, 0.0);\n"
-				"newPos.z = 0.0;\n"
-				"gl_Position = vec4(newPos.x*aspect, newPos.y, 0.0f, 1.0);\n"
-				"fragColor = color;\n"
-				"}\0";
-			std::string frag = "# version 330 core\n"
-				"in vec4 fragColor;\n"
-				"out vec4 finalColor;\n"
-				"void main() {\n"
-				"finalColor = fragColor;\n"
-				"}\0";
-			return Program::generateProgramFromSource(vert, frag);
-		}
+		static Program* defaultPolygonProgram() { return Program::readyVariant(SHADER_COLOR_UNIFORM); }
 
 		// this template is for drawing polygons with multiple blended colors for each vertex
-		static Program* multiColorPolygonProgram() {
-
-			std::string vert = "# version 330 core\n"
-				"layout (location = 0) in vec3 position;\n"
-				"layout (location = 1) in vec4 color;\n"
-				"uniform float aspect;\n"
-				"uniform vec2 center;\n"
-				"uniform vec2 translation;\n"
-				"uniform float theta;\n"
-				"uniform vec2 scale;\n"
-				"out vec4 fragColor;\n"
-				"void main() {\n"
-				"vec3 newPos = position;\n"
-				"newPos.x *= scale.x;\n"
-				"newPos.y *= scale.y;\n"
-				"vec3 rotation = vec3(cos(theta), sin(theta), 0.0);\n"
-				"vec3 rotCenter = vec3(center, 0.0);\n"
-				"newPos -= rotCenter;\n"
-				"vec3 rotPos = vec3(newPos.x * rotation.x - newPos.y * rotation.y, newPos.y * rotation.x + newPos.x * rotation.y, 0.0);\n"
-				"newPos = rotPos + rotCenter;\n"
-				"newPos += vec3(translation, 0.0);\n"
-				"newPos.z = 0.0;\n"
-				"gl_Position = vec4(newPos.x*aspect, newPos.y, 0.0f, 1.0);\n"
-				"fragColor = color;\n"
-				"}\0";
-			std::string frag = "# version 330 core\n"
-				"in vec4 fragColor;\n"
-				"out vec4 finalColor;\n"
-				"void main() {\n"
-				"finalColor = fragColor;\n"
-				"}\0";
-			return Program::generateProgramFromSource(vert, frag);
-		}
+		static Program* multiColorPolygonProgram() { return Program::readyVariant(SHADER_VERTEX_COLORS); }
 
-		// this template is meant for textured rects or triangles with only one texture
+		// this template is meant for textured rects or triangles
+		// (2 or 3 blends that many textures, any other number samples one texture and keys out white texels)
+		// the surface binds its own texture for "tex0", the others are bound by the caller, either with Texture::setSlot and
+		// bind() or with Texture::bindToFreeUnit(), and their unit index is given to "tex1" and "tex2" with setIntUniformValue
 		static Program* texPolygonProgram(int numTexes) {
 
-			std::string vert = "# version 330 core\n"
-				"layout (location = 0) in vec3 position;\n"
-				"layout (location = 1) in vec4 color;\n"
-				"layout (location = 2) in vec2 texCoords;\n"
-				"uniform float aspect;\n"
-				"uniform vec2 center;\n"
-				"uniform vec2 translation;\n"
-				"uniform float theta;\n"
-				"uniform vec2 scale;\n"
-				"out vec4 fragColor;\n"
-				"out vec2 fragTexCoords;\n"
-				"void main() {\n"
-				"vec3 newPos = position;\n"
-				"newPos.x *= scale.x;\n"
-				"newPos.y *= scale.y;\n"
-				"vec3 rotation = vec3(cos(theta), sin(theta), 0.0);\n"
-				"vec3 rotCenter = vec3(center, 0.0);\n"
-				"newPos -= rotCenter;\n"
-				"vec3 rotPos = vec3(newPos.x * rotation.x - newPos.y * rotation.y, newPos.y * rotation.x + newPos.x * rotation.y, 0.0);\n"
-				"newPos = rotPos + rotCenter;\n"
-				"newPos += vec3(translation, 0.0);\n"
-				"newPos.z = 0.0;\n"
-				"float xTransFix = (-1.0*aspect) + 1.0;\n"
-				"gl_Position = vec4(newPos.x*aspect, newPos.y, 0.0f, 1.0);\n"
-				"gl_Position.x -= xTransFix;\n"
-				"fragColor = color;\n"
-				"fragTexCoords = texCoords;\n"
-				"}\0";
-			std::string frag;
 			switch (numTexes) {
 
-			default:
-
-				frag = "# version 330 core\n"
-					"in vec4 fragColor;\n"
-					"in vec2 fragTexCoords;\n"
-					"uniform sampler2D tex0;\n"
-					"out vec4 finalColor;\n"
-					"void main(){\n"
-					"vec4 white = vec4(1.0, 1.0, 1.0, 1.0);\n"
-					"vec4 texColor = texture(tex0, fragTexCoords);\n"
-					"if (texColor == white) {\n"
-					"finalColor = vec4(0.0, 0.0, 0.0, 0.0);\n"
-					"} else {\n"
-					"finalColor = texColor * fragColor;\n"
-					"}\n"
-					"}\0";
-				break;
-			case 2:
-
-				frag = "# version 330 core\n"
-					"in vec4 fragColor;\n"
-					"in vec2 fragTexCoords;\n"
-					"uniform sampler2D tex0;\n"
-					"uniform sampler2D tex1;\n"
-					"uniform float nestedTexAlphaWeight;\n"
-					"out vec4 finalColor;\n"
-					"void main(){\n"
-					"finalColor = mix(texture(tex0, fragTexCoords),texture(tex1, fragTexCoords), nestedTexAlphaWeight) * fragColor;\n"
-					"}\0";
-				break;
-			case 3:
-
-				frag = "# version 330 core\n"
-					"in vec4 fragColor;\n"
-					"in vec2 fragTexCoords;\n"
-					"uniform sampler2D tex0;\n"
-					"uniform sampler2D tex1;\n"
-					"uniform sampler2D tex2;\n"
-					"uniform float nestedTexAlphaWeight;\n"
-					"uniform float outerTexAlphaWeight;\n"
-					"out vec4 finalColor;\n"
-					"void main(){\n"
-					"finalColor = mix(mix(texture(tex0, fragTexCoords),texture(tex1, fragTexCoords), nestedTexAlphaWeight), texture(tex2, fragTexCoords), outerTexAlphaWeight) * fragColor;\n"
-					"}\0";
-				break;
-
-
+			case 2: return Program::readyVariant(SHADER_VERTEX_COLORS | SHADER_TEXTURE_MIX2);
+			case 3: return Program::readyVariant(SHADER_VERTEX_COLORS | SHADER_TEXTURE_MIX3);
+			default: return Program::readyVariant(SHADER_VERTEX_COLORS | SHADER_TEXTURE | SHADER_WHITE_KEY);
 			}
-			return Program::generateProgramFromSource(vert, frag);
-
 		}
 	private:
 
-		// retrieve existing program with program map key
-		// this constructor is private because it is only allowed to be called when the key is valid (see generateFromProgramSource(...))
-		Program(const char* programMapKey);
-
-		// generates a map key for a given vertex and fragment shader
-		static std::string generateMapKey(Shader& vertexShader, Shader& fragmentShader) {
-
-			const char* vShaderSource = vertexShader.getShaderSource();
-			const char* fShaderSource = fragmentShader.getShaderSource();
+		// get an owned copy of a shader variant (the templates hand out programs that can be used right away and deleted)
+		static Program* readyVariant(uint features) {
 
-			return generateMapKey(vShaderSource, fShaderSource, vertexShader.getShaderLength(), fragmentShader.getShaderLength());
+			// once the variant is ready its binary is cached, so the copy links without compiling again
+			Program* variant = ShaderVariants::acquire(features);
+			variant->waitUntilReady();
+			Program* program = new Program(*variant);
+			Program::release(variant);
+			return program;
 		}
 
-		// generates a map key for a given vertex and fragment shader source and char lengths
-		static std::string generateMapKey(const char* vertexShader, const char* fragmentShader, int vertexShaderLen, int fragmentShaderLen) {
-
-			// we strategically pick a key that is almost certainly guaranteed to be unique
-			// in order to avoid overwritting issues
-			// first we create the string for the map key
-			char key[11];
-			key[10] = '\0';
-			std::string mapKey(key);
-
-			// then for each shader pick five characters from it
-			int vShaderIncrement = (vertexShaderLen) / 5;
-			int fShaderIncrement = (fragmentShaderLen) / 5;
-
-			const char* vShaderSource = vertexShader;
-			const char* fShaderSource = fragmentShader;
-
-			for (int i = 0; i < 5; i++) {
+		// retrieve existing program with program map key
+		// this constructor is private because it is only allowed to be called when the key is valid (see generateFromProgramSource(...))
+		Program(unsigned long long programMapKey);
 
-				// skip the first 32 ascii characters to avoid overwriting buffer
-				mapKey[i] = (char)((((int)vShaderSource[((i + 1) * vShaderIncrement)] + (int)vShaderSource[i * vShaderIncrement]) % 95) + 32);
-			}
-			for (int i = 6; i < 11; i++) {
+		// generates the key of a vertex and fragment shader source pair (a 64 bit FNV-1a hash of the full source of both stages)
+		static unsigned long long generateProgramKey(const std::string& vertexSource, const std::string& fragmentSource) {
 
-				mapKey[i - 1] = (char)(((int)fShaderSource[((i - 5) * fShaderIncrement)] + (int)fShaderSource[(i - 6) * fShaderIncrement]) % 95) + 32;
-			}
-			return mapKey;
+			return hashString(fragmentSource, hashString(vertexSource));
 		}
 
-		static bool programExists(const char* mapKey) {
+		static bool programExists(unsigned long long mapKey) {
 
 			// check if program already exists
-			if (Program::shaderMap.find(mapKey) != Program::shaderMap.end()) {
+			if (Program::sourceMap.find(mapKey) != Program::sourceMap.end()) {
 
 				return true;
 			}
 			return false;
 		}
 
+		// get the shared program of a source pair (linked the first time, after that only a reference is added)
+		// hand the reference back with Program::release instead of deleting it, the program may still be compiling (see isReady)
 		static Program* generateProgramFromSource(std::string& vShaderSource, std::string& fShaderSource) {
 
-			std::string programKey = Program::generateMapKey(vShaderSource.c_str(), fShaderSource.c_str(), vShaderSource.size(), fShaderSource.size());
-			if (Program::programExists(programKey.c_str())) {
+			unsigned long long programKey = Program::generateProgramKey(vShaderSource, fShaderSource);
+			auto existing = Program::sharedPrograms.find(programKey);
+			if (existing != Program::sharedPrograms.end()) {
+
+				existing->second->references++;
+				return existing->second;
+			}
+			if (!Program::programExists(programKey)) {
 
-				return new Program(programKey.c_str());
+				// the shaders are only compiled if the binary cache misses
+				Program::sourceMap.insert(std::make_pair(programKey, std::make_pair(vShaderSource, fShaderSource)));
 			}
-			return new Program(Shader(VERTEX_SHADER, vShaderSource.c_str()), Shader(FRAGMENT_SHADER, fShaderSource.c_str()));
+			Program* program = new Program(programKey);
+			program->shared = true;
+			Program::sharedPrograms.insert(std::make_pair(programKey, program));
+			return program;
 		}
 	};
-}
-
 
+	// the uniforms every surface program has, resolved once per link of the program so the setters never look names up
+	struct SurfaceUniforms {
+
+		// the generation of the program the handles were resolved for (0 means never resolved)
+		uint generation = 0;
+		// scale, rotation about the rotation point and translation in one matrix
+		UniformHandle model;
+		// only in the single color program
+		UniformHandle color;
+		// only in the textured programs
+		UniformHandle texture;
+
+		// resolve the handles of a ready program
+		inline void resolve(const Program* program) {
+
+			generation = program->getGeneration();
+			model = program->getUniform("model");
+			color = program->getUniform("color");
+			texture = program->getUniform("tex0");
+		}
+	};
+}
@@ -0,0 +1,426 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "texture_atlas.h"
+#include "../../profiling/profiler.h"
+
+namespace bndr {
+
+	// the first line of every atlas manifest
+	static const char* const ATLAS_MANIFEST_MAGIC = "bndr_atlas";
+	static const int ATLAS_MANIFEST_VERSION = 1;
+
+	// fill in the texture coordinates of a region from its pixel rect
+	static void computeRegionUV(AtlasRegion& region, int pageSize) {
+
+		float size = (float)pageSize;
+		region.uv[0] = (float)region.x / size;
+		region.uv[1] = (float)region.y / size;
+		region.uv[2] = (float)(region.x + region.width) / size;
+		region.uv[3] = (float)(region.y + region.height) / size;
+	}
+
+	// write a little endian integer of a bitmap header
+	static void writeHeaderValue(uchar* header, int offset, uint value, int bytes) {
+
+		for (int i = 0; i < bytes; i++) {
+
+			header[offset + i] = (uchar)((value >> (8 * i)) & 0xFF);
+		}
+	}
+
+	TextureAtlas::TextureAtlas(int size, int imagePadding, uint textureFiltering) : pageSize(size), padding(imagePadding), filtering(textureFiltering) {
+
+		if (pageSize <= 0 || padding < 0) {
+
+			BNDR_EXCEPTION("A texture atlas needs a positive page size and a padding of at least 0");
+		}
+		// no file has this name, so the pages never collide with loaded textures or the pages of another atlas
+		static std::atomic<unsigned long long> atlasCount(0);
+		key = "<texture atlas " + std::to_string(atlasCount.fetch_add(1)) + ">";
+	}
+
+	TextureAtlas::Page* TextureAtlas::addPage() {
+
+		Page* page = new Page();
+		// unused texels are transparent, so nothing shows around the images even without the white key
+		page->pixels.assign((size_t)getRowBytes() * pageSize, 0);
+		page->skyline.push_back({ 0, 0, pageSize });
+		pages.push_back(page);
+		return page;
+	}
+
+	bool TextureAtlas::findPosition(const Page& page, int width, int height, int& nodeIndex, int& x, int& y) const {
+
+		int bestY = pageSize + 1;
+		for (int i = 0; i < (int)page.skyline.size(); i++) {
+
+			int left = page.skyline[i].x;
+			if (left + width > pageSize) {
+
+				break;
+			}
+			// the rect rests on the highest segment below it
+			int top = 0;
+			int remaining = width;
+			for (int j = i; remaining > 0; j++) {
+
+				top = std::max<int>(top, page.skyline[j].y);
+				remaining -= page.skyline[j].width;
+			}
+			if (top + height <= pageSize && top < bestY) {
+
+				bestY = top;
+				nodeIndex = i;
+				x = left;
+			}
+		}
+		if (bestY > pageSize) {
+
+			return false;
+		}
+		y = bestY;
+		return true;
+	}
+
+	void TextureAtlas::addSkylineLevel(Page& page, int nodeIndex, int x, int y, int width, int height) {
+
+		std::vector<SkylineNode>& skyline = page.skyline;
+		skyline.insert(skyline.begin() + nodeIndex, { x, y + height, width });
+		// cut away the segments the new one covers
+		for (int i = nodeIndex + 1; i < (int)skyline.size();) {
+
+			const SkylineNode& previous = skyline[i - 1];
+			int overlap = previous.x + previous.width - skyline[i].x;
+			if (overlap <= 0) {
+
+				break;
+			}
+			skyline[i].x += overlap;
+			skyline[i].width -= overlap;
+			if (skyline[i].width > 0) {
+
+				break;
+			}
+			skyline.erase(skyline.begin() + i);
+		}
+		// merge neighbours at the same height
+		for (int i = 0; i + 1 < (int)skyline.size();) {
+
+			if (skyline[i].y == skyline[i + 1].y) {
+
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+				continue;
+			}
+			i++;
+		}
+	}
+
+	void TextureAtlas::blit(Page& page, const BitMapData& image, int x, int y, int imagePadding) {
+
+		int rowBytes = getRowBytes();
+		int imageRowBytes = image.getRowBytes();
+		const uchar* source = image.ptr.get();
+		// 32 bit images without an alpha mask have an unused fourth byte (see MappedBitMap)
+		bool hasAlpha = image.internalFormat == GL_RGBA;
+		int paddedWidth = image.width + 2 * imagePadding;
+		int paddedHeight = image.height + 2 * imagePadding;
+		for (int row = 0; row < paddedHeight; row++) {
+
+			// the padding repeats the nearest edge pixel of the image
+			int sourceRow = std::min<int>(std::max<int>(row - imagePadding, 0), image.height - 1);
+			uchar* destination = &page.pixels[(size_t)(y + row) * rowBytes + (size_t)x * 4];
+			const uchar* sourceLine = source + (size_t)sourceRow * imageRowBytes;
+			for (int column = 0; column < paddedWidth; column++) {
+
+				int sourceColumn = std::min<int>(std::max<int>(column - imagePadding, 0), image.width - 1);
+				const uchar* pixel = sourceLine + sourceColumn * image.bytesPerPixel;
+				uchar* texel = destination + column * 4;
+				texel[0] = pixel[0];
+				texel[1] = pixel[1];
+				texel[2] = pixel[2];
+				texel[3] = hasAlpha ? pixel[3] : 0xFF;
+			}
+		}
+		page.dirty = true;
+	}
+
+	const AtlasRegion& TextureAtlas::add(const std::string& name, const char* bitMapFile) {
+
+		// like bndr::Texture, the same name is only loaded once
+		auto existing = regions.find(name);
+		if (existing != regions.end()) {
+
+			return existing->second;
+		}
+		BitMapData image = Texture::loadBitMap(bitMapFile);
+		return add(name, image);
+	}
+
+	const AtlasRegion& TextureAtlas::add(const std::string& name, const BitMapData& image) {
+
+		BNDR_FLIGHT_SCOPE("TextureAtlas::add");
+		auto existing = regions.find(name);
+		if (existing != regions.end()) {
+
+			return existing->second;
+		}
+		int paddedWidth = image.width + 2 * padding;
+		int paddedHeight = image.height + 2 * padding;
+		if (paddedWidth > pageSize || paddedHeight > pageSize) {
+
+			std::string message = "The image '" + name + "' does not fit on a texture atlas page of " + std::to_string(pageSize) + " pixels";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		int pageIndex = -1;
+		int nodeIndex = 0;
+		int x = 0;
+		int y = 0;
+		for (int i = 0; i < (int)pages.size(); i++) {
+
+			if (findPosition(*pages[i], paddedWidth, paddedHeight, nodeIndex, x, y)) {
+
+				pageIndex = i;
+				break;
+			}
+		}
+		if (pageIndex == -1) {
+
+			// an empty page always has room for an image that fits the page size
+			addPage();
+			pageIndex = (int)pages.size() - 1;
+			findPosition(*pages[pageIndex], paddedWidth, paddedHeight, nodeIndex, x, y);
+		}
+		Page& page = *pages[pageIndex];
+		addSkylineLevel(page, nodeIndex, x, y, paddedWidth, paddedHeight);
+		blit(page, image, x, y, padding);
+
+		AtlasRegion region;
+		region.page = pageIndex;
+		region.x = x + padding;
+		region.y = y + padding;
+		region.width = image.width;
+		region.height = image.height;
+		computeRegionUV(region, pageSize);
+		return regions.insert(std::make_pair(name, region)).first->second;
+	}
+
+	void TextureAtlas::upload() {
+
+		for (int i = 0; i < (int)pages.size(); i++) {
+
+			Page* page = pages[i];
+			if (!page->dirty) {
+
+				continue;
+			}
+			uint textureID = (uint)page->texture.getID();
+			if (textureID == 0) {
+
+				glGenTextures(1, &textureID);
+				GLState::bindTexture(GL_TEXTURE0, textureID);
+				// the padding keeps neighbours apart, clamping keeps the page border from wrapping around
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filtering);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filtering);
+				GL_DEBUG_FUNC(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pageSize, pageSize, 0, GL_BGRA, GL_UNSIGNED_BYTE, &page->pixels[0]));
+				// the manager counts the references of the sprites drawing the page, so the page outlives the atlas while
+				// a sprite still uses it (adopt takes a reference that the page texture takes over)
+				std::string pageKey = key + "/" + std::to_string(i) + ".page";
+				textureID = TextureManager::adopt(pageKey.c_str(), textureID, TextureManager::estimateBytes(pageSize, pageSize, false));
+				page->texture.overwriteData(textureID, GL_TEXTURE0);
+				TextureManager::release(textureID);
+			}
+			else {
+
+				GLState::bindTexture(page->texture.getSlot(), textureID);
+				GL_DEBUG_FUNC(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pageSize, pageSize, GL_BGRA, GL_UNSIGNED_BYTE, &page->pixels[0]));
+			}
+			RenderStats::addBytesUploaded(page->pixels.size());
+			page->dirty = false;
+		}
+	}
+
+	const AtlasRegion& TextureAtlas::getRegion(const std::string& name) const {
+
+		auto region = regions.find(name);
+		if (region == regions.end()) {
+
+			std::string message = "The texture atlas has no image named '" + name + "'";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		return region->second;
+	}
+
+	void TextureAtlas::save(const char* manifestPath) const {
+
+		// the pages are written next to the manifest
+		std::string stem = manifestPath;
+		size_t dot = stem.find_last_of('.');
+		size_t slash = stem.find_last_of("/\\");
+		if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+
+			stem.resize(dot);
+		}
+		std::string fileStem = (slash == std::string::npos) ? stem : stem.substr(slash + 1);
+
+		std::ofstream manifest(manifestPath, std::ios::out | std::ios::trunc);
+		if (!manifest.is_open()) {
+
+			std::string message = "Failed to write texture atlas manifest '" + std::string(manifestPath) + "'";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		manifest << ATLAS_MANIFEST_MAGIC << " " << ATLAS_MANIFEST_VERSION << "\n";
+		manifest << "page_size " << pageSize << "\n";
+		manifest << "padding " << padding << "\n";
+		int rowBytes = getRowBytes();
+		for (int i = 0; i < (int)pages.size(); i++) {
+
+			std::string pageName = fileStem + "_" + std::to_string(i) + ".bmp";
+			std::string pagePath = stem + "_" + std::to_string(i) + ".bmp";
+			// a 32 bit bitmap with a BITMAPV4HEADER, whose alpha mask marks the fourth byte as alpha (see MappedBitMap)
+			uint imageSize = (uint)rowBytes * pageSize;
+			uchar header[122] = { 0 };
+			header[0] = (uchar)'B';
+			header[1] = (uchar)'M';
+			writeHeaderValue(header, 0x02, sizeof(header) + imageSize, 4);
+			writeHeaderValue(header, 0x0A, sizeof(header), 4);
+			writeHeaderValue(header, 0x0E, 108, 4);
+			writeHeaderValue(header, 0x12, (uint)pageSize, 4);
+			writeHeaderValue(header, 0x16, (uint)pageSize, 4);
+			writeHeaderValue(header, 0x1A, 1, 2);
+			writeHeaderValue(header, 0x1C, 32, 2);
+			writeHeaderValue(header, 0x1E, 3, 4);
+			writeHeaderValue(header, 0x22, imageSize, 4);
+			writeHeaderValue(header, 0x36, 0x00FF0000, 4);
+			writeHeaderValue(header, 0x3A, 0x0000FF00, 4);
+			writeHeaderValue(header, 0x3E, 0x000000FF, 4);
+			writeHeaderValue(header, 0x42, 0xFF000000, 4);
+			// LCS_sRGB
+			writeHeaderValue(header, 0x46, 0x73524742, 4);
+			std::ofstream pageFile(pagePath, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!pageFile.is_open()) {
+
+				std::string message = "Failed to write texture atlas page '" + pagePath + "'";
+				BNDR_EXCEPTION(message.c_str());
+			}
+			pageFile.write((const char*)header, sizeof(header));
+			pageFile.write((const char*)&pages[i]->pixels[0], imageSize);
+			manifest << "page " << i << " " << pageName << "\n";
+		}
+		for (const auto& entry : regions) {
+
+			const AtlasRegion& region = entry.second;
+			manifest << "region " << entry.first << " " << region.page << " " << region.x << " " << region.y << " " << region.width << " " << region.height << "\n";
+		}
+	}
+
+	void TextureAtlas::load(const char* manifestPath) {
+
+		BNDR_FLIGHT_SCOPE("TextureAtlas::load");
+		if (!pages.empty()) {
+
+			BNDR_EXCEPTION("A texture atlas can only be loaded into an empty atlas");
+		}
+		std::ifstream manifest(manifestPath, std::ios::in);
+		if (!manifest.is_open()) {
+
+			std::string message = "Failed to open texture atlas manifest '" + std::string(manifestPath) + "'";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		std::string path = manifestPath;
+		size_t slash = path.find_last_of("/\\");
+		std::string directory = (slash == std::string::npos) ? "" : path.substr(0, slash + 1);
+
+		std::string magic;
+		int version = 0;
+		manifest >> magic >> version;
+		if (magic != ATLAS_MANIFEST_MAGIC || version != ATLAS_MANIFEST_VERSION) {
+
+			std::string message = "The texture atlas manifest '" + path + "' has an invalid format";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		std::string key;
+		while (manifest >> key) {
+
+			if (key == "page_size") {
+
+				manifest >> pageSize;
+			}
+			else if (key == "padding") {
+
+				manifest >> padding;
+			}
+			else if (key == "page") {
+
+				int index = 0;
+				std::string pageName;
+				manifest >> index >> pageName;
+				std::string pagePath = directory + pageName;
+				BitMapData image = Texture::loadBitMap(pagePath.c_str());
+				if (image.width != pageSize || image.height != pageSize || index != (int)pages.size()) {
+
+					std::string message = "The texture atlas page '" + pagePath + "' does not match its manifest";
+					BNDR_EXCEPTION(message.c_str());
+				}
+				// (24 bit pages of older atlases are loaded as opaque)
+				Page* page = addPage();
+				blit(*page, image, 0, 0, 0);
+				// a loaded page counts as full
+				page->skyline[0].y = pageSize;
+			}
+			else if (key == "region") {
+
+				std::string name;
+				AtlasRegion region;
+				manifest >> name >> region.page >> region.x >> region.y >> region.width >> region.height;
+				if (region.page < 0 || region.page >= (int)pages.size()) {
+
+					std::string message = "The texture atlas region '" + name + "' is on a page that does not exist";
+					BNDR_EXCEPTION(message.c_str());
+				}
+				computeRegionUV(region, pageSize);
+				regions[name] = region;
+			}
+			else {
+
+				std::string message = "Unknown entry '" + key + "' in texture atlas manifest '" + path + "'";
+				BNDR_EXCEPTION(message.c_str());
+			}
+		}
+	}
+
+	TextureAtlas::~TextureAtlas() {
+
+		for (Page* page : pages) {
+
+			// sprites may still hold references, so the page texture is only deleted if the atlas held the last one
+			uint textureID = (uint)page->texture.getID();
+			TextureManager::addReference(textureID);
+			delete page;
+			TextureManager::discard(textureID);
+		}
+	}
+}
@@ -0,0 +1,122 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "textures.h"
+
+namespace bndr {
+
+	// an image packed into a bndr::TextureAtlas
+	struct AtlasRegion {
+
+		// the index of the page the image is on
+		int page = 0;
+		// the rect of the image on the page in pixels (without the padding, y counts from the bottom row)
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+		// the same rect in texture coordinates (u0, v0, u1, v1)
+		float uv[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+	};
+
+	// bndr::TextureAtlas
+	// Description: Packs many bitmaps into a few large texture pages so sprites using different images share one texture
+	// (and with it a draw). Images are placed with skyline bottom-left packing, each one surrounded by padding that repeats
+	// its edge pixels so filtering never bleeds a neighbour in. A sprite references a page plus the UV rect of its region
+	// (see TexturedRect::setAtlasSprite). Atlases are packed at runtime with add() and upload(), or packed once offline
+	// and written with save() so that load() only has to read the pages back. Pages are BGRA with the unused space
+	// transparent, and their textures are registered with bndr::TextureManager, so sprites keep a page alive after the
+	// atlas is gone
+	class BNDR_API TextureAtlas {
+
+		// a segment of the skyline (the top edge of everything packed so far)
+		struct SkylineNode {
+
+			int x;
+			int y;
+			int width;
+		};
+
+		struct Page {
+
+			// BGRA rows from the bottom up
+			std::vector<uchar> pixels;
+			std::vector<SkylineNode> skyline;
+			// wraps the OpenGL texture once the page was uploaded
+			Texture texture;
+			// set when pixels changed after the last upload
+			bool dirty = true;
+		};
+
+		int pageSize;
+		int padding;
+		uint filtering;
+		// the pages are registered with bndr::TextureManager as "<key>/<page>.page" (unique to every atlas)
+		std::string key;
+		std::vector<Page*> pages;
+		std::unordered_map<std::string, AtlasRegion> regions;
+
+		// the bytes of a page row
+		inline int getRowBytes() const { return pageSize * 4; }
+		// add an empty page
+		Page* addPage();
+		// find the lowest place on the skyline a rect fits at, returns false if the page is too full
+		bool findPosition(const Page& page, int width, int height, int& nodeIndex, int& x, int& y) const;
+		// raise the skyline over a rect that was just placed
+		void addSkylineLevel(Page& page, int nodeIndex, int x, int y, int width, int height);
+		// copy an image onto a page and repeat its edge pixels into the padding around it (images without alpha are opaque)
+		void blit(Page& page, const BitMapData& image, int x, int y, int imagePadding);
+
+	public:
+
+		// bndr::TextureAtlas::TextureAtlas
+		// Arguments:
+		//        size = The width and height of every page in pixels
+		//        imagePadding = The pixels of repeated edge around every image
+		//        textureFiltering = TEXTURE_NEAREST or TEXTURE_LINEAR (pages have no mipmaps, they would mix neighbours)
+		TextureAtlas(int size = 2048, int imagePadding = 2, uint textureFiltering = TEXTURE_NEAREST);
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+		// pack a bitmap file under a name (names must not contain whitespace so they survive save())
+		const AtlasRegion& add(const std::string& name, const char* bitMapFile);
+		// pack bitmap data under a name
+		const AtlasRegion& add(const std::string& name, const BitMapData& image);
+		// upload the pages that changed (render thread)
+		void upload();
+		// check if an image was packed under a name
+		inline bool hasRegion(const std::string& name) const { return regions.find(name) != regions.end(); }
+		// get the region of an image (throws if no image has the name)
+		const AtlasRegion& getRegion(const std::string& name) const;
+		// get the texture of a page (valid once upload() ran)
+		inline const Texture& getPage(int index) const { return pages[index]->texture; }
+		inline int getPageCount() const { return (int)pages.size(); }
+		inline int getPageSize() const { return pageSize; }
+		// write the pages as bitmaps next to a manifest of the regions (the pages are "<manifest>_<page>.bmp")
+		void save(const char* manifestPath) const;
+		// read an atlas written by save() (the pages are full, images added later go onto new pages)
+		void load(const char* manifestPath);
+		// drops the references to the page textures (pages no sprite uses any more are deleted)
+		~TextureAtlas();
+	};
+}
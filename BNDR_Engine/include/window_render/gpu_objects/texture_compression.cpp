@@ -0,0 +1,478 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "texture_compression.h"
+#include "../../profiling/profiler.h"
+#include <emmintrin.h>
+#include <cfloat>
+
+namespace bndr {
+
+	// the 16 texels of a block with one array per color channel, so 4 texels fit in a register
+	struct BlockTexels {
+
+		alignas(16) float red[16];
+		alignas(16) float green[16];
+		alignas(16) float blue[16];
+		uchar alpha[16];
+	};
+
+	// the weight of the first endpoint for each of the 4 color indices
+	static const float COLOR_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	// copy a block out of the image (texels past the edge repeat the last row or column)
+	static void gatherBlock(const uchar* pixels, int width, int height, int blockX, int blockY, BlockTexels& texels) {
+
+		for (int y = 0; y < 4; y++) {
+
+			int row = std::min<int>(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++) {
+
+				int column = std::min<int>(blockX * 4 + x, width - 1);
+				const uchar* texel = pixels + ((size_t)row * width + column) * 4;
+				texels.red[y * 4 + x] = (float)texel[0];
+				texels.green[y * 4 + x] = (float)texel[1];
+				texels.blue[y * 4 + x] = (float)texel[2];
+				texels.alpha[y * 4 + x] = texel[3];
+			}
+		}
+	}
+
+	static inline unsigned short packColor565(const float color[3]) {
+
+		int red = (int)(std::min<float>(std::max<float>(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+		int green = (int)(std::min<float>(std::max<float>(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+		int blue = (int)(std::min<float>(std::max<float>(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+		return (unsigned short)((red << 11) | (green << 5) | blue);
+	}
+
+	// expand a 565 color to 8 bits per channel the way the hardware does
+	static inline void unpackColor565(unsigned short color, int channels[3]) {
+
+		int red = (color >> 11) & 31;
+		int green = (color >> 5) & 63;
+		int blue = color & 31;
+		channels[0] = (red << 3) | (red >> 2);
+		channels[1] = (green << 2) | (green >> 4);
+		channels[2] = (blue << 3) | (blue >> 2);
+	}
+
+	// pick the nearest palette color for every texel, 4 texels at a time, and return the summed squared error
+	static float selectColorIndices(const BlockTexels& texels, const float palette[4][3], uchar indices[16]) {
+
+		__m128 totalError = _mm_setzero_ps();
+		for (int group = 0; group < 16; group += 4) {
+
+			__m128 red = _mm_load_ps(texels.red + group);
+			__m128 green = _mm_load_ps(texels.green + group);
+			__m128 blue = _mm_load_ps(texels.blue + group);
+			__m128 bestError = _mm_set1_ps(FLT_MAX);
+			__m128 bestIndex = _mm_setzero_ps();
+			for (int entry = 0; entry < 4; entry++) {
+
+				__m128 redDelta = _mm_sub_ps(red, _mm_set1_ps(palette[entry][0]));
+				__m128 greenDelta = _mm_sub_ps(green, _mm_set1_ps(palette[entry][1]));
+				__m128 blueDelta = _mm_sub_ps(blue, _mm_set1_ps(palette[entry][2]));
+				__m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(redDelta, redDelta), _mm_mul_ps(greenDelta, greenDelta)),
+					_mm_mul_ps(blueDelta, blueDelta));
+				// a tie keeps the earlier entry
+				__m128 closer = _mm_cmplt_ps(error, bestError);
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)entry)), _mm_andnot_ps(closer, bestIndex));
+			}
+			totalError = _mm_add_ps(totalError, bestError);
+			alignas(16) int groupIndices[4];
+			_mm_store_si128((__m128i*)groupIndices, _mm_cvttps_epi32(bestIndex));
+			for (int i = 0; i < 4; i++) {
+
+				indices[group + i] = (uchar)groupIndices[i];
+			}
+		}
+		alignas(16) float errors[4];
+		_mm_store_ps(errors, totalError);
+		return errors[0] + errors[1] + errors[2] + errors[3];
+	}
+
+	// find the endpoints along the principal axis of the block colors
+	static void findColorEndpoints(const BlockTexels& texels, float first[3], float second[3]) {
+
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++) {
+
+			mean[0] += texels.red[i];
+			mean[1] += texels.green[i];
+			mean[2] += texels.blue[i];
+		}
+		for (float& channel : mean) {
+
+			channel /= 16.0f;
+		}
+		// the covariance of the colors (symmetric, so only 6 entries)
+		float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++) {
+
+			float red = texels.red[i] - mean[0];
+			float green = texels.green[i] - mean[1];
+			float blue = texels.blue[i] - mean[2];
+			covariance[0] += red * red;
+			covariance[1] += red * green;
+			covariance[2] += red * blue;
+			covariance[3] += green * green;
+			covariance[4] += green * blue;
+			covariance[5] += blue * blue;
+		}
+		// a few power iterations are enough to find the dominant axis of 16 colors
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 6; iteration++) {
+
+			float next[3] = {
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+			};
+			float length = std::max<float>(std::max<float>(fabsf(next[0]), fabsf(next[1])), fabsf(next[2]));
+			if (length < 1e-6f) {
+
+				break;
+			}
+			axis[0] = next[0] / length;
+			axis[1] = next[1] / length;
+			axis[2] = next[2] / length;
+		}
+		// the texels furthest apart along the axis become the endpoints
+		int minimum = 0;
+		int maximum = 0;
+		float minimumProjection = FLT_MAX;
+		float maximumProjection = -FLT_MAX;
+		for (int i = 0; i < 16; i++) {
+
+			float projection = texels.red[i] * axis[0] + texels.green[i] * axis[1] + texels.blue[i] * axis[2];
+			if (projection < minimumProjection) {
+
+				minimumProjection = projection;
+				minimum = i;
+			}
+			if (projection > maximumProjection) {
+
+				maximumProjection = projection;
+				maximum = i;
+			}
+		}
+		first[0] = texels.red[maximum];
+		first[1] = texels.green[maximum];
+		first[2] = texels.blue[maximum];
+		second[0] = texels.red[minimum];
+		second[1] = texels.green[minimum];
+		second[2] = texels.blue[minimum];
+	}
+
+	// fit the endpoints to the chosen indices with least squares, returns false if the indices do not constrain them
+	static bool refitColorEndpoints(const BlockTexels& texels, const uchar indices[16], float first[3], float second[3]) {
+
+		float weightSquares = 0.0f;
+		float weightProducts = 0.0f;
+		float inverseSquares = 0.0f;
+		float firstSums[3] = { 0.0f, 0.0f, 0.0f };
+		float secondSums[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++) {
+
+			float weight = COLOR_WEIGHTS[indices[i]];
+			float inverse = 1.0f - weight;
+			weightSquares += weight * weight;
+			weightProducts += weight * inverse;
+			inverseSquares += inverse * inverse;
+			const float texel[3] = { texels.red[i], texels.green[i], texels.blue[i] };
+			for (int channel = 0; channel < 3; channel++) {
+
+				firstSums[channel] += weight * texel[channel];
+				secondSums[channel] += inverse * texel[channel];
+			}
+		}
+		float determinant = weightSquares * inverseSquares - weightProducts * weightProducts;
+		if (fabsf(determinant) < 1e-6f) {
+
+			return false;
+		}
+		for (int channel = 0; channel < 3; channel++) {
+
+			first[channel] = (inverseSquares * firstSums[channel] - weightProducts * secondSums[channel]) / determinant;
+			second[channel] = (weightSquares * secondSums[channel] - weightProducts * firstSums[channel]) / determinant;
+		}
+		return true;
+	}
+
+	// encode the colors of a block into 8 bytes (always the 4 color mode, so BC1 blocks are opaque)
+	static void encodeColorBlock(const BlockTexels& texels, uchar* block) {
+
+		float first[3];
+		float second[3];
+		findColorEndpoints(texels, first, second);
+		float bestError = FLT_MAX;
+		unsigned short bestColors[2] = { 0, 0 };
+		uchar bestIndices[16] = {};
+		// the principal axis endpoints, then one least squares refit of them
+		for (int pass = 0; pass < 2; pass++) {
+
+			unsigned short colors[2] = { packColor565(first), packColor565(second) };
+			// the 4 color mode needs the first color to be the larger one
+			if (colors[0] < colors[1]) {
+
+				std::swap(colors[0], colors[1]);
+			}
+			int endpoints[2][3];
+			unpackColor565(colors[0], endpoints[0]);
+			unpackColor565(colors[1], endpoints[1]);
+			float palette[4][3];
+			for (int channel = 0; channel < 3; channel++) {
+
+				palette[0][channel] = (float)endpoints[0][channel];
+				palette[1][channel] = (float)endpoints[1][channel];
+				palette[2][channel] = (float)((2 * endpoints[0][channel] + endpoints[1][channel]) / 3);
+				palette[3][channel] = (float)((endpoints[0][channel] + 2 * endpoints[1][channel]) / 3);
+			}
+			uchar indices[16];
+			float error = selectColorIndices(texels, palette, indices);
+			if (error < bestError) {
+
+				bestError = error;
+				bestColors[0] = colors[0];
+				bestColors[1] = colors[1];
+				std::memcpy(bestIndices, indices, sizeof(indices));
+			}
+			// equal colors only ever use the first index (the others would be the 3 color mode)
+			if (colors[0] == colors[1] || bestError == 0.0f || !refitColorEndpoints(texels, indices, first, second)) {
+
+				break;
+			}
+		}
+		if (bestColors[0] == bestColors[1]) {
+
+			std::memset(bestIndices, 0, sizeof(bestIndices));
+		}
+		uint indexBits = 0;
+		for (int i = 0; i < 16; i++) {
+
+			indexBits |= (uint)bestIndices[i] << (2 * i);
+		}
+		block[0] = (uchar)(bestColors[0] & 0xFF);
+		block[1] = (uchar)(bestColors[0] >> 8);
+		block[2] = (uchar)(bestColors[1] & 0xFF);
+		block[3] = (uchar)(bestColors[1] >> 8);
+		std::memcpy(block + 4, &indexBits, sizeof(indexBits));
+	}
+
+	// encode the alpha of a block into 8 bytes (the 8 value mode between the largest and the smallest alpha)
+	static void encodeAlphaBlock(const uchar alpha[16], uchar* block) {
+
+		int largest = *std::max_element(alpha, alpha + 16);
+		int smallest = *std::min_element(alpha, alpha + 16);
+		block[0] = (uchar)largest;
+		block[1] = (uchar)smallest;
+		unsigned long long indexBits = 0;
+		if (largest != smallest) {
+
+			int palette[8] = { largest, smallest };
+			for (int i = 2; i < 8; i++) {
+
+				palette[i] = ((8 - i) * largest + (i - 1) * smallest) / 7;
+			}
+			for (int i = 0; i < 16; i++) {
+
+				int bestIndex = 0;
+				int bestError = 256;
+				for (int entry = 0; entry < 8; entry++) {
+
+					int error = std::abs(palette[entry] - (int)alpha[i]);
+					if (error < bestError) {
+
+						bestError = error;
+						bestIndex = entry;
+					}
+				}
+				indexBits |= (unsigned long long)bestIndex << (3 * i);
+			}
+		}
+		for (int i = 0; i < 6; i++) {
+
+			block[2 + i] = (uchar)(indexBits >> (8 * i));
+		}
+	}
+
+	// compress every block of an image, the threads take the next free row of blocks until none are left
+	static void compressBlocks(const uchar* pixels, int width, int height, uchar* blocks, int threadCount, bool withAlpha) {
+
+		int blocksWide = (width + 3) / 4;
+		int blocksHigh = (height + 3) / 4;
+		int blockBytes = withAlpha ? BC3_BLOCK_BYTES : BC1_BLOCK_BYTES;
+		std::atomic<int> nextRow{ 0 };
+		auto compressRows = [&]() {
+
+			BlockTexels texels;
+			int row;
+			while ((row = nextRow.fetch_add(1)) < blocksHigh) {
+
+				uchar* block = blocks + (size_t)row * blocksWide * blockBytes;
+				for (int column = 0; column < blocksWide; column++) {
+
+					gatherBlock(pixels, width, height, column, row, texels);
+					if (withAlpha) {
+
+						encodeAlphaBlock(texels.alpha, block);
+						encodeColorBlock(texels, block + 8);
+					}
+					else {
+
+						encodeColorBlock(texels, block);
+					}
+					block += blockBytes;
+				}
+			}
+		};
+		if (threadCount <= 0) {
+
+			threadCount = (int)std::thread::hardware_concurrency();
+		}
+		threadCount = std::min<int>(std::max<int>(threadCount, 1), blocksHigh);
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; i++) {
+
+			threads.emplace_back(compressRows);
+		}
+		// the calling thread compresses rows too
+		compressRows();
+		for (std::thread& thread : threads) {
+
+			thread.join();
+		}
+	}
+
+	void compressBC1(const uchar* pixels, int width, int height, uchar* blocks, int threadCount) {
+
+		BNDR_PROFILE_SCOPE("compressBC1");
+		compressBlocks(pixels, width, height, blocks, threadCount, false);
+	}
+
+	void compressBC3(const uchar* pixels, int width, int height, uchar* blocks, int threadCount) {
+
+		BNDR_PROFILE_SCOPE("compressBC3");
+		compressBlocks(pixels, width, height, blocks, threadCount, true);
+	}
+
+	// decode the 8 byte color part of a block into 16 RGBA texels
+	static void decodeColorBlock(const uchar* block, uchar texels[64], bool alwaysFourColors) {
+
+		unsigned short colors[2] = { (unsigned short)(block[0] | (block[1] << 8)), (unsigned short)(block[2] | (block[3] << 8)) };
+		int palette[4][4];
+		unpackColor565(colors[0], palette[0]);
+		unpackColor565(colors[1], palette[1]);
+		palette[0][3] = 255;
+		palette[1][3] = 255;
+		bool fourColors = alwaysFourColors || colors[0] > colors[1];
+		for (int channel = 0; channel < 3; channel++) {
+
+			palette[2][channel] = fourColors ? (2 * palette[0][channel] + palette[1][channel]) / 3 : (palette[0][channel] + palette[1][channel]) / 2;
+			palette[3][channel] = fourColors ? (palette[0][channel] + 2 * palette[1][channel]) / 3 : 0;
+		}
+		palette[2][3] = 255;
+		// the 3 color mode uses the last index for transparent black
+		palette[3][3] = fourColors ? 255 : 0;
+		uint indexBits;
+		std::memcpy(&indexBits, block + 4, sizeof(indexBits));
+		for (int i = 0; i < 16; i++) {
+
+			const int* color = palette[(indexBits >> (2 * i)) & 3];
+			for (int channel = 0; channel < 4; channel++) {
+
+				texels[i * 4 + channel] = (uchar)color[channel];
+			}
+		}
+	}
+
+	// decode the 8 byte alpha part of a BC3 block into the alpha of 16 RGBA texels
+	static void decodeAlphaBlock(const uchar* block, uchar texels[64]) {
+
+		int largest = block[0];
+		int smallest = block[1];
+		int palette[8] = { largest, smallest };
+		for (int i = 2; i < 8; i++) {
+
+			// the 6 value mode ends with fully transparent and fully opaque
+			palette[i] = (largest > smallest) ? ((8 - i) * largest + (i - 1) * smallest) / 7 :
+				((i < 6) ? ((6 - i) * largest + (i - 1) * smallest) / 5 : ((i == 6) ? 0 : 255));
+		}
+		unsigned long long indexBits = 0;
+		for (int i = 0; i < 6; i++) {
+
+			indexBits |= (unsigned long long)block[2 + i] << (8 * i);
+		}
+		for (int i = 0; i < 16; i++) {
+
+			texels[i * 4 + 3] = (uchar)palette[(indexBits >> (3 * i)) & 7];
+		}
+	}
+
+	// decode every block and copy the texels inside the image
+	static void decompressBlocks(const uchar* blocks, int width, int height, uchar* pixels, bool withAlpha) {
+
+		int blocksWide = (width + 3) / 4;
+		int blocksHigh = (height + 3) / 4;
+		uchar texels[64];
+		for (int row = 0; row < blocksHigh; row++) {
+
+			for (int column = 0; column < blocksWide; column++) {
+
+				if (withAlpha) {
+
+					decodeColorBlock(blocks + 8, texels, true);
+					decodeAlphaBlock(blocks, texels);
+					blocks += BC3_BLOCK_BYTES;
+				}
+				else {
+
+					decodeColorBlock(blocks, texels, false);
+					blocks += BC1_BLOCK_BYTES;
+				}
+				for (int y = 0; y < 4 && row * 4 + y < height; y++) {
+
+					int texelsInRow = std::min<int>(4, width - column * 4);
+					std::memcpy(pixels + ((size_t)(row * 4 + y) * width + column * 4) * 4, texels + y * 16, (size_t)texelsInRow * 4);
+				}
+			}
+		}
+	}
+
+	void decompressBC1(const uchar* blocks, int width, int height, uchar* pixels) {
+
+		decompressBlocks(blocks, width, height, pixels, false);
+	}
+
+	void decompressBC3(const uchar* blocks, int width, int height, uchar* pixels) {
+
+		decompressBlocks(blocks, width, height, pixels, true);
+	}
+
+	bool isBlockCompressionSupported() {
+
+		return GLEW_EXT_texture_compression_s3tc != 0;
+	}
+}
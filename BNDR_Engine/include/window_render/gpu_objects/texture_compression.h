@@ -0,0 +1,49 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	// the bytes of a 4x4 block of each format
+	static const int BC1_BLOCK_BYTES = 8;
+	static const int BC3_BLOCK_BYTES = 16;
+
+	// get the bytes of an image compressed into 4x4 blocks (partial blocks at the edges count as whole ones)
+	inline unsigned long long getCompressedBytes(int width, int height, int blockBytes) {
+
+		return (unsigned long long)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+	}
+
+	// compress RGBA texels into opaque BC1 (DXT1) blocks, the alpha is dropped
+	// the block rows are split between threadCount threads (0 uses every core)
+	BNDR_API void compressBC1(const uchar* pixels, int width, int height, uchar* blocks, int threadCount = 0);
+	// compress RGBA texels into BC3 (DXT5) blocks, the color as in BC1 and the alpha interpolated separately
+	BNDR_API void compressBC3(const uchar* pixels, int width, int height, uchar* blocks, int threadCount = 0);
+	// decode BC1 blocks into RGBA texels (for drivers without S3TC)
+	BNDR_API void decompressBC1(const uchar* blocks, int width, int height, uchar* pixels);
+	// decode BC3 blocks into RGBA texels (for drivers without S3TC)
+	BNDR_API void decompressBC3(const uchar* blocks, int width, int height, uchar* pixels);
+	// check if the driver can sample BC1 and BC3 textures (needs the OpenGL context)
+	BNDR_API bool isBlockCompressionSupported();
+}
@@ -0,0 +1,566 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "texture_container.h"
+#include "bitmap_loader.h"
+#include "texture_compression.h"
+#include "../../profiling/profiler.h"
+#include "GLState.h"
+#include "../../data_structures/vectors.h"
+#include <emmintrin.h>
+
+namespace bndr {
+
+	static const char CONTAINER_MAGIC[4] = { 'B', 'T', 'E', 'X' };
+	// the level payloads start on this boundary
+	static const unsigned long long CONTAINER_ALIGNMENT = 16;
+	// the Kaiser filter reaches 3 source texels to either side of a destination texel and has a shape parameter of 4
+	static const int KAISER_TAPS = 6;
+	static const float KAISER_RADIUS = 3.0f;
+	static const float KAISER_ALPHA = 4.0f;
+
+	static unsigned long long alignOffset(unsigned long long offset) {
+
+		return (offset + CONTAINER_ALIGNMENT - 1) & ~(CONTAINER_ALIGNMENT - 1);
+	}
+
+	unsigned long long MappedTextureContainer::computeLevelBytes(uint format, int width, int height) {
+
+		switch (format) {
+
+		case BTEX_RGBA8: return (unsigned long long)width * height * 4;
+		case BTEX_BC1: return getCompressedBytes(width, height, BC1_BLOCK_BYTES);
+		case BTEX_BC3: return getCompressedBytes(width, height, BC3_BLOCK_BYTES);
+		default: return 0;
+		}
+	}
+
+	bool MappedTextureContainer::isContainerFile(const char* path) {
+
+		size_t length = std::strlen(path);
+		if (length < 5) {
+
+			return false;
+		}
+		std::string extension(path + length - 5);
+		for (char& c : extension) {
+
+			c = (char)std::tolower((unsigned char)c);
+		}
+		return extension == ".btex";
+	}
+
+	MappedTextureContainer::MappedTextureContainer(const char* containerFile) {
+
+		// the handles are released before an exception leaves the constructor (the destructor would not run)
+		auto fail = [this, containerFile](const char* reason) {
+
+			release();
+			std::string message = "The texture container " + std::string("'") + std::string(containerFile) + std::string("' ") + reason;
+			BNDR_EXCEPTION(message.c_str());
+		};
+		file = CreateFileA(containerFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+
+			std::string message = "Failed to open texture container " + std::string("'") + std::string(containerFile) + std::string("'");
+			BNDR_EXCEPTION(message.c_str());
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || (unsigned long long)fileSize.QuadPart < sizeof(TextureContainerHeader)) {
+
+			fail("is too short to be a texture container");
+		}
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL) {
+
+			view = (const uchar*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		}
+		if (view == nullptr) {
+
+			fail("could not be mapped into memory");
+		}
+
+		// validate the header and the level table once, the payloads are trusted from here on
+		unsigned long long size = (unsigned long long)fileSize.QuadPart;
+		std::memcpy(&header, view, sizeof(header));
+		if (std::memcmp(header.magic, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0) {
+
+			fail("is not a texture container");
+		}
+		if (header.version != VERSION) {
+
+			fail("was written by a different version of the converter");
+		}
+		if (computeLevelBytes(header.format, 1, 1) == 0) {
+
+			fail("has an unknown pixel format");
+		}
+		if (header.width == 0 || header.height == 0 || header.width > 0x7FFFFFFF || header.height > 0x7FFFFFFF) {
+
+			fail("has an invalid size");
+		}
+		uint fullChain = 1;
+		while ((std::max<uint>(header.width, header.height) >> fullChain) > 0) {
+
+			fullChain++;
+		}
+		if (header.levelCount == 0 || header.levelCount > fullChain) {
+
+			fail("has an invalid number of mip levels");
+		}
+		unsigned long long tableEnd = sizeof(TextureContainerHeader) + sizeof(TextureContainerLevel) * header.levelCount;
+		if (tableEnd > size) {
+
+			fail("is shorter than its header says");
+		}
+		levels = (const TextureContainerLevel*)(view + sizeof(TextureContainerHeader));
+		for (int level = 0; level < getLevelCount(); level++) {
+
+			const TextureContainerLevel& entry = levels[level];
+			if (entry.offset % CONTAINER_ALIGNMENT != 0 || entry.offset < tableEnd ||
+				entry.bytes != computeLevelBytes(header.format, getLevelWidth(level), getLevelHeight(level))) {
+
+				fail("has an invalid mip level table");
+			}
+			if (entry.offset > size || entry.bytes > size - entry.offset) {
+
+				fail("is shorter than its header says");
+			}
+		}
+	}
+
+	unsigned long long MappedTextureContainer::getTotalBytes() const {
+
+		unsigned long long bytes = 0;
+		for (int level = 0; level < getLevelCount(); level++) {
+
+			bytes += levels[level].bytes;
+		}
+		return bytes;
+	}
+
+	unsigned long long MappedTextureContainer::upload() const {
+
+		BNDR_FLIGHT_SCOPE("MappedTextureContainer::upload");
+		// only the levels in the file exist, so sampling never reaches an undefined level
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, getLevelCount() - 1);
+		if (isCompressed() && isBlockCompressionSupported()) {
+
+			// the blocks are sampled as they are, the driver never sees the RGBA texels
+			GLenum internalFormat = (header.format == BTEX_BC1) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			for (int level = 0; level < getLevelCount(); level++) {
+
+				GL_DEBUG_FUNC(glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, getLevelWidth(level), getLevelHeight(level), 0,
+					(GLsizei)getLevelBytes(level), getLevel(level)));
+				RenderStats::addBytesUploaded(getLevelBytes(level));
+			}
+			return getTotalBytes();
+		}
+		// decoded levels need a buffer the size of the largest (the first) level
+		std::unique_ptr<uchar[]> decoded;
+		if (isCompressed()) {
+
+			BNDR_MESSAGE("The driver does not support S3TC, the compressed texture is decoded to RGBA");
+			decoded.reset(new uchar[(size_t)computeLevelBytes(BTEX_RGBA8, getWidth(), getHeight())]);
+		}
+		unsigned long long bytes = 0;
+		for (int level = 0; level < getLevelCount(); level++) {
+
+			int levelWidth = getLevelWidth(level);
+			int levelHeight = getLevelHeight(level);
+			const uchar* pixels = getLevel(level);
+			if (header.format == BTEX_BC1) {
+
+				decompressBC1(pixels, levelWidth, levelHeight, decoded.get());
+				pixels = decoded.get();
+			}
+			else if (header.format == BTEX_BC3) {
+
+				decompressBC3(pixels, levelWidth, levelHeight, decoded.get());
+				pixels = decoded.get();
+			}
+			unsigned long long levelBytes = computeLevelBytes(BTEX_RGBA8, levelWidth, levelHeight);
+			// RGBA8 rows are a multiple of 4 bytes, so the default unpack alignment fits every level
+			GL_DEBUG_FUNC(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+			RenderStats::addBytesUploaded(levelBytes);
+			bytes += levelBytes;
+		}
+		return bytes;
+	}
+
+	void MappedTextureContainer::release() {
+
+		if (view != nullptr) {
+
+			UnmapViewOfFile(view);
+			view = nullptr;
+		}
+		if (mapping != NULL) {
+
+			CloseHandle(mapping);
+			mapping = NULL;
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+
+			CloseHandle(file);
+			file = INVALID_HANDLE_VALUE;
+		}
+		levels = nullptr;
+	}
+
+	MappedTextureContainer::~MappedTextureContainer() {
+
+		release();
+	}
+
+	// average 4 texels of two rows into 2 texels with 16 bit channels
+	static inline __m128i averageBoxBlock(__m128i top, __m128i bottom) {
+
+		const __m128i zero = _mm_setzero_si128();
+		// the first two and the last two texels of both rows added up per channel
+		__m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+		__m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+		// then the neighbouring columns, rounded to the nearest value
+		__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+		return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+	}
+
+	void downsampleBox(const uchar* source, int width, int height, uchar* destination) {
+
+		int newWidth = std::max<int>(width / 2, 1);
+		int newHeight = std::max<int>(height / 2, 1);
+		size_t sourceStride = (size_t)width * 4;
+		for (int y = 0; y < newHeight; y++) {
+
+			// a dimension of 1 is not halved, its single row or column is used twice
+			const uchar* top = source + sourceStride * std::min<int>(2 * y, height - 1);
+			const uchar* bottom = source + sourceStride * std::min<int>(2 * y + 1, height - 1);
+			uchar* row = destination + (size_t)newWidth * 4 * y;
+			int x = 0;
+			if (width >= 2) {
+
+				// 4 destination texels from 8 texels of both rows per step
+				for (; x + 4 <= newWidth; x += 4) {
+
+					__m128i first = averageBoxBlock(_mm_loadu_si128((const __m128i*)(top + x * 8)),
+						_mm_loadu_si128((const __m128i*)(bottom + x * 8)));
+					__m128i second = averageBoxBlock(_mm_loadu_si128((const __m128i*)(top + x * 8 + 16)),
+						_mm_loadu_si128((const __m128i*)(bottom + x * 8 + 16)));
+					_mm_storeu_si128((__m128i*)(row + x * 4), _mm_packus_epi16(first, second));
+				}
+			}
+			for (; x < newWidth; x++) {
+
+				int left = std::min<int>(2 * x, width - 1) * 4;
+				int right = std::min<int>(2 * x + 1, width - 1) * 4;
+				for (int channel = 0; channel < 4; channel++) {
+
+					int sum = top[left + channel] + top[right + channel] + bottom[left + channel] + bottom[right + channel];
+					row[x * 4 + channel] = (uchar)((sum + 2) >> 2);
+				}
+			}
+		}
+	}
+
+	// the modified Bessel function of the first kind of order 0 (the series converges quickly for the shape parameters used)
+	static float besselI0(float x) {
+
+		float sum = 1.0f;
+		float term = 1.0f;
+		float halfSquared = (x * x) / 4.0f;
+		for (int k = 1; k < 25; k++) {
+
+			term *= halfSquared / (float)(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	// the weights of the source texels 2x - 2 to 2x + 3 for destination texel x (they sum to 1)
+	static std::vector<float> computeKaiserTaps() {
+
+		std::vector<float> taps(KAISER_TAPS);
+		float total = 0.0f;
+		for (int i = 0; i < KAISER_TAPS; i++) {
+
+			// the destination texel is centered between source texels 2x and 2x + 1
+			float distance = (float)(i - KAISER_TAPS / 2) + 0.5f;
+			// a sinc with half the source frequency, so the result has no frequencies the smaller level cannot hold
+			float phase = BNDR_PI * distance / 2.0f;
+			float sinc = sinf(phase) / phase;
+			float ratio = distance / KAISER_RADIUS;
+			float window = besselI0(KAISER_ALPHA * sqrtf(std::max<float>(1.0f - ratio * ratio, 0.0f))) / besselI0(KAISER_ALPHA);
+			taps[i] = sinc * window;
+			total += taps[i];
+		}
+		for (int i = 0; i < KAISER_TAPS; i++) {
+
+			taps[i] /= total;
+		}
+		return taps;
+	}
+
+	void downsampleKaiser(const uchar* source, int width, int height, uchar* destination) {
+
+		int newWidth = std::max<int>(width / 2, 1);
+		int newHeight = std::max<int>(height / 2, 1);
+		static const std::vector<float> taps = computeKaiserTaps();
+		const __m128i zero = _mm_setzero_si128();
+		// the horizontal pass keeps every source row, one texel is the 4 channels in a single register
+		std::vector<__m128> filteredRows((size_t)newWidth * height);
+		for (int y = 0; y < height; y++) {
+
+			const uchar* row = source + (size_t)width * 4 * y;
+			for (int x = 0; x < newWidth; x++) {
+
+				__m128 sum = _mm_setzero_ps();
+				for (int i = 0; i < KAISER_TAPS; i++) {
+
+					// the edges are clamped, a dimension of 1 keeps its only texel
+					int column = std::min<int>(std::max<int>(2 * x - KAISER_TAPS / 2 + 1 + i, 0), width - 1);
+					int texel;
+					std::memcpy(&texel, row + column * 4, sizeof(texel));
+					__m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(texel), zero), zero);
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(taps[i])));
+				}
+				filteredRows[(size_t)newWidth * y + x] = sum;
+			}
+		}
+		// the vertical pass, the negative lobes of the filter can leave the byte range so the result is saturated
+		for (int y = 0; y < newHeight; y++) {
+
+			uchar* row = destination + (size_t)newWidth * 4 * y;
+			for (int x = 0; x < newWidth; x++) {
+
+				__m128 sum = _mm_setzero_ps();
+				for (int i = 0; i < KAISER_TAPS; i++) {
+
+					int sourceRow = std::min<int>(std::max<int>(2 * y - KAISER_TAPS / 2 + 1 + i, 0), height - 1);
+					sum = _mm_add_ps(sum, _mm_mul_ps(filteredRows[(size_t)newWidth * sourceRow + x], _mm_set1_ps(taps[i])));
+				}
+				__m128i channels = _mm_cvtps_epi32(sum);
+				channels = _mm_packus_epi16(_mm_packs_epi32(channels, zero), zero);
+				int texel = _mm_cvtsi128_si32(channels);
+				std::memcpy(row + x * 4, &texel, sizeof(texel));
+			}
+		}
+	}
+
+	void TextureConverter::writeContainer(const char* containerFile, const uchar* pixels, int width, int height, bool mipmapped,
+		uint filter, uint format) {
+
+		BNDR_PROFILE_SCOPE("TextureConverter::writeContainer");
+		if (width <= 0 || height <= 0) {
+
+			BNDR_EXCEPTION("A texture container cannot hold an image of 0 texels");
+		}
+		if (format != BTEX_AUTO_COMPRESSED && MappedTextureContainer::computeLevelBytes(format, 1, 1) == 0) {
+
+			BNDR_EXCEPTION("A texture container cannot be written in an unknown pixel format");
+		}
+		// build the mip chain, every level is filtered from the one before it
+		std::vector<std::vector<uchar>> chain;
+		chain.emplace_back(pixels, pixels + (size_t)width * height * 4);
+		int levelWidth = width;
+		int levelHeight = height;
+		while (mipmapped && (levelWidth > 1 || levelHeight > 1)) {
+
+			int newWidth = std::max<int>(levelWidth / 2, 1);
+			int newHeight = std::max<int>(levelHeight / 2, 1);
+			std::vector<uchar> level((size_t)newWidth * newHeight * 4);
+			if (filter == BTEX_FILTER_KAISER) {
+
+				downsampleKaiser(chain.back().data(), levelWidth, levelHeight, level.data());
+			}
+			else {
+
+				downsampleBox(chain.back().data(), levelWidth, levelHeight, level.data());
+			}
+			chain.push_back(std::move(level));
+			levelWidth = newWidth;
+			levelHeight = newHeight;
+		}
+
+		TextureContainerHeader header;
+		std::memcpy(header.magic, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+		header.version = MappedTextureContainer::VERSION;
+		header.format = format;
+		header.width = (uint)width;
+		header.height = (uint)height;
+		header.levelCount = (uint)chain.size();
+		header.flags = 0;
+		header.reserved = 0;
+		for (size_t i = 3; i < chain[0].size(); i += 4) {
+
+			if (chain[0][i] != 255) {
+
+				header.flags |= BTEX_HAS_ALPHA;
+				break;
+			}
+		}
+		if (format == BTEX_AUTO_COMPRESSED) {
+
+			header.format = (header.flags & BTEX_HAS_ALPHA) ? BTEX_BC3 : BTEX_BC1;
+		}
+		if (header.format != BTEX_RGBA8) {
+
+			// every level is compressed on its own, the filtered texels are not needed any more
+			levelWidth = width;
+			levelHeight = height;
+			for (std::vector<uchar>& level : chain) {
+
+				std::vector<uchar> blocks((size_t)MappedTextureContainer::computeLevelBytes(header.format, levelWidth, levelHeight));
+				if (header.format == BTEX_BC1) {
+
+					compressBC1(level.data(), levelWidth, levelHeight, blocks.data());
+				}
+				else {
+
+					compressBC3(level.data(), levelWidth, levelHeight, blocks.data());
+				}
+				level = std::move(blocks);
+				levelWidth = std::max<int>(levelWidth / 2, 1);
+				levelHeight = std::max<int>(levelHeight / 2, 1);
+			}
+		}
+		std::vector<TextureContainerLevel> levels(chain.size());
+		unsigned long long offset = alignOffset(sizeof(TextureContainerHeader) + sizeof(TextureContainerLevel) * levels.size());
+		for (size_t i = 0; i < chain.size(); i++) {
+
+			levels[i].offset = offset;
+			levels[i].bytes = chain[i].size();
+			offset = alignOffset(offset + levels[i].bytes);
+		}
+
+		std::ofstream output(containerFile, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!output.is_open()) {
+
+			std::string message = "Failed to create texture container '" + std::string(containerFile) + "'";
+			BNDR_EXCEPTION(message.c_str());
+		}
+		output.write((const char*)&header, sizeof(header));
+		output.write((const char*)levels.data(), sizeof(TextureContainerLevel) * levels.size());
+		const char padding[CONTAINER_ALIGNMENT] = {};
+		unsigned long long written = sizeof(TextureContainerHeader) + sizeof(TextureContainerLevel) * levels.size();
+		for (size_t i = 0; i < chain.size(); i++) {
+
+			output.write(padding, (std::streamsize)(levels[i].offset - written));
+			output.write((const char*)chain[i].data(), (std::streamsize)chain[i].size());
+			written = levels[i].offset + levels[i].bytes;
+		}
+		if (!output.good()) {
+
+			std::string message = "Failed to write texture container '" + std::string(containerFile) + "'";
+			BNDR_EXCEPTION(message.c_str());
+		}
+	}
+
+	void TextureConverter::convertBitMap(const char* bitMapFile, const char* containerFile, bool mipmapped, uint filter, uint format) {
+
+		BNDR_PROFILE_SCOPE("TextureConverter::convertBitMap");
+		MappedBitMap bitMap(bitMapFile);
+		// the rows stay bottom-up like every texture the engine uploads
+		std::unique_ptr<uchar[]> pixels(new uchar[(size_t)bitMap.getWidth() * bitMap.getHeight() * 4]);
+		bitMap.convertToRGBA(pixels.get(), false);
+		writeContainer(containerFile, pixels.get(), bitMap.getWidth(), bitMap.getHeight(), mipmapped, filter, format);
+	}
+
+	int TextureConverter::runCommandLine(int argc, const char* const* argv) {
+
+		const char* usage = "usage: <input.bmp> <output.btex> [--filter box|kaiser] [--no-mips] [--compress none|bc1|bc3|auto]";
+		std::vector<const char*> files;
+		bool mipmapped = true;
+		uint filter = BTEX_FILTER_BOX;
+		uint format = BTEX_RGBA8;
+		for (int i = 1; i < argc; i++) {
+
+			std::string argument = argv[i];
+			if (argument == "--no-mips") {
+
+				mipmapped = false;
+			}
+			else if (argument == "--filter" && i + 1 < argc) {
+
+				std::string name = argv[++i];
+				if (name != "box" && name != "kaiser") {
+
+					BNDR_MESSAGE(("Unknown mip filter '" + name + "', " + usage).c_str());
+					return 1;
+				}
+				filter = (name == "kaiser") ? BTEX_FILTER_KAISER : BTEX_FILTER_BOX;
+			}
+			else if (argument == "--compress" && i + 1 < argc) {
+
+				std::string name = argv[++i];
+				if (name == "none") {
+
+					format = BTEX_RGBA8;
+				}
+				else if (name == "bc1") {
+
+					format = BTEX_BC1;
+				}
+				else if (name == "bc3") {
+
+					format = BTEX_BC3;
+				}
+				else if (name == "auto") {
+
+					format = BTEX_AUTO_COMPRESSED;
+				}
+				else {
+
+					BNDR_MESSAGE(("Unknown compression '" + name + "', " + usage).c_str());
+					return 1;
+				}
+			}
+			else if (argument.compare(0, 2, "--") == 0) {
+
+				BNDR_MESSAGE(("Unknown option '" + argument + "', " + usage).c_str());
+				return 1;
+			}
+			else {
+
+				files.push_back(argv[i]);
+			}
+		}
+		if (files.size() != 2) {
+
+			BNDR_MESSAGE(usage);
+			return 1;
+		}
+		try {
+
+			convertBitMap(files[0], files[1], mipmapped, filter, format);
+		}
+		catch (const std::exception&) {
+
+			// the reason was printed when the exception was thrown
+			return 1;
+		}
+		std::string message = "Converted '" + std::string(files[0]) + "' to '" + std::string(files[1]) + "'";
+		BNDR_MESSAGE(message.c_str());
+		return 0;
+	}
+}
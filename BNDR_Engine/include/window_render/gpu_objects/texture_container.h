@@ -0,0 +1,162 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+
+namespace bndr {
+
+	// the pixel formats of a texture container payload
+	enum textureContainerFormats {
+
+		// only for the converter: BTEX_BC3 if the image has alpha and BTEX_BC1 if it does not (never stored in a file)
+		BTEX_AUTO_COMPRESSED = 0,
+		// 4 bytes per texel in RGBA order
+		BTEX_RGBA8 = 1,
+		// 8 bytes per 4x4 block, opaque
+		BTEX_BC1 = 2,
+		// 16 bytes per 4x4 block, the BC1 color plus interpolated alpha
+		BTEX_BC3 = 3
+	};
+
+	// flags stored in the header of a texture container
+	enum textureContainerFlags {
+
+		// at least one texel is not fully opaque
+		BTEX_HAS_ALPHA = 0x01
+	};
+
+	// the filters the converter can build the mip chain with
+	enum textureContainerFilters {
+
+		// average of every 2x2 block (sharp and fast)
+		BTEX_FILTER_BOX = 0,
+		// separable Kaiser windowed sinc over 6x6 texels (keeps more detail in the smaller levels)
+		BTEX_FILTER_KAISER = 1
+	};
+
+	// bndr::TextureContainerHeader
+	// Description: The fixed 32 byte header at the start of a .btex file. It is followed by one TextureContainerLevel per
+	// mip level and then by the level payloads, each starting on a 16 byte boundary. Rows are stored bottom-up and tightly
+	// packed (block compressed levels as rows of 4x4 blocks), so every level is handed to OpenGL exactly as it is in the file
+	struct TextureContainerHeader {
+
+		// "BTEX"
+		char magic[4];
+		uint version;
+		// see enum bndr::textureContainerFormats
+		uint format;
+		uint width;
+		uint height;
+		// level 0 is the full image and every further level halves the previous one (at least 1 texel)
+		uint levelCount;
+		// see enum bndr::textureContainerFlags
+		uint flags;
+		uint reserved;
+	};
+
+	// the position of a mip level in a .btex file
+	struct TextureContainerLevel {
+
+		// from the start of the file (a multiple of 16)
+		unsigned long long offset;
+		unsigned long long bytes;
+	};
+
+	// bndr::MappedTextureContainer
+	// Description: A .btex file mapped into memory with a Win32 file mapping. The header and the level table are validated
+	// once when the file is opened, after that the levels are uploaded straight out of the mapping: no parsing, no
+	// swizzling and no glGenerateMipmap at load time
+	class BNDR_API MappedTextureContainer {
+
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+		const uchar* view = nullptr;
+		TextureContainerHeader header;
+		const TextureContainerLevel* levels = nullptr;
+
+		// unmap the file and close the handles
+		void release();
+
+	public:
+
+		// the current version of the format
+		static const uint VERSION = 1;
+		// the most levels a container can have (enough for 2^31 texels on a side)
+		static const uint MAX_LEVELS = 32;
+
+		// map and validate a texture container (throws if the file is missing or not a valid container)
+		explicit MappedTextureContainer(const char* containerFile);
+		MappedTextureContainer(const MappedTextureContainer&) = delete;
+		MappedTextureContainer& operator=(const MappedTextureContainer&) = delete;
+		inline int getWidth() const { return (int)header.width; }
+		inline int getHeight() const { return (int)header.height; }
+		inline uint getFormat() const { return header.format; }
+		inline int getLevelCount() const { return (int)header.levelCount; }
+		inline bool hasAlpha() const { return (header.flags & BTEX_HAS_ALPHA) != 0; }
+		// get the size of a mip level
+		inline int getLevelWidth(int level) const { return std::max<int>((int)header.width >> level, 1); }
+		inline int getLevelHeight(int level) const { return std::max<int>((int)header.height >> level, 1); }
+		// get the texels of a mip level
+		inline const uchar* getLevel(int level) const { return view + levels[level].offset; }
+		inline unsigned long long getLevelBytes(int level) const { return levels[level].bytes; }
+		// get the bytes of every level
+		unsigned long long getTotalBytes() const;
+		// check if the levels are stored as BC1 or BC3 blocks
+		inline bool isCompressed() const { return header.format == BTEX_BC1 || header.format == BTEX_BC3; }
+		// upload every level into the texture bound to GL_TEXTURE_2D (levels past the last one in the file are disabled)
+		// compressed levels are decoded to RGBA first if the driver has no S3TC support
+		// returns the bytes of video memory the levels take
+		unsigned long long upload() const;
+		// get the bytes a level of a format takes
+		static unsigned long long computeLevelBytes(uint format, int width, int height);
+		// check if a file name ends in .btex
+		static bool isContainerFile(const char* path);
+		~MappedTextureContainer();
+	};
+
+	// bndr::TextureConverter
+	// Description: Offline converter from bitmaps to texture containers. The bitmap is swizzled to RGBA once and the whole
+	// mip chain is filtered ahead of time with SSE2, so loading the container at startup is a single copy per level. The levels
+	// can also be block compressed to BC1 or BC3 on every core, which takes a quarter to an eighth of the video memory.
+	// runCommandLine() is the whole converter program, a tool only has to forward its arguments to it
+	class BNDR_API TextureConverter {
+
+	public:
+
+		// write RGBA texels (bottom row first) into a container, with a full mip chain if mipmapped is set
+		// format is one of enum bndr::textureContainerFormats (the mip chain is filtered before it is compressed)
+		static void writeContainer(const char* containerFile, const uchar* pixels, int width, int height, bool mipmapped = true,
+			uint filter = BTEX_FILTER_BOX, uint format = BTEX_RGBA8);
+		// convert a bitmap file into a container
+		static void convertBitMap(const char* bitMapFile, const char* containerFile, bool mipmapped = true,
+			uint filter = BTEX_FILTER_BOX, uint format = BTEX_RGBA8);
+		// usage: <input.bmp> <output.btex> [--filter box|kaiser] [--no-mips] [--compress none|bc1|bc3|auto]
+		// returns 0 on success and 1 on failure (the reason is printed)
+		static int runCommandLine(int argc, const char* const* argv);
+	};
+
+	// halve RGBA texels with a 2x2 box filter (the destination is max(width / 2, 1) by max(height / 2, 1))
+	BNDR_API void downsampleBox(const uchar* source, int width, int height, uchar* destination);
+	// halve RGBA texels with a 6 tap Kaiser windowed sinc filter in both directions
+	BNDR_API void downsampleKaiser(const uchar* source, int width, int height, uchar* destination);
+}
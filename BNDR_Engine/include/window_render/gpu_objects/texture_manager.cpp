@@ -0,0 +1,302 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "texture_manager.h"
+#include "bitmap_loader.h"
+#include "texture_container.h"
+#include "GLState.h"
+#include "../../profiling/profiler.h"
+
+namespace bndr {
+
+	std::mutex TextureManager::entryMutex;
+	std::unordered_map<uint, TextureManager::Entry> TextureManager::entries;
+	std::unordered_map<std::string, uint> TextureManager::paths;
+	std::list<uint> TextureManager::unreferenced;
+	// 512 MB until the application sets its own budget
+	TextureMemoryStats TextureManager::stats = { 0, 0, 0, 0, 512ull * 1024ull * 1024ull, 0, 0, 0, 0 };
+
+	std::string TextureManager::normalizePath(const char* path) {
+
+		std::string normalized = path;
+		for (char& c : normalized) {
+
+			c = (c == '\\') ? '/' : (char)std::tolower((unsigned char)c);
+		}
+		return normalized;
+	}
+
+	unsigned long long TextureManager::estimateBytes(int width, int height, bool mipmapped) {
+
+		unsigned long long bytes = 0;
+		while (true) {
+
+			bytes += (unsigned long long)width * height * 4;
+			if (!mipmapped || (width == 1 && height == 1)) {
+
+				break;
+			}
+			width = std::max<int>(width / 2, 1);
+			height = std::max<int>(height / 2, 1);
+		}
+		return bytes;
+	}
+
+	uint TextureManager::createTexture(uint textureSWrapping, uint textureTWrapping, uint textureMinFiltering, uint textureMagFiltering) {
+
+		uint textureID = 0;
+		glGenTextures(1, &textureID);
+		GLState::bindTexture(GL_TEXTURE0, textureID);
+
+		// how the texture is wrapped on the surface
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureSWrapping);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureTWrapping);
+		// are the texture pixels smooth (TEXTURE_LINEAR) or are they sharp (TEXTURE_NEAREST)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, textureMinFiltering);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, textureMagFiltering);
+		return textureID;
+	}
+
+	uint TextureManager::load(const char* bitMapFile, uint textureSWrapping, uint textureTWrapping, uint textureMinFiltering,
+		uint textureMagFiltering, unsigned long long& bytes) {
+
+		BNDR_FLIGHT_SCOPE("TextureManager::load");
+		if (MappedTextureContainer::isContainerFile(bitMapFile)) {
+
+			// preprocessed textures already have their whole mip chain (RGBA or blocks), every level goes straight out of the mapping
+			MappedTextureContainer container(bitMapFile);
+			uint textureID = createTexture(textureSWrapping, textureTWrapping, textureMinFiltering, textureMagFiltering);
+			bytes = container.upload();
+			return textureID;
+		}
+		// map the bitmap file into memory (throws before any texture is created if the file is bad)
+		MappedBitMap bitMap(bitMapFile);
+		uint textureID = createTexture(textureSWrapping, textureTWrapping, textureMinFiltering, textureMagFiltering);
+
+		const uchar* pixels = bitMap.getPixels();
+		std::unique_ptr<uchar[]> flippedPixels;
+		if (!bitMap.isUploadReady()) {
+
+			// top-down rows have to be flipped first, everything else goes to OpenGL straight out of the mapping
+			flippedPixels.reset(new uchar[(size_t)bitMap.getStride() * bitMap.getHeight()]);
+			bitMap.copyBottomUp(flippedPixels.get());
+			pixels = flippedPixels.get();
+		}
+		// create the 2D image and its respective mipmaps
+		GL_DEBUG_FUNC(glTexImage2D(GL_TEXTURE_2D, 0, bitMap.getGLInternalFormat(), bitMap.getWidth(), bitMap.getHeight(),
+			0, bitMap.getGLFormat(), GL_UNSIGNED_BYTE, pixels));
+		RenderStats::addBytesUploaded((unsigned long long)bitMap.getStride() * bitMap.getHeight());
+		glGenerateMipmap(GL_TEXTURE_2D);
+		bytes = estimateBytes(bitMap.getWidth(), bitMap.getHeight(), true);
+		return textureID;
+	}
+
+	void TextureManager::evictFor(unsigned long long bytes) {
+
+		while (!unreferenced.empty() && stats.residentBytes + bytes > stats.budget) {
+
+			auto entry = entries.find(unreferenced.front());
+			unreferenced.pop_front();
+			GLState::deleteTexture(entry->second.textureID);
+			paths.erase(entry->second.path);
+			stats.residentTextures--;
+			stats.residentBytes -= entry->second.bytes;
+			stats.evictions++;
+			stats.evictedBytes += entry->second.bytes;
+			entries.erase(entry);
+		}
+	}
+
+	uint TextureManager::referenceResident(const std::string& path) {
+
+		auto existing = paths.find(path);
+		if (existing == paths.end()) {
+
+			return 0;
+		}
+		stats.hits++;
+		Entry& entry = entries[existing->second];
+		if (entry.references == 0) {
+
+			unreferenced.erase(entry.unreferencedPosition);
+			stats.referencedTextures++;
+			stats.referencedBytes += entry.bytes;
+		}
+		entry.references++;
+		return entry.textureID;
+	}
+
+	void TextureManager::insert(const std::string& path, uint textureID, unsigned long long bytes) {
+
+		// make room for the new texture (it is already in video memory, but the total should settle under the budget)
+		evictFor(bytes);
+		Entry entry = { path, textureID, 1, bytes, unreferenced.end() };
+		entries.insert(std::make_pair(textureID, entry));
+		paths.insert(std::make_pair(path, textureID));
+		stats.loads++;
+		stats.residentTextures++;
+		stats.referencedTextures++;
+		stats.residentBytes += bytes;
+		stats.referencedBytes += bytes;
+	}
+
+	uint TextureManager::acquire(const char* bitMapFile, uint textureSWrapping, uint textureTWrapping, uint textureMinFiltering,
+		uint textureMagFiltering) {
+
+		std::string path = normalizePath(bitMapFile);
+		{
+			std::lock_guard<std::mutex> lock(entryMutex);
+			uint resident = referenceResident(path);
+			if (resident != 0) {
+
+				return resident;
+			}
+		}
+		// the file is read without holding the lock
+		unsigned long long bytes = 0;
+		uint textureID = load(bitMapFile, textureSWrapping, textureTWrapping, textureMinFiltering, textureMagFiltering, bytes);
+
+		std::lock_guard<std::mutex> lock(entryMutex);
+		insert(path, textureID, bytes);
+		return textureID;
+	}
+
+	uint TextureManager::acquireResident(const char* bitMapFile) {
+
+		std::string path = normalizePath(bitMapFile);
+		std::lock_guard<std::mutex> lock(entryMutex);
+		return referenceResident(path);
+	}
+
+	uint TextureManager::adopt(const char* bitMapFile, uint textureID, unsigned long long bytes) {
+
+		std::string path = normalizePath(bitMapFile);
+		std::lock_guard<std::mutex> lock(entryMutex);
+		uint resident = referenceResident(path);
+		if (resident != 0) {
+
+			// the file was loaded directly while it streamed in, the copy is not needed
+			GLState::deleteTexture(textureID);
+			return resident;
+		}
+		insert(path, textureID, bytes);
+		return textureID;
+	}
+
+	void TextureManager::addReference(uint textureID) {
+
+		if (textureID == 0) {
+
+			return;
+		}
+		std::lock_guard<std::mutex> lock(entryMutex);
+		auto entry = entries.find(textureID);
+		if (entry == entries.end()) {
+
+			return;
+		}
+		if (entry->second.references == 0) {
+
+			unreferenced.erase(entry->second.unreferencedPosition);
+			stats.referencedTextures++;
+			stats.referencedBytes += entry->second.bytes;
+		}
+		entry->second.references++;
+	}
+
+	void TextureManager::release(uint textureID) {
+
+		if (textureID == 0) {
+
+			return;
+		}
+		std::lock_guard<std::mutex> lock(entryMutex);
+		auto entry = entries.find(textureID);
+		if (entry == entries.end() || entry->second.references == 0) {
+
+			return;
+		}
+		if (--entry->second.references == 0) {
+
+			// the texture stays resident until the budget needs its memory
+			entry->second.unreferencedPosition = unreferenced.insert(unreferenced.end(), textureID);
+			stats.referencedTextures--;
+			stats.referencedBytes -= entry->second.bytes;
+		}
+	}
+
+	void TextureManager::discard(uint textureID) {
+
+		release(textureID);
+		std::lock_guard<std::mutex> lock(entryMutex);
+		auto entry = entries.find(textureID);
+		if (entry == entries.end() || entry->second.references != 0) {
+
+			return;
+		}
+		unreferenced.erase(entry->second.unreferencedPosition);
+		GLState::deleteTexture(textureID);
+		paths.erase(entry->second.path);
+		stats.residentTextures--;
+		stats.residentBytes -= entry->second.bytes;
+		entries.erase(entry);
+	}
+
+	void TextureManager::setBudget(unsigned long long bytes) {
+
+		std::lock_guard<std::mutex> lock(entryMutex);
+		stats.budget = bytes;
+		evictFor(0);
+	}
+
+	void TextureManager::trim() {
+
+		std::lock_guard<std::mutex> lock(entryMutex);
+		unsigned long long budget = stats.budget;
+		stats.budget = 0;
+		evictFor(0);
+		stats.budget = budget;
+	}
+
+	TextureMemoryStats TextureManager::getStats() {
+
+		std::lock_guard<std::mutex> lock(entryMutex);
+		return stats;
+	}
+
+	void TextureManager::shutdown() {
+
+		std::lock_guard<std::mutex> lock(entryMutex);
+		for (auto& entry : entries) {
+
+			GLState::deleteTexture(entry.second.textureID);
+		}
+		entries.clear();
+		paths.clear();
+		unreferenced.clear();
+		stats.residentTextures = 0;
+		stats.referencedTextures = 0;
+		stats.residentBytes = 0;
+		stats.referencedBytes = 0;
+	}
+}
@@ -0,0 +1,118 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include <list>
+
+namespace bndr {
+
+	// the video memory used by the textures of bndr::TextureManager
+	struct TextureMemoryStats {
+
+		// textures in video memory and how many of them are referenced by a bndr::Texture
+		int residentTextures = 0;
+		int referencedTextures = 0;
+		// the estimated bytes of the resident and of the referenced textures
+		unsigned long long residentBytes = 0;
+		unsigned long long referencedBytes = 0;
+		unsigned long long budget = 0;
+		// files loaded, requests served by a resident texture and textures evicted since the start
+		unsigned long long loads = 0;
+		unsigned long long hits = 0;
+		unsigned long long evictions = 0;
+		unsigned long long evictedBytes = 0;
+	};
+
+	// bndr::TextureManager
+	// Description: Static owner of the textures loaded from bitmap files. Textures are keyed by their normalized path
+	// (forward slashes, lower case, as paths on Windows are not case sensitive), so the same file is only ever loaded
+	// once no matter which string names it. Every bndr::Texture holds a reference to its texture. A texture nobody
+	// references stays resident so a later request is free, but once the estimated video memory (every mip level, 4
+	// bytes per texel as drivers store RGB as RGBA) exceeds the budget the least recently used unreferenced textures are
+	// deleted. Referenced textures are never evicted, so the budget can be exceeded while they are all in use.
+	// Textures streamed in by bndr::TextureStreamer are adopted once they are ready and shared the same way.
+	// Only the thread that owns the OpenGL context may load textures, references may be taken and dropped anywhere
+	class BNDR_API TextureManager {
+
+		struct Entry {
+
+			std::string path;
+			uint textureID;
+			int references;
+			unsigned long long bytes;
+			// the position in the unreferenced list (valid while references is 0)
+			std::list<uint>::iterator unreferencedPosition;
+		};
+
+		static std::mutex entryMutex;
+		// the entries by texture id and the texture ids by normalized path
+		static std::unordered_map<uint, Entry> entries;
+		static std::unordered_map<std::string, uint> paths;
+		// unreferenced textures, least recently used first
+		static std::list<uint> unreferenced;
+		static TextureMemoryStats stats;
+
+		// create a texture with its wrapping and filtering and bind it to GL_TEXTURE0
+		static uint createTexture(uint textureSWrapping, uint textureTWrapping, uint textureMinFiltering, uint textureMagFiltering);
+		// load a bitmap or a .btex texture container into a new texture, returns its id and estimated size
+		static uint load(const char* bitMapFile, uint textureSWrapping, uint textureTWrapping, uint textureMinFiltering,
+			uint textureMagFiltering, unsigned long long& bytes);
+		// delete unreferenced textures until the given bytes fit into the budget (the mutex has to be held)
+		static void evictFor(unsigned long long bytes);
+		// take a reference to the texture of a normalized path, 0 if it is not resident (the mutex has to be held)
+		static uint referenceResident(const std::string& path);
+		// add a new texture with one reference taken (the mutex has to be held)
+		static void insert(const std::string& path, uint textureID, unsigned long long bytes);
+
+	public:
+
+		// get the key a file is stored under (lower case with forward slashes)
+		static std::string normalizePath(const char* path);
+		// get the texture of a bitmap file with one reference taken, loading it if it is not resident
+		// (the wrapping and filtering only apply when the file is loaded, files ending in .btex are loaded as texture containers)
+		static uint acquire(const char* bitMapFile, uint textureSWrapping, uint textureTWrapping, uint textureMinFiltering,
+			uint textureMagFiltering);
+		// get the texture of a file with one reference taken if it is resident, 0 if it is not (never loads)
+		static uint acquireResident(const char* bitMapFile);
+		// (render thread) take over a texture loaded elsewhere under a file path with one reference taken and return its id
+		// if the file became resident in the meantime the given texture is deleted and the resident one is returned instead
+		static uint adopt(const char* bitMapFile, uint textureID, unsigned long long bytes);
+		// take another reference to a texture (ids the manager did not load are ignored)
+		static void addReference(uint textureID);
+		// drop a reference to a texture (ids the manager did not load are ignored)
+		static void release(uint textureID);
+		// (render thread) drop a reference and delete the texture right away if that was the last one
+		static void discard(uint textureID);
+		// set the video memory budget in bytes and evict down to it (render thread)
+		static void setBudget(unsigned long long bytes);
+		static inline unsigned long long getBudget() { return stats.budget; }
+		// delete every unreferenced texture (render thread)
+		static void trim();
+		// estimate the video memory of a texture (mipmapped textures include every level)
+		static unsigned long long estimateBytes(int width, int height, bool mipmapped);
+		// get the current usage
+		static TextureMemoryStats getStats();
+		// delete every texture (called by ~Window, the ids of remaining bndr::Texture objects are no longer valid)
+		static void shutdown();
+	};
+}
@@ -0,0 +1,398 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "texture_streamer.h"
+#include "texture_manager.h"
+#include "../../profiling/profiler.h"
+
+namespace bndr {
+
+	std::mutex TextureStreamer::queueMutex;
+	std::condition_variable TextureStreamer::queueCondition;
+	std::deque<std::shared_ptr<TextureStreamRequest>> TextureStreamer::decodeQueue;
+	std::deque<std::shared_ptr<TextureStreamRequest>> TextureStreamer::decodedQueue;
+	std::unordered_map<std::string, std::shared_ptr<TextureStreamRequest>> TextureStreamer::requests;
+	std::vector<std::thread> TextureStreamer::decodeThreads;
+	int TextureStreamer::decodeThreadCount = 0;
+	bool TextureStreamer::stopping = false;
+	std::deque<std::shared_ptr<TextureStreamRequest>> TextureStreamer::uploadQueue;
+	std::vector<TextureStreamer::PixelBuffer> TextureStreamer::pixelBuffers;
+	int TextureStreamer::nextPixelBuffer = 0;
+	int TextureStreamer::pixelBufferCount = 3;
+	// 4 MB buffers and budget: a 1024 by 1024 bitmap arrives in 3 frames
+	unsigned long long TextureStreamer::pixelBufferSize = 4ull * 1024ull * 1024ull;
+	unsigned long long TextureStreamer::frameBudget = 4ull * 1024ull * 1024ull;
+	std::atomic<uint> TextureStreamer::placeholderID{ 0 };
+	std::function<void(const std::string&, const TextureStreamTiming&)> TextureStreamer::loadCallback;
+
+	// the milliseconds between two points in time
+	static double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	uint TextureHandle::getTextureID() const {
+
+		uint textureID = request->textureID.load();
+		return (textureID != 0) ? textureID : TextureStreamer::getPlaceholderID();
+	}
+
+	Texture TextureHandle::getTexture() const {
+
+		Texture texture;
+		texture.overwriteData(getTextureID(), GL_TEXTURE0);
+		return texture;
+	}
+
+	TextureStreamTiming TextureHandle::getTiming() const {
+
+		// the timing is written before the state is set to ready
+		return isReady() ? request->timing : TextureStreamTiming();
+	}
+
+	TextureHandle TextureStreamer::request(const char* bitMapFile, uint textureSWrapping, uint textureTWrapping,
+		uint textureMinFiltering, uint textureMagFiltering) {
+
+		// keyed like TextureManager, so every spelling of a file shares one request
+		std::string key = TextureManager::normalizePath(bitMapFile);
+		std::lock_guard<std::mutex> lock(queueMutex);
+		auto existing = requests.find(key);
+		if (existing != requests.end()) {
+
+			return TextureHandle(existing->second);
+		}
+		std::shared_ptr<TextureStreamRequest> request = std::make_shared<TextureStreamRequest>();
+		request->path = bitMapFile;
+		request->sWrapping = textureSWrapping;
+		request->tWrapping = textureTWrapping;
+		request->minFiltering = textureMinFiltering;
+		request->magFiltering = textureMagFiltering;
+		request->requested = std::chrono::steady_clock::now();
+		requests.insert(std::make_pair(key, request));
+		// a resident file is ready at once (its timing stays 0)
+		uint resident = TextureManager::acquireResident(bitMapFile);
+		if (resident != 0) {
+
+			request->textureID.store(resident);
+			request->state.store(TEXTURE_READY);
+			return TextureHandle(request);
+		}
+		// the decode threads start with the first request
+		if (decodeThreads.empty()) {
+
+			int count = decodeThreadCount;
+			if (count <= 0) {
+
+				// leave the render and update threads their cores
+				count = std::min<int>(std::max<int>((int)std::thread::hardware_concurrency() - 2, 1), 4);
+			}
+			stopping = false;
+			for (int i = 0; i < count; i++) {
+
+				decodeThreads.emplace_back(TextureStreamer::decodeLoop);
+			}
+		}
+		decodeQueue.push_back(request);
+		queueCondition.notify_one();
+		return TextureHandle(request);
+	}
+
+	void TextureStreamer::decodeLoop() {
+
+		while (true) {
+
+			std::shared_ptr<TextureStreamRequest> request;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				queueCondition.wait(lock, []() { return stopping || !decodeQueue.empty(); });
+				if (stopping) {
+
+					break;
+				}
+				request = decodeQueue.front();
+				decodeQueue.pop_front();
+			}
+			request->decodeStarted = std::chrono::steady_clock::now();
+			request->state.store(TEXTURE_DECODING);
+			try {
+
+				BNDR_FLIGHT_SCOPE("TextureStreamer::decode");
+				request->image = Texture::loadBitMap(request->path.c_str());
+			}
+			catch (const std::exception&) {
+
+				// the logger already printed why
+				request->state.store(TEXTURE_FAILED);
+				continue;
+			}
+			request->decoded = std::chrono::steady_clock::now();
+			request->state.store(TEXTURE_DECODED);
+			std::lock_guard<std::mutex> lock(queueMutex);
+			decodedQueue.push_back(request);
+		}
+	}
+
+	void TextureStreamer::createObjects() {
+
+		// a grey checker that shows something is there without drawing attention to itself
+		uchar checker[16] = {
+			0x60, 0x60, 0x60, 0x90, 0x90, 0x90, 0x00, 0x00,
+			0x90, 0x90, 0x90, 0x60, 0x60, 0x60, 0x00, 0x00
+		};
+		uint textureID = 0;
+		glGenTextures(1, &textureID);
+		GLState::bindTexture(GL_TEXTURE0, textureID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		GL_DEBUG_FUNC(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_BGR, GL_UNSIGNED_BYTE, checker));
+		placeholderID.store(textureID);
+
+		pixelBuffers.resize(pixelBufferCount);
+		for (PixelBuffer& buffer : pixelBuffers) {
+
+			glGenBuffers(1, &buffer.bufferID);
+			GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.bufferID);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)pixelBufferSize, NULL, GL_STREAM_DRAW);
+			buffer.capacity = pixelBufferSize;
+		}
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		nextPixelBuffer = 0;
+	}
+
+	bool TextureStreamer::uploadRows(TextureStreamRequest& request, unsigned long long& budget) {
+
+		PixelBuffer& buffer = pixelBuffers[nextPixelBuffer];
+		if (buffer.fence != 0) {
+
+			// the GPU may still be reading the last rows out of this buffer
+			if (glClientWaitSync(buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+
+				return false;
+			}
+			glDeleteSync(buffer.fence);
+			buffer.fence = 0;
+		}
+		int width = request.image.width;
+		int height = request.image.height;
+		// rows are padded to 4 bytes, which is also the default unpack alignment
+		unsigned long long rowBytes = (unsigned long long)request.image.getRowBytes();
+		uint format = request.image.format;
+		if (request.uploadID == 0) {
+
+			// allocate the texture without data, the rows follow through the pixel buffers
+			glGenTextures(1, &request.uploadID);
+			GLState::bindTexture(GL_TEXTURE0, request.uploadID);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, request.sWrapping);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, request.tWrapping);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, request.minFiltering);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, request.magFiltering);
+			GL_DEBUG_FUNC(glTexImage2D(GL_TEXTURE_2D, 0, request.image.internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, NULL));
+			request.uploadStarted = std::chrono::steady_clock::now();
+			request.state.store(TEXTURE_UPLOADING);
+		}
+		// at least one row goes up every frame so a texture with very wide rows still arrives
+		int rows = std::min<int>(height - request.uploadedRows, (int)std::max<unsigned long long>(budget / rowBytes, 1));
+		rows = std::min<int>(rows, (int)std::max<unsigned long long>(buffer.capacity / rowBytes, 1));
+		unsigned long long bytes = rowBytes * rows;
+
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.bufferID);
+		if (bytes > buffer.capacity) {
+
+			// a single row is larger than the buffer
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bytes, NULL, GL_STREAM_DRAW);
+			buffer.capacity = bytes;
+		}
+		// the fence guarantees the GPU is done with the buffer, so the driver does not have to synchronize the map
+		void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (destination == nullptr) {
+
+			GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			return false;
+		}
+		std::memcpy(destination, request.image.ptr.get() + rowBytes * request.uploadedRows, (size_t)bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		GLState::bindTexture(GL_TEXTURE0, request.uploadID);
+		// with a pixel unpack buffer bound the data pointer is an offset into the buffer
+		GL_DEBUG_FUNC(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, request.uploadedRows, width, rows, format, GL_UNSIGNED_BYTE, (const void*)0));
+		buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		nextPixelBuffer = (nextPixelBuffer + 1) % (int)pixelBuffers.size();
+		// every other texture upload passes client memory, which only works with no unpack buffer bound
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		request.uploadedRows += rows;
+		budget -= std::min<unsigned long long>(budget, bytes);
+		RenderStats::addBytesUploaded(bytes);
+		return true;
+	}
+
+	void TextureStreamer::completeRequest(TextureStreamRequest& request) {
+
+		GLState::bindTexture(GL_TEXTURE0, request.uploadID);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		// the decoded rows are no longer needed
+		request.image.ptr.reset();
+		// from now on the manager owns the texture and the request holds a reference to it
+		uint textureID = TextureManager::adopt(request.path.c_str(), request.uploadID,
+			TextureManager::estimateBytes(request.image.width, request.image.height, true));
+		request.uploadID = 0;
+
+		std::chrono::steady_clock::time_point ready = std::chrono::steady_clock::now();
+		TextureStreamTiming& timing = request.timing;
+		timing.queuedMs = millisecondsBetween(request.requested, request.decodeStarted);
+		timing.decodeMs = millisecondsBetween(request.decodeStarted, request.decoded);
+		timing.uploadWaitMs = millisecondsBetween(request.decoded, request.uploadStarted);
+		timing.uploadMs = millisecondsBetween(request.uploadStarted, ready);
+		timing.totalMs = millisecondsBetween(request.requested, ready);
+		request.textureID.store(textureID);
+		request.state.store(TEXTURE_READY);
+		if (loadCallback) {
+
+			loadCallback(request.path, timing);
+		}
+	}
+
+	int TextureStreamer::getPendingCount() {
+
+		std::lock_guard<std::mutex> lock(queueMutex);
+		int pending = 0;
+		for (const auto& entry : requests) {
+
+			uint state = entry.second->state.load();
+			if (state != TEXTURE_READY && state != TEXTURE_FAILED) {
+
+				pending++;
+			}
+		}
+		return pending;
+	}
+
+	void TextureStreamer::releaseUnusedRequests() {
+
+		for (auto entry = requests.begin(); entry != requests.end();) {
+
+			// handles are only copied out of the map with the mutex held, so a request only the map holds stays unused
+			uint state = entry->second->state.load();
+			if (entry->second.use_count() == 1 && (state == TEXTURE_READY || state == TEXTURE_FAILED)) {
+
+				// the texture stays resident until the budget of the manager needs its memory
+				TextureManager::release(entry->second->textureID.load());
+				entry = requests.erase(entry);
+			}
+			else {
+
+				++entry;
+			}
+		}
+	}
+
+	void TextureStreamer::update() {
+
+		BNDR_FLIGHT_SCOPE("TextureStreamer::update");
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			releaseUnusedRequests();
+			// nothing was requested yet (the pixel buffers are only created once streaming is used)
+			if (decodeThreads.empty()) {
+
+				return;
+			}
+			while (!decodedQueue.empty()) {
+
+				uploadQueue.push_back(decodedQueue.front());
+				decodedQueue.pop_front();
+			}
+		}
+		if (placeholderID.load() == 0) {
+
+			createObjects();
+		}
+		unsigned long long budget = frameBudget;
+		while (!uploadQueue.empty() && budget > 0) {
+
+			TextureStreamRequest& request = *uploadQueue.front();
+			if (!uploadRows(request, budget)) {
+
+				// every pixel buffer is still in flight, the rest waits for the next frame
+				break;
+			}
+			if (request.uploadedRows == request.image.height) {
+
+				completeRequest(request);
+				uploadQueue.pop_front();
+			}
+		}
+	}
+
+	void TextureStreamer::stop() {
+
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stopping = true;
+		}
+		queueCondition.notify_all();
+		for (std::thread& thread : decodeThreads) {
+
+			thread.join();
+		}
+		decodeThreads.clear();
+		// whatever did not arrive stays on the placeholder, and the handles of ready textures go back to it
+		std::lock_guard<std::mutex> lock(queueMutex);
+		for (auto& entry : requests) {
+
+			uint textureID = entry.second->textureID.exchange(0);
+			if (textureID != 0) {
+
+				TextureManager::discard(textureID);
+			}
+			entry.second->state.store(TEXTURE_FAILED);
+			if (entry.second->uploadID != 0) {
+
+				GLState::deleteTexture(entry.second->uploadID);
+				entry.second->uploadID = 0;
+			}
+			entry.second->image.ptr.reset();
+		}
+		// handles keep their requests, a new request for the same file loads it again
+		requests.clear();
+		decodeQueue.clear();
+		decodedQueue.clear();
+		uploadQueue.clear();
+		for (PixelBuffer& buffer : pixelBuffers) {
+
+			if (buffer.fence != 0) {
+
+				glDeleteSync(buffer.fence);
+			}
+			GLState::deleteBuffer(buffer.bufferID);
+		}
+		pixelBuffers.clear();
+		uint placeholder = placeholderID.exchange(0);
+		if (placeholder != 0) {
+
+			GLState::deleteTexture(placeholder);
+		}
+	}
+}
@@ -0,0 +1,189 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "textures.h"
+
+namespace bndr {
+
+	// the states of a texture requested from bndr::TextureStreamer
+	enum textureStreamStates {
+
+		// waiting for a decode thread
+		TEXTURE_QUEUED = 0,
+		// the file is being read on a decode thread
+		TEXTURE_DECODING = 1,
+		// decoded and waiting for the render thread
+		TEXTURE_DECODED = 2,
+		// being uploaded a few rows per frame
+		TEXTURE_UPLOADING = 3,
+		// the texture can be drawn
+		TEXTURE_READY = 4,
+		// the file could not be read (the placeholder stays)
+		TEXTURE_FAILED = 5
+	};
+
+	// how long the steps of a streamed texture took in milliseconds
+	struct TextureStreamTiming {
+
+		// from the request until a decode thread picked it up
+		double queuedMs = 0.0;
+		// reading and decoding the file
+		double decodeMs = 0.0;
+		// from the end of the decode until the first rows were uploaded
+		double uploadWaitMs = 0.0;
+		// from the first to the last rows uploaded
+		double uploadMs = 0.0;
+		// from the request until the texture was ready
+		double totalMs = 0.0;
+	};
+
+	// a texture requested from bndr::TextureStreamer (shared by every handle to the same file)
+	struct TextureStreamRequest {
+
+		std::string path;
+		uint sWrapping;
+		uint tWrapping;
+		uint minFiltering;
+		uint magFiltering;
+		// see enum bndr::textureStreamStates
+		std::atomic<uint> state{ TEXTURE_QUEUED };
+		// 0 until the texture is ready, from then on the request holds one bndr::TextureManager reference to it
+		std::atomic<uint> textureID{ 0 };
+		// the decoded bitmap (written by the decode thread, then only touched by the render thread)
+		BitMapData image;
+		// the texture object the rows are uploaded into and how many rows are in it
+		uint uploadID = 0;
+		int uploadedRows = 0;
+		std::chrono::steady_clock::time_point requested;
+		std::chrono::steady_clock::time_point decodeStarted;
+		std::chrono::steady_clock::time_point decoded;
+		std::chrono::steady_clock::time_point uploadStarted;
+		// only valid once the state is TEXTURE_READY
+		TextureStreamTiming timing;
+	};
+
+	// bndr::TextureHandle
+	// Description: A streamed texture. Until the texture is ready the handle returns the placeholder texture, so a surface
+	// can be given the handle right away and simply starts drawing the real image once it arrived. Handles are cheap to
+	// copy and may be read from any thread. The texture stays referenced while a handle to it exists, after the last
+	// handle is gone it is left to the budget of bndr::TextureManager like any other unreferenced texture
+	class BNDR_API TextureHandle {
+
+		std::shared_ptr<TextureStreamRequest> request;
+
+	public:
+
+		TextureHandle() {}
+		explicit TextureHandle(const std::shared_ptr<TextureStreamRequest>& streamRequest) : request(streamRequest) {}
+		// check if the handle refers to a request
+		inline bool isValid() const { return request != nullptr; }
+		// get the state of the texture (see enum bndr::textureStreamStates)
+		inline uint getState() const { return request->state.load(); }
+		inline bool isReady() const { return getState() == TEXTURE_READY; }
+		inline bool isFailed() const { return getState() == TEXTURE_FAILED; }
+		// get the id of the texture, or of the placeholder while it is not ready
+		uint getTextureID() const;
+		// get the texture (or the placeholder while it is not ready) in slot 0
+		Texture getTexture() const;
+		// get the load latency of the texture (all 0 until it is ready)
+		TextureStreamTiming getTiming() const;
+		inline const std::string& getPath() const { return request->path; }
+	};
+
+	// bndr::TextureStreamer
+	// Description: Static loader that keeps bitmap loading off the render thread. request() queues a file and returns a
+	// handle at once, decode threads read the files and update() (called by Window::update every frame) copies the
+	// decoded rows into a ring of pixel buffer objects and from there into the texture. Each frame uploads at most
+	// the frame budget of bytes, and a pixel buffer is only refilled once the fence of its last upload signalled, so the
+	// copy never waits for the GPU. A texture becomes ready once its last rows were uploaded and its mipmaps generated.
+	// The load latency of every texture is kept in its handle and passed to the load callback. Ready textures are adopted
+	// by bndr::TextureManager, so a file that is already resident is never streamed again
+	class BNDR_API TextureStreamer {
+
+		// a pixel buffer of the upload ring
+		struct PixelBuffer {
+
+			uint bufferID = 0;
+			unsigned long long capacity = 0;
+			// signalled once the GPU read the last upload out of the buffer (0 if nothing is in flight)
+			GLsync fence = 0;
+		};
+
+		static std::mutex queueMutex;
+		static std::condition_variable queueCondition;
+		// requests waiting for a decode thread
+		static std::deque<std::shared_ptr<TextureStreamRequest>> decodeQueue;
+		// decoded requests waiting for the render thread
+		static std::deque<std::shared_ptr<TextureStreamRequest>> decodedQueue;
+		// every request by normalized path, so a file is only loaded once
+		static std::unordered_map<std::string, std::shared_ptr<TextureStreamRequest>> requests;
+		static std::vector<std::thread> decodeThreads;
+		static int decodeThreadCount;
+		static bool stopping;
+		// only touched on the render thread
+		static std::deque<std::shared_ptr<TextureStreamRequest>> uploadQueue;
+		static std::vector<PixelBuffer> pixelBuffers;
+		static int nextPixelBuffer;
+		static int pixelBufferCount;
+		static unsigned long long pixelBufferSize;
+		static unsigned long long frameBudget;
+		static std::atomic<uint> placeholderID;
+		static std::function<void(const std::string&, const TextureStreamTiming&)> loadCallback;
+
+		// the body of the decode threads
+		static void decodeLoop();
+		// create the placeholder and the pixel buffers (render thread)
+		static void createObjects();
+		// copy as many rows of a request as the budget and the free pixel buffer allow, returns false if no buffer is free
+		static bool uploadRows(TextureStreamRequest& request, unsigned long long& budget);
+		// generate the mipmaps of a fully uploaded request, hand the texture to bndr::TextureManager and mark it ready
+		static void completeRequest(TextureStreamRequest& request);
+		// drop the requests that no handle refers to any more and release their textures (the mutex has to be held)
+		static void releaseUnusedRequests();
+
+	public:
+
+		// set the number of decode threads (before the first request, 0 picks one from the number of cores)
+		static inline void setDecodeThreadCount(int count) { decodeThreadCount = count; }
+		// set the bytes uploaded per frame (at least one row of the current texture is always uploaded)
+		static inline void setFrameBudget(unsigned long long bytes) { frameBudget = bytes; }
+		// set the number and the size of the pixel buffers (before the first update)
+		static inline void setPixelBuffers(int count, unsigned long long bytes) { pixelBufferCount = std::max<int>(count, 1); pixelBufferSize = bytes; }
+		// called on the render thread whenever a texture is ready
+		static inline void setLoadCallback(std::function<void(const std::string&, const TextureStreamTiming&)>&& callback) { loadCallback = std::move(callback); }
+		// queue a bitmap file for loading (the same file always returns a handle to the same texture)
+		static TextureHandle request(const char* bitMapFile, uint textureSWrapping = TEXTURE_REPEAT,
+			uint textureTWrapping = TEXTURE_REPEAT, uint textureMinFiltering = TEXTURE_NEAREST,
+			uint textureMagFiltering = TEXTURE_NEAREST);
+		// get the id of the placeholder texture (0 until the first update)
+		static inline uint getPlaceholderID() { return placeholderID.load(); }
+		// get the number of textures that are not ready yet
+		static int getPendingCount();
+		// (render thread, frame boundary) upload decoded rows within the frame budget
+		static void update();
+		// stop the decode threads and free the pixel buffers and the streamed textures (every handle reports TEXTURE_FAILED,
+		// textures still used by a bndr::Texture stay until it is destroyed)
+		static void stop();
+	};
+}
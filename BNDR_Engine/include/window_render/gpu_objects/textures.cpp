@@ -22,96 +22,108 @@ SOFTWARE.*/
 
 #include <pch.h>
 #include "textures.h"
+#include "../../profiling/profiler.h"
 
 namespace bndr {
 
-	// define the static map
-	std::unordered_map<const char*, uint> Texture::textureIDs;
-	// define max texture slots
-	int TextureArray::maxTextureSlots = 0;
-
 	Texture::Texture(const char* bitMapFile, uint textureSWrapping, uint textureTWrapping, uint textureMinFiltering,
 		uint textureMagFiltering) {
 	
-		// if the texture already exists
-		if (Texture::textureIDs.find(bitMapFile) != Texture::textureIDs.end()) {
-
-			BNDR_MESSAGE("texture already exists!\n");
-			// assign the id to the already existing texture and return
-			textureID = Texture::textureIDs[bitMapFile];
-			return;
-		}
-		// otherwise generate it and get the bitmap data
-		glGenTextures(1, &textureID);
-		bind();
+		BNDR_FLIGHT_SCOPE("Texture::Texture");
+		// the manager loads every file once (by its contents, not by the pointer to its name) and counts the references
+		textureID = TextureManager::acquire(bitMapFile, textureSWrapping, textureTWrapping, textureMinFiltering, textureMagFiltering);
+	}
 
-		// how the texture is wrapped on the surface
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureSWrapping);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureTWrapping);
-		// are the texture pixels smooth (TEXTURE_LINEAR) or are they sharp (TEXTURE_NEAREST)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, textureMinFiltering);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, textureMagFiltering);
-
-		// load the bitmap image bits and the width and height
-		BitMapData imageData = Texture::loadBitMap(bitMapFile);
-		uchar* pixelPtr = imageData.ptr.release();
-		// create the 2D image and its respective mipmaps
-		GL_DEBUG_FUNC(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, imageData.width, imageData.height,
-			0, GL_BGR, GL_UNSIGNED_BYTE, pixelPtr));
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// delete the data
-		delete[] pixelPtr;
-
-		// finally add the texture id to the unordered map so we don't load it again next time
-		BNDR_MESSAGE("added new texture!");
-		Texture::textureIDs.insert(std::make_pair(bitMapFile, textureID));
-
-		// unbind the texture before returning
-		unbind();
+	BitMapData Texture::loadBitMap(const char* bitMapFile) {
+
+		BNDR_FLIGHT_SCOPE("Texture::loadBitMap");
+		MappedBitMap bitMap(bitMapFile);
+		BitMapData imageData;
+		imageData.width = bitMap.getWidth();
+		imageData.height = bitMap.getHeight();
+		imageData.bytesPerPixel = bitMap.getBytesPerPixel();
+		imageData.format = bitMap.getGLFormat();
+		imageData.internalFormat = bitMap.getGLInternalFormat();
+		// one copy out of the mapping (the rows of the file already have the padding of getRowBytes())
+		imageData.ptr.reset(new uchar[(size_t)bitMap.getStride() * bitMap.getHeight()]);
+		bitMap.copyBottomUp(imageData.ptr.get());
+		return imageData;
 	}
 
-	TextureArray::TextureArray(std::initializer_list<Texture>&& textureList) {
+	TextureArray::TextureArray(const std::vector<std::string>& bitMapFiles, uint textureSWrapping, uint textureTWrapping,
+		uint textureMinFiltering, uint textureMagFiltering) {
 
-		// check if the max number of texture slots has been queried
-		if (maxTextureSlots == 0) { 
-			
-			glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureSlots);
-			std::string message = "This machine's gpu supports " + std::to_string(maxTextureSlots) + " texture slots";
-			BNDR_MESSAGE(message.c_str());
-		
+		BNDR_FLIGHT_SCOPE("TextureArray::TextureArray");
+		if (bitMapFiles.empty()) {
+
+			BNDR_EXCEPTION("A texture array needs at least one bitmap file");
 		}
-		// start at the first slot
-		uint slot = GL_TEXTURE0;
-		size = textureList.size();
-		textures = new Texture[size];
-		texIDs = new int[size];
-
-		// overwrite each of the texture ids in our array with the values in the initializer list
-		for (int i = 0; i < size; i++) {
-
-			// notice that each texture slot will always be within the max number of slots by using the modulus operator
-			textures[i].overwriteData((textureList.begin() + i)->textureID, slot + (i % maxTextureSlots));
-			texIDs[i] = textures[i].getID();
+		// map and check every file before the texture is created, so a bad file throws without leaking it
+		std::vector<std::unique_ptr<MappedBitMap>> bitMaps;
+		for (const std::string& file : bitMapFiles) {
+
+			bitMaps.emplace_back(new MappedBitMap(file.c_str()));
+			const MappedBitMap& bitMap = *bitMaps.back();
+			if (bitMap.getWidth() != bitMaps[0]->getWidth() || bitMap.getHeight() != bitMaps[0]->getHeight()) {
+
+				std::string message = "The bitmap '" + file + "' is " + std::to_string(bitMap.getWidth()) + "x" +
+					std::to_string(bitMap.getHeight()) + " but the layers of the texture array are " +
+					std::to_string(bitMaps[0]->getWidth()) + "x" + std::to_string(bitMaps[0]->getHeight());
+				BNDR_EXCEPTION(message.c_str());
+			}
 		}
-	}
-
-	void TextureArray::bindAll() {
-	
-		for (int i = 0; i < size; i++) {
+		width = bitMaps[0]->getWidth();
+		height = bitMaps[0]->getHeight();
+		layers = (int)bitMaps.size();
+		glGenTextures(1, &textureID);
+		bind();
 
-			textures[i].bind();
+		// how the layers are wrapped on the surface
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, textureSWrapping);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, textureTWrapping);
+		// are the texture pixels smooth (TEXTURE_LINEAR) or are they sharp (TEXTURE_NEAREST)
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, textureMinFiltering);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, textureMagFiltering);
+		// the storage of every layer is allocated at once (RGBA so 24 and 32 bit files can be mixed)
+		GL_DEBUG_FUNC(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL));
+
+		std::unique_ptr<uchar[]> layerPixels;
+		for (int layer = 0; layer < layers; layer++) {
+
+			const MappedBitMap& bitMap = *bitMaps[layer];
+			const uchar* pixels = bitMap.getPixels();
+			uint format = bitMap.getGLFormat();
+			// the storage has alpha, so 32 bit files without alpha need their unused byte set to opaque
+			bool opaque32 = bitMap.getBitsPerPixel() == 32 && !bitMap.hasAlpha();
+			if (!bitMap.isUploadReady() || opaque32) {
+
+				// top-down rows have to be flipped first, everything else goes to OpenGL straight out of the mapping
+				if (!layerPixels) {
+
+					// (large enough for the rows of either bit depth)
+					layerPixels.reset(new uchar[(size_t)width * 4 * height]);
+				}
+				if (opaque32) {
+
+					bitMap.convertToRGBA(layerPixels.get(), false);
+					format = GL_RGBA;
+				}
+				else {
+
+					bitMap.copyBottomUp(layerPixels.get());
+				}
+				pixels = layerPixels.get();
+			}
+			GL_DEBUG_FUNC(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format,
+				GL_UNSIGNED_BYTE, pixels));
+			RenderStats::addBytesUploaded((unsigned long long)bitMap.getStride() * bitMap.getHeight());
 		}
+		// the mipmaps of every layer are generated separately, a layer never bleeds into its neighbours
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 	}
 
 	TextureArray::~TextureArray() {
 
-		// you'll notice that when we destroy a texture object, the OpenGL texture never gets destroyed. This may seem like
-		// it will cause memory leaks but it won't. With the texture class we ensure that the same texture never gets loaded
-		// into video memory more than once. If we actually deleted the texture from graphics memory every time we destroy
-		// a texture object, then we would have to reload it all over again instead of just getting the texture id insanely
-		// fast. All in all it makes sense to keep the texture in video memory until the program terminates
-		delete[] textures;
-		delete[] texIDs;
+		GLState::deleteTexture(textureID);
 	}
 }
@@ -23,6 +23,8 @@ SOFTWARE.*/
 #pragma once
 #include <pch.h>
 #include "VertexArray.h"
+#include "bitmap_loader.h"
+#include "texture_manager.h"
 
 namespace bndr {
 
@@ -36,128 +38,121 @@ namespace bndr {
 
 	struct BitMapData {
 
-		std::unique_ptr<uchar> ptr;
-		int width;
-		int height;
+		// the rows from the bottom up, every row padded to 4 bytes
+		std::unique_ptr<uchar[]> ptr;
+		int width = 0;
+		int height = 0;
+		// 3 for BGR and 4 for BGRA images
+		int bytesPerPixel = 3;
+		// GL_BGR or GL_BGRA
+		uint format = GL_BGR;
+		// GL_RGB, or GL_RGBA if the image has alpha (32 bit images without alpha are GL_BGRA with an unused fourth byte)
+		uint internalFormat = GL_RGB;
+		// get the bytes of a row including its padding
+		inline int getRowBytes() const { return (width * bytesPerPixel + 3) & ~3; }
 	};
 
-	// forward declare texture array
-	class TextureArray;
-
 	class BNDR_API Texture {
 
-		// the slot the texture goes in (default is 0 but is set automatically when using a TextureArray)
+		// the slot bind() uses (default is 0, see setSlot, surfaces draw the texture on whatever unit GLState::acquireTextureUnit gives it)
 		uint textureSlot = GL_TEXTURE0;
+		// every texture object holds a reference to its id in bndr::TextureManager
 		uint textureID;
-		// store all the texture ids so we do not have any duplicate textures in video memory
-		static std::unordered_map<const char*, uint> textureIDs;
-
-		constexpr void updateTextureSlot(uint slot) { textureSlot = slot; }
 
-		// only the texture array class can use this method (this method takes a temporary Texture object that is about
-		// to go out of scope and transfers its data over to this one)
-		constexpr void overwriteData(uint preexistingID, uint slot) { textureID = preexistingID; textureSlot = slot; }
+		// only the friend classes can use this method (points this texture at an existing texture id and slot, taking a
+		// reference to it and dropping the old one)
+		inline void overwriteData(uint preexistingID, uint slot) {
+			TextureManager::addReference(preexistingID);
+			TextureManager::release(textureID);
+			textureID = preexistingID;
+			textureSlot = slot;
+		}
 
 	public:
 
 		// default constructor
 		Texture() : textureSlot(GL_TEXTURE0), textureID((uint)0) {}
 		// copy constructor
-		Texture(const Texture& tex) : textureSlot(tex.textureSlot), textureID(tex.textureID) {}
-		// move constructor
-		Texture(Texture&& tex) : textureSlot(tex.textureSlot), textureID(tex.textureID) {}
+		Texture(const Texture& tex) : textureSlot(tex.textureSlot), textureID(tex.textureID) { TextureManager::addReference(textureID); }
+		// move constructor (takes over the reference)
+		Texture(Texture&& tex) noexcept : textureSlot(tex.textureSlot), textureID(tex.textureID) { tex.textureID = 0; }
 		// assignment operator
 		Texture& operator=(const Texture& tex) {
+			TextureManager::addReference(tex.textureID);
+			TextureManager::release(textureID);
 			textureSlot = tex.textureSlot;
 			textureID = tex.textureID;
 			return *this;
 		}
+		// load a bitmap file or a preprocessed .btex texture container (see bndr::TextureConverter)
 		Texture(const char* bitMapFile, uint textureSWrapping = TEXTURE_REPEAT,
 			uint textureTWrapping = TEXTURE_REPEAT, uint textureMinFiltering = TEXTURE_NEAREST,
 			uint textureMagFiltering = TEXTURE_NEAREST);
 		// bind the texture
-		inline void bind() { glActiveTexture(textureSlot); GL_DEBUG_FUNC(glBindTexture(GL_TEXTURE_2D, textureID)); }
+		inline void bind() { GLState::bindTexture(textureSlot, textureID); }
 		// unbind the texture
-		inline void unbind() { GL_DEBUG_FUNC(glBindTexture(GL_TEXTURE_2D, 0)); }
+		inline void unbind() { GLState::bindTexture(textureSlot, 0); }
 		// get the id of the texture
 		inline int getID() { return (int)textureID; }
 		// get the slot of the texture
 		inline int getSlot() { return (int)textureSlot; }
-		// load a bitmap file into memory
-		static BitMapData loadBitMap(const char* bitMapFile) {
-
-			std::ifstream bitMapBuffer(bitMapFile, std::ios::in | std::ios::binary);
-			// check if the file opened successfully
-			if (!bitMapBuffer.is_open()) {
-
-				std::string message = "Failed to open bit map file " + std::string("'") + std::string(bitMapFile) + std::string("'");
-				BNDR_EXCEPTION(message.c_str());
-			}
-			// read the header of the bitmap
-			uchar header[54];
-			bitMapBuffer.read(static_cast<char*>(static_cast<void*>(&header[0])), 54);
-
-			// check if the bitmap file starts with B and M
-			if (header[0] != (uchar)'B' || header[1] != (uchar)'M') {
-
-				std::string message = "The bitmap file " + std::string("'") + std::string(bitMapFile) + std::string("'") + " has an invalid file format";
-				BNDR_EXCEPTION(message.c_str());
-			}
-			// get the image size, width, and height
-			int size = *(int*)&header[0x22];
-			int width = *(int*)&header[0x12];
-			int height = *(int*)&header[0x16];
-
-			// if the size is missing then fill it in
-			if (size == 0) { size = width * height * 3; }
-			// if either the width or height is 0 raise an error
-			if (width == 0 || height == 0) { BNDR_EXCEPTION("Cannot read from a bitmap with a dimension of 0 pixels"); }
-
-			// create buffer for the image data
-			std::unique_ptr<uchar> imageData(new uchar[size]);
-			// now read the remaining image data
-			bitMapBuffer.read(static_cast<char*>(static_cast<void*>(imageData.get())), size);
-			bitMapBuffer.close();
-			return { std::move(imageData), width, height };
-
-		}
-		// texture array has access to the private method updateTextureSlot
-		friend class TextureArray;
+		// set the slot bind() uses, as its GL_TEXTUREi enum (for programs that sample more than one texture, e.g. the
+		// "tex1" and "tex2" samplers of Program::texPolygonProgram(2) and (3), point the sampler at the same unit)
+		inline void setSlot(uint slot) { textureSlot = slot; }
+		// bind the texture to a unit picked by GLState::acquireTextureUnit and return the unit index for a sampler uniform
+		// (the texture stays on it until the allocator needs the unit for another one)
+		inline int bindToFreeUnit() { return GLState::acquireTextureUnit(textureID); }
+		// load a bitmap file into memory (bottom-up rows padded to 4 bytes, ready for glTexImage2D)
+		static BitMapData loadBitMap(const char* bitMapFile);
+		// drops the reference (the texture is deleted once it is unreferenced and its memory is needed)
+		~Texture() { TextureManager::release(textureID); }
+		// texture atlas wraps the textures of its pages
+		friend class TextureAtlas;
+		// texture handles wrap streamed textures and their placeholder
+		friend class TextureHandle;
 	};
 
 	// bndr::TextureArray
-	// Description: This class is a system dependent texture container. It is system dependent because depending on your
-	// gpu, you have x number of textures that can be bound at one time. The advantage of using a texture array is that it
-	// is much faster that a regular texture. This is because each instance of the texture class always uses the same texture
-	// slot, while texture array can have 8, 16, or even 32 textures bound at once depending on your gpu.
+	// Description: Bitmaps of the same size uploaded as the layers of one GL_TEXTURE_2D_ARRAY texture. The whole array is
+	// bound to a single texture unit and the shader picks the layer from a per vertex index (see SHADER_TEXTURE_ARRAY),
+	// so every frame of an animation or every sprite of a cast is drawn with one bind and one draw call (see bndr::SpriteBatch).
+	// The array owns its texture, the files are not shared with bndr::TextureManager
 	class BNDR_API TextureArray {
 
-		// texture array
-		Texture* textures = nullptr;
-		// array of ids
-		int* texIDs = nullptr;
-		// size of the array
-		int size;
-		// gpu-dependent (some gpus have more texture slots than others)
-		static int maxTextureSlots;
+		uint textureID = 0;
+		// the slot bind() uses (surfaces draw the array on whatever unit GLState::acquireTextureArrayUnit gives it)
+		uint textureSlot = GL_TEXTURE0;
+		// the size of every layer
+		int width = 0;
+		int height = 0;
+		int layers = 0;
 
 	public:
 
-		TextureArray(std::initializer_list<Texture>&& textureList);
-		// bind all textures
-		void bindAll();
-		// unbind all textures
-		inline void unbindAll() { glBindTexture(GL_TEXTURE_2D, 0); }
-		// bind a specific texture
-		inline void bindAt(int index) { textures[index].bind(); }
-		// get the id at a specific index
-		inline int getIDAt(int index) { return textures[index].getID(); }
-		// get the slot at a specific index
-		inline int getSlotAt(int index) { return textures[index].getSlot(); }
-		// get the number of textures contained
-		inline int getSize() { return size; }
-		// returns the texture ids pointer
-		inline const int* getIDs() { return texIDs; }
+		// load every bitmap file into a layer, in order (throws if a file is bad or not the size of the first one)
+		TextureArray(const std::vector<std::string>& bitMapFiles, uint textureSWrapping = TEXTURE_REPEAT,
+			uint textureTWrapping = TEXTURE_REPEAT, uint textureMinFiltering = TEXTURE_NEAREST,
+			uint textureMagFiltering = TEXTURE_NEAREST);
+		TextureArray(const TextureArray&) = delete;
+		TextureArray& operator=(const TextureArray&) = delete;
+		// bind the array
+		inline void bind() const { GLState::bindTextureArray(textureSlot, textureID); }
+		// unbind the array
+		inline void unbind() const { GLState::bindTextureArray(textureSlot, 0); }
+		// get the id of the texture
+		inline int getID() const { return (int)textureID; }
+		// get the slot of the texture
+		inline int getSlot() const { return (int)textureSlot; }
+		// set the slot bind() uses, as its GL_TEXTUREi enum
+		inline void setSlot(uint slot) { textureSlot = slot; }
+		// bind the array to a unit picked by GLState::acquireTextureArrayUnit and return the unit index for a sampler uniform
+		inline int bindToFreeUnit() const { return GLState::acquireTextureArrayUnit(textureID); }
+		// get the number of layers
+		inline int getLayerCount() const { return layers; }
+		// get the size of a layer
+		inline int getWidth() const { return width; }
+		inline int getHeight() const { return height; }
+		// deletes the texture
 		~TextureArray();
 	};
 
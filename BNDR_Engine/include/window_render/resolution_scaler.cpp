@@ -0,0 +1,199 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include <pch.h>
+#include "resolution_scaler.h"
+
+namespace bndr {
+
+	// measurements above this fraction of the target frame time count as over budget
+	static const float OVER_BUDGET_RATIO = 1.0f;
+	// measurements below this fraction of the target frame time count as under budget
+	static const float UNDER_BUDGET_RATIO = 0.75f;
+	// consecutive over budget measurements before the scale drops (react quickly to hitches)
+	static const int FRAMES_BEFORE_DECREASE = 3;
+	// consecutive under budget measurements before the scale rises (recover slowly so the scale does not oscillate)
+	static const int FRAMES_BEFORE_INCREASE = 30;
+	// the largest change of the scale in a single adjustment
+	static const float MAX_DECREASE_STEP = 0.1f;
+	static const float MAX_INCREASE_STEP = 0.05f;
+	// weight of a new measurement in the smoothed gpu frame time
+	static const float SMOOTHING = 0.2f;
+
+	ResolutionScaler::ResolutionScaler(Window* windowInstance, float frameTime, float minimumScale, float maximumScale)
+		: window(windowInstance), scale(1.0f), targetFrameTime(frameTime) {
+
+		setScaleRange(minimumScale, maximumScale);
+		scale = maxScale;
+		GL_DEBUG_FUNC(glGenQueries(QUERY_COUNT, queries));
+		for (int i = 0; i < QUERY_COUNT; i++) {
+
+			queryPending[i] = false;
+		}
+	}
+
+	void ResolutionScaler::setScaleRange(float minimumScale, float maximumScale) {
+
+		// keep the bounds sane (a scale above 1.0 would need a target larger than the window)
+		minScale = std::min<float>(std::max<float>(minimumScale, 0.1f), 1.0f);
+		maxScale = std::min<float>(std::max<float>(maximumScale, minScale), 1.0f);
+		scale = std::min<float>(std::max<float>(scale, minScale), maxScale);
+	}
+
+	void ResolutionScaler::setEnabled(bool enable) {
+
+		enabled = enable;
+		// start from full resolution again when re-enabled
+		scale = maxScale;
+		framesOverBudget = 0;
+		framesUnderBudget = 0;
+	}
+
+	void ResolutionScaler::collectQueryResults() {
+
+		for (int i = 0; i < QUERY_COUNT; i++) {
+
+			if (!queryPending[i] || i == activeQuery) {
+
+				continue;
+			}
+			int available = 0;
+			glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available) {
+
+				GLuint64 nanoseconds = 0;
+				glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+				queryPending[i] = false;
+				addMeasurement((float)nanoseconds * 0.000000001f);
+			}
+		}
+	}
+
+	void ResolutionScaler::addMeasurement(float seconds) {
+
+		gpuFrameTime = (gpuFrameTime == 0.0f) ? seconds : gpuFrameTime + (seconds - gpuFrameTime) * SMOOTHING;
+		if (!enabled) {
+
+			return;
+		}
+
+		if (gpuFrameTime > targetFrameTime * OVER_BUDGET_RATIO) {
+
+			framesOverBudget++;
+			framesUnderBudget = 0;
+		}
+		else if (gpuFrameTime < targetFrameTime * UNDER_BUDGET_RATIO) {
+
+			framesUnderBudget++;
+			framesOverBudget = 0;
+		}
+		// inside the dead band nothing changes
+		else {
+
+			framesOverBudget = 0;
+			framesUnderBudget = 0;
+		}
+
+		if (framesOverBudget >= FRAMES_BEFORE_DECREASE || framesUnderBudget >= FRAMES_BEFORE_INCREASE) {
+
+			// the fill cost grows with the pixel count (the square of the scale) so aim for the scale that would
+			// put the frame in the middle of the dead band
+			float desired = scale * sqrtf((targetFrameTime * (OVER_BUDGET_RATIO + UNDER_BUDGET_RATIO) * 0.5f) / gpuFrameTime);
+			desired = std::min<float>(std::max<float>(desired, scale - MAX_DECREASE_STEP), scale + MAX_INCREASE_STEP);
+			scale = std::min<float>(std::max<float>(desired, minScale), maxScale);
+			framesOverBudget = 0;
+			framesUnderBudget = 0;
+		}
+	}
+
+	void ResolutionScaler::beginFrame() {
+
+		collectQueryResults();
+
+		std::pair<float, float> size = window->getFramebufferSize();
+		windowWidth = (int)size.first;
+		windowHeight = (int)size.second;
+		// a minimized window has no pixels to render to
+		if (windowWidth <= 0 || windowHeight <= 0) {
+
+			renderingOffscreen = false;
+			activeQuery = -1;
+			return;
+		}
+
+		float frameScale = enabled ? scale : 1.0f;
+		sceneWidth = std::max<int>((int)(windowWidth * frameScale + 0.5f), 1);
+		sceneHeight = std::max<int>((int)(windowHeight * frameScale + 0.5f), 1);
+		// at full resolution we render straight to the window and skip the upscale copy entirely
+		renderingOffscreen = sceneWidth != windowWidth || sceneHeight != windowHeight;
+
+		if (renderingOffscreen) {
+
+			if (target == nullptr) {
+
+				target = new FrameBuffer(windowWidth, windowHeight);
+			}
+			else {
+
+				target->resize(windowWidth, windowHeight);
+			}
+			target->bind();
+			glViewport(0, 0, sceneWidth, sceneHeight);
+		}
+
+		// time the frame unless the gpu is so far behind that the next query is still in flight
+		if (!queryPending[nextQuery]) {
+
+			activeQuery = nextQuery;
+			nextQuery = (nextQuery + 1) % QUERY_COUNT;
+			glBeginQuery(GL_TIME_ELAPSED, queries[activeQuery]);
+		}
+		else {
+
+			activeQuery = -1;
+		}
+	}
+
+	void ResolutionScaler::endFrame() {
+
+		if (renderingOffscreen) {
+
+			target->blitToScreen(sceneWidth, sceneHeight, windowWidth, windowHeight);
+			glViewport(0, 0, windowWidth, windowHeight);
+		}
+		if (activeQuery != -1) {
+
+			glEndQuery(GL_TIME_ELAPSED);
+			queryPending[activeQuery] = true;
+			activeQuery = -1;
+		}
+	}
+
+	ResolutionScaler::~ResolutionScaler() {
+
+		glDeleteQueries(QUERY_COUNT, queries);
+		if (target != nullptr) {
+
+			delete target;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+/*MIT License
+
+Copyright (c) 2021 Caleb Christopher Bender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <pch.h>
+#include "window.h"
+#include "gpu_objects/FrameBuffer.h"
+
+namespace bndr {
+
+	// bndr::ResolutionScaler
+	// Description: Optional controller for dynamic resolution scaling. Everything rendered between beginFrame() and endFrame()
+	// goes into an offscreen target whose resolution is a fraction (the scale) of the window's resolution, and endFrame()
+	// upscales the result to the window. The scale is adjusted with hysteresis from the measured GPU frame time, so fill-rate
+	// spikes (i.e. large alpha blended TexturedRects) cost a little sharpness instead of dropped frames.
+	// Usage:
+	//        scaler.beginFrame();
+	//        window.clear();
+	//        ... render surfaces ...
+	//        scaler.endFrame();
+	class BNDR_API ResolutionScaler {
+
+		// the window that the scene is upscaled to
+		Window* window;
+		// the offscreen target (allocated at full window resolution so that changing the scale never reallocates it)
+		FrameBuffer* target = nullptr;
+		// GL_TIME_ELAPSED queries for the last few frames so that reading a result never stalls the cpu
+		static const int QUERY_COUNT = 4;
+		uint queries[QUERY_COUNT];
+		bool queryPending[QUERY_COUNT];
+		// the query used by the current frame (-1 if the current frame is not being timed)
+		int activeQuery = -1;
+		// the query that the next frame will use
+		int nextQuery = 0;
+		// the current scale and its bounds (fractions of the window resolution per axis)
+		float scale;
+		float minScale;
+		float maxScale;
+		// the gpu frame time in seconds we try to stay within
+		float targetFrameTime;
+		// smoothed gpu frame time in seconds (0.0f until the first measurement arrives)
+		float gpuFrameTime = 0.0f;
+		// hysteresis counters: the scale only moves after several consecutive measurements agree
+		int framesOverBudget = 0;
+		int framesUnderBudget = 0;
+		// whether the controller is active
+		bool enabled = true;
+		// whether the current frame renders into the offscreen target (at full scale we render straight to the window)
+		bool renderingOffscreen = false;
+		// sizes in pixels of the scene and the window for the current frame
+		int sceneWidth = 0;
+		int sceneHeight = 0;
+		int windowWidth = 0;
+		int windowHeight = 0;
+
+		// read back every finished timer query without waiting on the ones that are not finished
+		void collectQueryResults();
+		// feed a new gpu time measurement into the controller
+		void addMeasurement(float seconds);
+
+	public:
+
+		// bndr::ResolutionScaler::ResolutionScaler
+		// Arguments:
+		//        windowInstance = The window the scene is upscaled to
+		//        targetFrameTime = The gpu time in seconds a frame should stay within (default is 60 fps)
+		//        minimumScale = The lowest allowed fraction of the window resolution
+		//        maximumScale = The highest allowed fraction of the window resolution
+		// Description: Creates the timer queries used to measure the gpu frame time. The offscreen target is created
+		// the first time the scale drops below 1.0
+		ResolutionScaler(Window* windowInstance, float targetFrameTime = 1.0f / 60.0f, float minimumScale = 0.5f, float maximumScale = 1.0f);
+		ResolutionScaler(const ResolutionScaler&) = delete;
+		ResolutionScaler(ResolutionScaler&&) = delete;
+		ResolutionScaler& operator=(const ResolutionScaler&) = delete;
+		// start a frame: adjusts the scale from the finished measurements and binds the (scaled) render target
+		void beginFrame();
+		// end a frame: upscales the scene to the window and restores the window viewport
+		void endFrame();
+		// enable or disable the controller (a disabled controller renders straight to the window at full resolution)
+		void setEnabled(bool enable);
+		// check if the controller is enabled
+		inline bool isEnabled() const { return enabled; }
+		// set the gpu time in seconds a frame should stay within
+		inline void setTargetFrameTime(float seconds) { targetFrameTime = seconds; }
+		// set the allowed range of the scale
+		void setScaleRange(float minimumScale, float maximumScale);
+		// get the current scale (fraction of the window resolution per axis)
+		inline float getScale() const { return scale; }
+		// get the smoothed gpu frame time in seconds
+		inline float getGPUFrameTime() const { return gpuFrameTime; }
+		// bndr::ResolutionScaler::~ResolutionScaler
+		// Description: Deletes the timer queries and the offscreen target
+		~ResolutionScaler();
+	};
+}
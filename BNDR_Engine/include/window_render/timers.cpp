@@ -28,19 +28,490 @@ namespace bndr {
 	float Clock::deltaTime() {
 
 		end = Clock::now();
-		float deltaTime = ((end - start).count())*0.000000001f;
+		float deltaTime = duration(end - start).count();
 		start = end;
 		return deltaTime;
 	}
 
+	TimerService::TimerService(float tickSeconds) : tickLength(tickSeconds) {
+
+		if (tickLength <= 0.0f) {
+
+			BNDR_EXCEPTION("The tick length of a TimerService must be greater than 0");
+		}
+		for (int& head : slots) {
+
+			head = -1;
+		}
+	}
+
+	TimerService::~TimerService() {
+
+		// the handles would otherwise cancel their nodes in a service that no longer exists
+		for (TimerNode& node : nodes) {
+
+			if (node.active && node.owner != nullptr) {
+
+				node.owner->service = nullptr;
+			}
+		}
+	}
+
+	TimerService::tick TimerService::toTicks(float seconds) const {
+
+		// round to the nearest tick but never fire on the tick the timer was scheduled on
+		float ticks = seconds / tickLength + 0.5f;
+		return (ticks < 1.0f) ? 1 : (tick)ticks;
+	}
+
+	TimerService::TimerNode* TimerService::getNode(TimerID id) {
+
+		if (id.index >= (uint)nodes.size() || nodes[id.index].generation != id.generation || !nodes[id.index].active) {
+
+			return nullptr;
+		}
+		return &nodes[id.index];
+	}
+
+	const TimerService::TimerNode* TimerService::getNode(TimerID id) const {
+
+		if (id.index >= (uint)nodes.size() || nodes[id.index].generation != id.generation || !nodes[id.index].active) {
+
+			return nullptr;
+		}
+		return &nodes[id.index];
+	}
+
+	TimerID TimerService::addTimer(float delay, bool repeat, std::function<void()>&& callback, int mode) {
+
+		// reuse a released node if there is one
+		int index;
+		if (!freeNodes.empty()) {
+
+			index = freeNodes.back();
+			freeNodes.pop_back();
+		}
+		else {
+
+			index = (int)nodes.size();
+			nodes.emplace_back();
+		}
+		TimerNode& node = nodes[index];
+		tick ticks = toTicks(delay);
+		node.expiry = currentTick + ticks;
+		node.interval = repeat ? ticks : 0;
+		node.callback = std::move(callback);
+		node.firedCount = 0;
+		node.owner = nullptr;
+		node.mode = mode;
+		node.active = true;
+		node.spent = false;
+		activeCount++;
+		link(index);
+
+		TimerID id;
+		id.index = (uint)index;
+		id.generation = node.generation;
+		return id;
+	}
+
+	void TimerService::link(int index) {
+
+		TimerNode& node = nodes[index];
+		tick delta = node.expiry - currentTick;
+		// timers further away than the wheel covers wait in the last slot of the top level and are placed again when it cascades
+		tick expiry = (delta < MAX_RANGE) ? node.expiry : currentTick + MAX_RANGE - 1;
+		if (delta >= MAX_RANGE) {
+
+			delta = MAX_RANGE - 1;
+		}
+
+		int slot;
+		if (delta < LEVEL0_SIZE) {
+
+			slot = (int)(expiry & (LEVEL0_SIZE - 1));
+		}
+		else {
+
+			// find the lowest level whose range covers the delta
+			int level = 0;
+			int shift = LEVEL0_BITS;
+			while (level < UPPER_LEVELS - 1 && delta >= ((tick)1 << (shift + LEVEL_BITS))) {
+
+				level++;
+				shift += LEVEL_BITS;
+			}
+			slot = LEVEL0_SIZE + level * LEVEL_SIZE + (int)((expiry >> shift) & (LEVEL_SIZE - 1));
+		}
+
+		// push the node to the front of the slot list
+		node.slot = slot;
+		node.prev = -1;
+		node.next = slots[slot];
+		if (node.next != -1) {
+
+			nodes[node.next].prev = index;
+		}
+		slots[slot] = index;
+	}
+
+	void TimerService::unlink(int index) {
+
+		TimerNode& node = nodes[index];
+		if (node.slot == -1) {
+
+			return;
+		}
+		if (node.prev != -1) {
+
+			nodes[node.prev].next = node.next;
+		}
+		else {
+
+			slots[node.slot] = node.next;
+		}
+		if (node.next != -1) {
+
+			nodes[node.next].prev = node.prev;
+		}
+		node.prev = -1;
+		node.next = -1;
+		node.slot = -1;
+	}
+
+	void TimerService::release(int index) {
+
+		TimerNode& node = nodes[index];
+		// (a spent node was already taken off the count when it fired)
+		if (node.active && !node.spent) {
+
+			activeCount--;
+		}
+		node.active = false;
+		node.spent = false;
+		node.owner = nullptr;
+		// stale ids no longer match the node
+		node.generation++;
+		node.callback = nullptr;
+		freeNodes.push_back(index);
+	}
+
+	TimerID TimerService::schedule(float delay, std::function<void()>&& callback, bool repeat) {
+
+		return addTimer(delay, repeat, std::move(callback), FIRE_CALLBACK);
+	}
+
+	TimerID TimerService::schedule(float delay, bool repeat) {
+
+		return addTimer(delay, repeat, nullptr, FIRE_QUEUE);
+	}
+
+	bool TimerService::cancel(TimerID id) {
+
+		TimerNode* node = getNode(id);
+		if (node == nullptr) {
+
+			return false;
+		}
+		unlink((int)id.index);
+		if ((int)id.index == firingNode) {
+
+			// the callback of this timer is running, so the node is released after it returns
+			node->active = false;
+			activeCount--;
+			firingCancelled = true;
+			return true;
+		}
+		release((int)id.index);
+		return true;
+	}
+
+	bool TimerService::reschedule(TimerID id, float delay) {
+
+		TimerNode* node = getNode(id);
+		if (node == nullptr) {
+
+			return false;
+		}
+		unlink((int)id.index);
+		tick ticks = toTicks(delay);
+		node->expiry = currentTick + ticks;
+		if (node->interval != 0) {
+
+			node->interval = ticks;
+		}
+		node->firedCount = 0;
+		// a spent one shot timer is scheduled again
+		if (node->spent) {
+
+			node->spent = false;
+			activeCount++;
+		}
+		link((int)id.index);
+		return true;
+	}
+
+	bool TimerService::isActive(TimerID id) const {
+
+		const TimerNode* node = getNode(id);
+		return node != nullptr && node->slot != -1;
+	}
+
+	float TimerService::getRemainingTime(TimerID id) const {
+
+		const TimerNode* node = getNode(id);
+		if (node == nullptr || node->slot == -1) {
+
+			return 0.0f;
+		}
+		float remaining = (float)(node->expiry - currentTick) * tickLength - accumulatedTime;
+		return (remaining < 0.0f) ? 0.0f : remaining;
+	}
+
+	void TimerService::cascade(int slotIndex) {
+
+		// detach the list first since relinking may put nodes back into lower levels only
+		int index = slots[slotIndex];
+		slots[slotIndex] = -1;
+		while (index != -1) {
+
+			int next = nodes[index].next;
+			nodes[index].slot = -1;
+			link(index);
+			index = next;
+		}
+	}
+
+	void TimerService::fire(int index) {
+
+		TimerNode& node = nodes[index];
+		TimerID id;
+		id.index = (uint)index;
+		id.generation = node.generation;
+
+		// repeating timers go back into the wheel before the callback runs so the callback may cancel or reschedule them
+		if (node.interval != 0) {
+
+			node.expiry += node.interval;
+			link(index);
+		}
+
+		if (node.mode == FIRE_CALLBACK) {
+
+			firingNode = index;
+			firingCancelled = false;
+			node.callback();
+			firingNode = -1;
+			// the callback may have grown the pool, but the deque keeps the node where it is
+			if (firingCancelled) {
+
+				release(index);
+				return;
+			}
+		}
+		else if (node.mode == FIRE_QUEUE) {
+
+			fired.push_back(id);
+		}
+		else {
+
+			node.firedCount++;
+			// a one shot timer stays in the pool until its handle goes away, but it is no longer scheduled
+			if (node.interval == 0) {
+
+				node.spent = true;
+				activeCount--;
+			}
+		}
+
+		// one shot timers are done (bndr::Timer keeps its node until the handle goes away so the firing can be polled)
+		if (nodes[index].interval == 0 && nodes[index].mode != FIRE_COUNT && nodes[index].active && nodes[index].slot == -1) {
+
+			release(index);
+		}
+	}
+
+	void TimerService::processTick() {
+
+		currentTick++;
+		// whenever a level wraps around, the next slot of the level above is spread over the levels below
+		int level0Index = (int)(currentTick & (LEVEL0_SIZE - 1));
+		if (level0Index == 0) {
+
+			int shift = LEVEL0_BITS;
+			for (int level = 0; level < UPPER_LEVELS; level++) {
+
+				int levelIndex = (int)((currentTick >> shift) & (LEVEL_SIZE - 1));
+				cascade(LEVEL0_SIZE + level * LEVEL_SIZE + levelIndex);
+				if (levelIndex != 0) {
+
+					break;
+				}
+				shift += LEVEL_BITS;
+			}
+		}
+
+		// fire everything in the current slot (one at a time since callbacks may cancel other timers in the slot)
+		while (slots[level0Index] != -1) {
+
+			int index = slots[level0Index];
+			unlink(index);
+			fire(index);
+		}
+	}
+
+	void TimerService::advance(float deltaTime) {
+
+		accumulatedTime += deltaTime;
+		if (accumulatedTime < tickLength) {
+
+			return;
+		}
+		tick ticks = (tick)(accumulatedTime / tickLength);
+		accumulatedTime -= (float)ticks * tickLength;
+		if (accumulatedTime < 0.0f) {
+
+			accumulatedTime = 0.0f;
+		}
+		// with nothing scheduled there is nothing to cascade or fire
+		if (activeCount == 0) {
+
+			currentTick += ticks;
+			return;
+		}
+		for (tick i = 0; i < ticks; i++) {
+
+			processTick();
+		}
+	}
+
+	void TimerService::drainFired(const std::function<void(TimerID)>& handler) {
+
+		// swap first so that the handler can schedule timers that fire into a fresh queue
+		drainingFired.swap(fired);
+		for (const TimerID& id : drainingFired) {
+
+			handler(id);
+		}
+		drainingFired.clear();
+	}
+
+	Timer::Timer(TimerService& timerService, float interval, bool repeat)
+		: Clock(), timeInterval(interval), elapsedTime(interval), service(&timerService) {
+
+		id = service->addTimer(interval, repeat, nullptr, TimerService::FIRE_COUNT);
+		claimNode();
+	}
+
+	void Timer::claimNode() {
+
+		TimerService::TimerNode* node = (service != nullptr) ? service->getNode(id) : nullptr;
+		if (node != nullptr) {
+
+			node->owner = this;
+		}
+	}
+
+	void Timer::copyFrom(const Timer& timer) {
+
+		timeInterval = timer.timeInterval;
+		elapsedTime = timer.elapsedTime;
+		service = timer.service;
+		id = TimerID();
+		// (a copy of a stale timer is stale as well)
+		if (service != nullptr && service->getNode(timer.id) != nullptr) {
+
+			id = service->addTimer(timeInterval, false, nullptr, TimerService::FIRE_COUNT);
+			// the new node continues where the original is, with the same expiry and the firings it has not consumed
+			// (the pool is a deque, so adding the node did not move the original)
+			const TimerService::TimerNode& source = *service->getNode(timer.id);
+			TimerService::TimerNode& copy = service->nodes[id.index];
+			service->unlink((int)id.index);
+			copy.expiry = source.expiry;
+			copy.interval = source.interval;
+			copy.firedCount = source.firedCount;
+			// a one shot timer that already fired is no longer in the wheel
+			if (source.spent) {
+
+				copy.spent = true;
+				service->activeCount--;
+			}
+			else {
+
+				service->link((int)id.index);
+			}
+			copy.owner = this;
+		}
+	}
+
+	Timer::Timer(const Timer& timer) : Clock(timer) {
+
+		copyFrom(timer);
+	}
+
+	Timer& Timer::operator=(const Timer& timer) {
+
+		if (this != &timer) {
+
+			if (service != nullptr) {
+
+				service->cancel(id);
+			}
+			Clock::operator=(timer);
+			copyFrom(timer);
+		}
+		return *this;
+	}
+
+	Timer::Timer(Timer&& timer) noexcept
+		: Clock(timer), timeInterval(timer.timeInterval), elapsedTime(timer.elapsedTime), service(timer.service), id(timer.id) {
+
+		timer.service = nullptr;
+		claimNode();
+	}
+
+	Timer& Timer::operator=(Timer&& timer) noexcept {
+
+		if (this != &timer) {
+
+			if (service != nullptr) {
+
+				service->cancel(id);
+			}
+			timeInterval = timer.timeInterval;
+			elapsedTime = timer.elapsedTime;
+			service = timer.service;
+			id = timer.id;
+			timer.service = nullptr;
+			claimNode();
+		}
+		return *this;
+	}
+
 	void Timer::countDown(float deltaTime) {
 
+		// timers in a service are advanced by TimerService::advance
+		if (service != nullptr) {
+
+			return;
+		}
 		// advance the timer by the passed time
 		elapsedTime -= deltaTime;
 	}
 
 	bool Timer::timesUp() {
 
+		// consume one firing of the timer in the service
+		if (service != nullptr) {
+
+			TimerService::TimerNode* node = service->getNode(id);
+			if (node == nullptr || node->firedCount == 0) {
+
+				return false;
+			}
+			node->firedCount--;
+			return true;
+		}
 		// check if the timer has reached 0 and if so reset the elapsed time to the time interval
 		if (elapsedTime <= 0.0f) {
 
@@ -58,6 +529,18 @@ namespace bndr {
 			timeInterval = newInterval;
 			// start over the timer
 			elapsedTime = timeInterval;
+			if (service != nullptr) {
+
+				service->reschedule(id, timeInterval);
+			}
+		}
+	}
+
+	Timer::~Timer() {
+
+		if (service != nullptr) {
+
+			service->cancel(id);
 		}
 	}
 }
@@ -35,7 +35,7 @@ namespace bndr {
 		timePoint start;
 		// end of clock
 		timePoint end;
-		static timePoint now() { return std::chrono::high_resolution_clock::now(); }
+		static timePoint now() { return std::chrono::steady_clock::now(); }
 
 	public:
 
@@ -45,25 +45,194 @@ namespace bndr {
 
 	};
 
+	// identifies a timer scheduled in a bndr::TimerService (the generation makes ids of cancelled or finished timers stale)
+	struct TimerID {
+
+		uint index = 0xFFFFFFFF;
+		uint generation = 0;
+		inline bool isValid() const { return index != 0xFFFFFFFF; }
+		inline bool operator==(const TimerID& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const TimerID& other) const { return !(*this == other); }
+	};
+
+	// bndr::TimerService
+	// Description: Schedules thousands of timers with a hierarchical timing wheel. Scheduling and cancelling are O(1) and
+	// advance() only touches the slots that are due, so timers that are not firing cost nothing per frame.
+	// A timer either runs a callback when it fires, or (if it has no callback) its id is queued until drainFired() is called.
+	// The wheel has 4 levels: 256 slots of one tick, then 3 levels of 64 slots each covering 64 times the range of the level
+	// below, so at the default 1ms tick timers up to ~18.6 hours are placed directly (longer ones are re-cascaded)
+	class Timer;
+
+	class BNDR_API TimerService {
+
+		using tick = unsigned long long;
+
+		static const int LEVEL0_BITS = 8;
+		static const int LEVEL_BITS = 6;
+		static const int LEVEL0_SIZE = 1 << LEVEL0_BITS;
+		static const int LEVEL_SIZE = 1 << LEVEL_BITS;
+		static const int UPPER_LEVELS = 3;
+		// the furthest a timer can be placed from the current tick
+		static const tick MAX_RANGE = (tick)1 << (LEVEL0_BITS + LEVEL_BITS * UPPER_LEVELS);
+
+		enum fireModes {
+
+			// run the callback
+			FIRE_CALLBACK,
+			// push the id into the fired queue
+			FIRE_QUEUE,
+			// only count the firing (used by bndr::Timer which polls the count)
+			FIRE_COUNT
+		};
+
+		struct TimerNode {
+
+			// the tick the timer fires on
+			tick expiry = 0;
+			// the period in ticks of a repeating timer (0 for one shot timers)
+			tick interval = 0;
+			std::function<void()> callback;
+			// intrusive links of the slot list the node is in
+			int prev = -1;
+			int next = -1;
+			// the slot list the node is in (-1 if it is not in the wheel)
+			int slot = -1;
+			uint generation = 0;
+			// the number of firings bndr::Timer has not consumed yet
+			uint firedCount = 0;
+			// the handle of a FIRE_COUNT node (detached when the service is destroyed)
+			Timer* owner = nullptr;
+			int mode = FIRE_CALLBACK;
+			bool active = false;
+			// a one shot FIRE_COUNT node that fired and is only kept so the firing can be polled (not counted as active)
+			bool spent = false;
+		};
+
+		// the length of one tick in seconds
+		float tickLength;
+		// time that has not added up to a full tick yet
+		float accumulatedTime = 0.0f;
+		// the last tick that was processed
+		tick currentTick = 0;
+		// heads of the slot lists (level 0 first, then the 64 slots of each upper level)
+		int slots[LEVEL0_SIZE + LEVEL_SIZE * UPPER_LEVELS];
+		// the node pool (a deque so that a running callback is never moved when the pool grows)
+		std::deque<TimerNode> nodes;
+		std::vector<int> freeNodes;
+		int activeCount = 0;
+		// ids of the fired timers that have no callback
+		std::vector<TimerID> fired;
+		std::vector<TimerID> drainingFired;
+		// the node whose callback is running and whether it was cancelled from inside the callback
+		int firingNode = -1;
+		bool firingCancelled = false;
+
+		// convert seconds to a number of ticks (at least one)
+		tick toTicks(float seconds) const;
+		// get the node of an id (nullptr if the id is stale)
+		TimerNode* getNode(TimerID id);
+		const TimerNode* getNode(TimerID id) const;
+		// add a timer to the pool and the wheel
+		TimerID addTimer(float delay, bool repeat, std::function<void()>&& callback, int mode);
+		// put a node in the slot that matches its expiry
+		void link(int index);
+		// take a node out of its slot
+		void unlink(int index);
+		// return a node to the pool
+		void release(int index);
+		// move every node of an upper level slot to the level below
+		void cascade(int slotIndex);
+		// process a single tick
+		void processTick();
+		// fire one node
+		void fire(int index);
+
+		friend class Timer;
+
+	public:
+
+		// bndr::TimerService::TimerService
+		// Arguments:
+		//        tickSeconds = The resolution of the timers in seconds (1ms by default)
+		// Description: Creates an empty timing wheel
+		TimerService(float tickSeconds = 0.001f);
+		TimerService(const TimerService&) = delete;
+		TimerService& operator=(const TimerService&) = delete;
+		// bndr::TimerService::~TimerService
+		// Description: Detaches the bndr::Timer handles still scheduled in the service (they no longer fire afterwards)
+		~TimerService();
+		// schedule a timer that runs the callback after delay seconds (and every delay seconds after that if repeat is true)
+		TimerID schedule(float delay, std::function<void()>&& callback, bool repeat = false);
+		// schedule a timer without a callback, its id is queued when it fires (see drainFired)
+		TimerID schedule(float delay, bool repeat = false);
+		// cancel a timer, returns false if the id is stale (i.e. a one shot timer that already fired)
+		bool cancel(TimerID id);
+		// change the delay of a timer and restart it (the period of a repeating timer becomes the new delay)
+		bool reschedule(TimerID id, float delay);
+		// check if a timer is still scheduled
+		bool isActive(TimerID id) const;
+		// get the time in seconds until the timer fires (0.0f if the id is stale)
+		float getRemainingTime(TimerID id) const;
+		// advance the wheel by the passed time and fire every timer that is due (call this once per frame)
+		void advance(float deltaTime);
+		// call the handler with every queued fired id and empty the queue (call this once per frame)
+		void drainFired(const std::function<void(TimerID)>& handler);
+		// get the number of scheduled timers
+		inline int getActiveCount() const { return activeCount; }
+		// get the length of one tick in seconds
+		inline float getTickLength() const { return tickLength; }
+	};
+
+	// bndr::Timer
+	// Description: A countdown timer. A timer created with only an interval has to be advanced manually with countDown(),
+	// a timer created with a bndr::TimerService is a thin handle to a timer in the service, so it costs nothing per frame
+	// until timesUp() is polled
 	class BNDR_API Timer : protected Clock {
 		
 		// the time interval of the timer
 		float timeInterval;
 		// -1.0f denotes that the timer is stopped
 		float elapsedTime;
+		// the service that runs the timer (nullptr if the timer is advanced manually)
+		TimerService* service = nullptr;
+		TimerID id;
+
+		// copy the state of another timer (a timer in a service gets a node of its own in the same service)
+		void copyFrom(const Timer& timer);
+		// point the node of the timer back to this handle
+		void claimNode();
+
+		friend class TimerService;
 
 	public:
 
 		Timer(float interval) : Clock(), timeInterval(interval), elapsedTime(interval) {}
+		// bndr::Timer::Timer
+		// Arguments:
+		//        timerService = The service that advances the timer
+		//        interval = The time interval in seconds
+		//        repeat = Whether the timer starts over after firing
+		// Description: Schedules the timer in the service
+		Timer(TimerService& timerService, float interval, bool repeat = true);
+		// a copy continues from the state of the original (a copy of a timer in a service is scheduled in the same service
+		// and fires independently of the original)
+		Timer(const Timer& timer);
+		Timer(Timer&& timer) noexcept;
+		Timer& operator=(const Timer& timer);
+		Timer& operator=(Timer&& timer) noexcept;
 		// continues the timer count (resets it if timer has previously stopped or continues counting)
+		// (does nothing for timers in a TimerService since the service advances them)
 		void countDown(float deltaTime);
 		// returns true if the elapsed time is >= the time interval (i.e if time interval is 5.0f then after 5 seconds this will return true)
 		// if TimesUp returns true it automatically stops the timer (then the timer can reset once Tick is called)
 		bool timesUp();
 		// resets the time interval
 		void resetTimeInterval(float newInterval);
-		// get the elapsed time
-		float getElapsedTime() { return elapsedTime; }
+		// get the elapsed time (the remaining time for timers in a TimerService)
+		float getElapsedTime() { return (service == nullptr) ? elapsedTime : service->getRemainingTime(id); }
+		// bndr::Timer::~Timer
+		// Description: Cancels the timer in its service
+		~Timer();
 	};
 }
 
@@ -22,6 +22,13 @@ SOFTWARE.*/
 
 #include <pch.h>
 #include "window.h"
+#include "../profiling/gpu_profiler.h"
+#include "../data_structures/vectors.h"
+#include "gpu_objects/shader_reload.h"
+#include "gpu_objects/shader_variants.h"
+#include "gpu_objects/program_compiler.h"
+#include "gpu_objects/texture_streamer.h"
+#include "gpu_objects/texture_manager.h"
 
 namespace bndr {
 
@@ -150,11 +157,50 @@ namespace bndr {
 		// set viewport size
 		glViewport(0, 0, width, height);
 
+		// the state shadow starts out unknown for the new context
+		GLState::invalidate();
 		// enable blending
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		GLState::setBlending(true);
+		GLState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		// equation by default is add the two alpha values
-		glBlendEquation(GL_FUNC_ADD);
+		GLState::setBlendEquation(GL_FUNC_ADD);
+		// programs compile in the background from now on
+		ProgramCompiler::start(window);
+
+		// create the frame globals so surfaces drawn before the first update already see valid values
+		frameGlobalsBuffer = new UniformBuffer((int)sizeof(FrameGlobals), FRAME_GLOBALS_BINDING);
+		setView(0.0f, 0.0f);
+		updateFrameGlobals();
+	}
+
+	void Window::setView(float xTrans, float yTrans, float theta, float zoom) {
+
+		float rad = theta * (BNDR_PI / 180.0f);
+		float c = cosf(rad) * zoom;
+		float s = sinf(rad) * zoom;
+		// the mat3 is stored as three vec4 columns (std140)
+		float view[12] = {
+			c, s, 0.0f, 0.0f,
+			-s, c, 0.0f, 0.0f,
+			xTrans, yTrans, 1.0f, 0.0f
+		};
+		std::memcpy(frameGlobals.view, view, sizeof(view));
+	}
+
+	void Window::updateFrameGlobals() {
+
+		std::pair<float, float> size = getFramebufferSize();
+		// keep the previous size while the window is minimized (the framebuffer is 0 by 0)
+		if (size.first > 0.0f && size.second > 0.0f) {
+
+			frameGlobals.viewport[0] = size.first;
+			frameGlobals.viewport[1] = size.second;
+			frameGlobals.aspect = size.second / size.first;
+		}
+		frameGlobals.time = (float)glfwGetTime();
+		// one write per frame no matter how many programs read the globals
+		frameGlobalsBuffer->write(&frameGlobals, (int)sizeof(FrameGlobals));
+		frameGlobalsBuffer->bind();
 	}
 
 	void Window::setIcon(const char* bitMapFile) {
@@ -176,17 +222,35 @@ namespace bndr {
 
 	bool Window::update() {
 
+		BNDR_PROFILE_FRAME();
+		BNDR_PROFILE_GPU_FRAME();
+		BNDR_FLIGHT_SCOPE("Window::update");
 		pollEvents();
 
 		if (!isOpen() || (windowFlags & WINDOW_CLOSE)) {
 		
 			return false;
 		}
+		updateFrameGlobals();
+		// swap in shaders that were edited on disk (does nothing unless ShaderHotReload::start() was called)
+		ShaderHotReload::update();
+		// upload the rows of streamed textures that finished decoding (does nothing until a texture is requested)
+		TextureStreamer::update();
 		return true;
 	}
 
 	Window::~Window() {
 
+		// the gpu profiler queries belong to this context
+		GPUProfiler::shutdown();
+		ShaderHotReload::stop();
+		// the pixel buffers and the placeholder belong to this context
+		TextureStreamer::stop();
+		TextureManager::shutdown();
+		// the precompiled shader variants belong to this context
+		ShaderVariants::releasePrecompiled();
+		ProgramCompiler::stop();
+		delete frameGlobalsBuffer;
 		// destruct window
 		glfwDestroyWindow(window);
 		glfwTerminate();
@@ -24,6 +24,9 @@ SOFTWARE.*/
 
 #include <pch.h>
 #include "../event_objects/keyboard_mouse_events.h"
+#include "../profiling/flight_recorder.h"
+#include "gpu_objects/UniformBuffer.h"
+#include "gpu_objects/bitmap_loader.h"
 
 // typedef to hide glfw functionality in the BNDR API
 typedef GLFWwindow* screen;
@@ -63,6 +66,12 @@ namespace bndr {
 		static Queue<MouseEvent> mouseEvents;
 		// event queue for scroll events
 		static Queue<ScrollEvent> scrollEvents;
+		// state shared by every program (see BNDR_FRAME_GLOBALS_GLSL), written once per frame
+		FrameGlobals frameGlobals;
+		UniformBuffer* frameGlobalsBuffer = nullptr;
+
+		// refresh the frame globals from the framebuffer and clock, upload them and bind the buffer
+		void updateFrameGlobals();
 
 	public:
 
@@ -105,6 +114,11 @@ namespace bndr {
 		// sets the icon of the window
 		// the method expects a 24-bit bitmap image in Blue-Green-Red format
 		void setIcon(const char* bitMapFile);
+		// set the view transform applied to every surface (translation in GL coordinates, rotation in degrees, zoom about the origin)
+		// the change reaches the GPU with the next update()
+		void setView(float xTrans, float yTrans, float theta = 0.0f, float zoom = 1.0f);
+		// get the values of the frame globals as of the last update()
+		inline const FrameGlobals& getFrameGlobals() const { return frameGlobals; }
 		// get the aspect ratio
 		inline float getAspectRatio() {
 			std::pair<float, float> size = getSize();
@@ -130,83 +144,18 @@ namespace bndr {
 		// load an icon image
 		static GLFWimage loadIcon(const char* bitMapFile) {
 
-			std::ifstream bitMapBuffer(bitMapFile, std::ios::in | std::ios::binary);
-			// check if the file opened successfully
-			if (!bitMapBuffer.is_open()) {
-
-				std::string message = "Failed to open bit map file " + std::string("'") + std::string(bitMapFile) + std::string("'");
-				BNDR_EXCEPTION(message.c_str());
-			}
-			// read the header of the bitmap
-			uchar header[54];
-			bitMapBuffer.read(static_cast<char*>(static_cast<void*>(&header[0])), 54);
-
-			// check if the bitmap file starts with B and M
-			if (header[0] != (uchar)'B' || header[1] != (uchar)'M') {
-
-				std::string message = "The bitmap file " + std::string("'") + std::string(bitMapFile) + std::string("'") + " has an invalid file format";
-				BNDR_EXCEPTION(message.c_str());
-			}
-			// get the image size, width, and height
-			int width = *(int*)&header[0x12];
-			int height = *(int*)&header[0x16];
-
-			// define the appropriate size
-			int size = width * height * 3;
-			// if either the width or height is 0 raise an error
-			if (width == 0 || height == 0) { BNDR_EXCEPTION("Cannot read from a bitmap with a dimension of 0 pixels"); }
-
-			// create buffer for the image data
-			uchar* imageData = new uchar[size];
-			// now read the remaining image data
-			bitMapBuffer.read(static_cast<char*>(static_cast<void*>(imageData)), size);
-			bitMapBuffer.close();
-
-			// convert the image to rgba format
-			int rgbaSize = width * height * 4;
-			uchar* rgbaImage = new uchar[rgbaSize];
-			int j = 0;
-			for (int i = size - 3; i > -1; i -= 3) {
-
-				rgbaImage[j] = *(uchar*)&imageData[i + 2];
-				rgbaImage[j + 1] = *(uchar*)&imageData[i + 1];
-				rgbaImage[j + 2] = *(uchar*)&imageData[i];
-				rgbaImage[j + 3] = (uchar)255;
-				j += 4;
-			}
-			// delete the old image data
-			delete[] imageData;
-
-			// the image is right-side up but it's mirrored so fix it once more
-			for (int i = 0; i < rgbaSize; i += (width*4)) {
-
-				int k = i + (width*4) - 4;
-				int j = i;
-				while (true) {
-
-					uchar* firstBlock = &rgbaImage[j];
-					uchar* lastBlock = &rgbaImage[k];
-
-					// one by one swap each of the rgba components out
-					for (int n = 0; n < 4; n++) {
-
-						uchar tmp = firstBlock[n];
-						firstBlock[n] = lastBlock[n];
-						lastBlock[n] = tmp;
-					}
-					j += 4;
-					k -= 4;
-					if (j == k || abs(j - k) == 4) { break; }
-				}
-			}
-
-			return { width, height, rgbaImage };	
+			MappedBitMap bitMap(bitMapFile);
+			// glfw wants RGBA with the top row first
+			uchar* rgbaImage = new uchar[(size_t)bitMap.getWidth() * bitMap.getHeight() * 4];
+			bitMap.convertToRGBA(rgbaImage, true);
+			return { bitMap.getWidth(), bitMap.getHeight(), rgbaImage };
 		}
 
 		// key callback
 		static void keyEventCallback(screen window, int key, int scancode, int action, int mods) {
 
 			uint theKey = (uint)key;
+			FlightRecorder::recordInput(FLIGHT_INPUT_KEY, key, action, 0.0f, 0.0f);
 			Window::keyEvents.enqueue(std::move(KeyEvent(action, theKey)));
 		}
 		// mouse callback
@@ -215,6 +164,7 @@ namespace bndr {
 			uint theButton = (uint)button;
 			double x, y;
 			glfwGetCursorPos(window, &x, &y);
+			FlightRecorder::recordInput(FLIGHT_INPUT_MOUSE_BUTTON, button, action, (float)x, (float)y);
 			Window::mouseEvents.enqueue(std::move(MouseEvent(action, theButton, (float)x, (float)y)));
 		}
 		// scroll callback
@@ -222,6 +172,7 @@ namespace bndr {
 
 			double x, y;
 			glfwGetCursorPos(window, &x, &y);
+			FlightRecorder::recordInput(FLIGHT_INPUT_SCROLL, 0, 0, (float)x, (float)y, (float)yOff);
 			Window::scrollEvents.enqueue(std::move(ScrollEvent((float)x, (float)y, (float)yOff)));
 		}
 		// resize callback
@@ -34,6 +34,7 @@ SOFTWARE.*/
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <deque>
 #include <chrono>
 #include <fstream>
 #include <unordered_map>
@@ -41,6 +42,9 @@ SOFTWARE.*/
 #include <utility>
 #include <sstream>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <algorithm>
 #include <functional>
 #include "glew.h"